@@ -3,3 +3,82 @@
 
 #include "MyBlueprintFunctionLibrary.h"
 
+#include "SGComControlQueue.h"
+
+static SG_COM_EngineControl ToEngineControl(ESGEngineControl Control)
+{
+    switch (Control) {
+        case ESGEngineControl::Speed:
+            return SG_COM_CTRL_SPEED;
+        case ESGEngineControl::ExpressionFrequency:
+            return SG_COM_CTRL_EXPRESSION_FREQ;
+        case ESGEngineControl::Scale:
+        default:
+            return SG_COM_CTRL_SCALE;
+    };
+}
+
+static SG_COM_EngineRole ToEngineRole(ESGEngineRole Role)
+{
+    return Role == ESGEngineRole::Listen ? SG_COM_ROLE_LISTEN : SG_COM_ROLE_SPEAK;
+}
+
+void UMyBlueprintFunctionLibrary::SetEngineControl(int32 Avatar, ESGEngineControl Control, float Value)
+{
+    FSGComControlQueue::Get().SetEngineControl(Avatar, ToEngineControl(Control), Value);
+}
+
+void UMyBlueprintFunctionLibrary::SetMood(int32 Avatar, const FString& Mood)
+{
+    FSGComControlQueue::Get().SetMood(Avatar, Mood);
+}
+
+void UMyBlueprintFunctionLibrary::SetRole(int32 Avatar, ESGEngineRole Role)
+{
+    FSGComControlQueue::Get().SetRole(Avatar, ToEngineRole(Role));
+}
+
+// ========================================================
+// Set a control of many avatars in one call
+// ========================================================
+void UMyBlueprintFunctionLibrary::SetEngineControlBatch(const TArray<int32>& Avatars, ESGEngineControl Control, const TArray<float>& Values)
+{
+    if (Values.Num() != 1 && Values.Num() != Avatars.Num()) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : %d control values given for %d avatars"), Values.Num(), Avatars.Num());
+        return;
+    }
+
+    TArray<FSGComControlCommand> Commands;
+    Commands.SetNum(Avatars.Num());
+    for (int32 i = 0; i < Avatars.Num(); ++i) {
+        Commands[i].Type = FSGComControlCommand::EType::EngineControl;
+        Commands[i].Avatar = Avatars[i];
+        Commands[i].Control = ToEngineControl(Control);
+        Commands[i].Value = Values.Num() == 1 ? Values[0] : Values[i];
+    }
+    FSGComControlQueue::Get().Enqueue(Commands);
+}
+
+void UMyBlueprintFunctionLibrary::SetMoodBatch(const TArray<int32>& Avatars, const FString& Mood)
+{
+    TArray<FSGComControlCommand> Commands;
+    Commands.SetNum(Avatars.Num());
+    for (int32 i = 0; i < Avatars.Num(); ++i) {
+        Commands[i].Type = FSGComControlCommand::EType::Mood;
+        Commands[i].Avatar = Avatars[i];
+        Commands[i].Mood = Mood;
+    }
+    FSGComControlQueue::Get().Enqueue(Commands);
+}
+
+void UMyBlueprintFunctionLibrary::SetRoleBatch(const TArray<int32>& Avatars, ESGEngineRole Role)
+{
+    TArray<FSGComControlCommand> Commands;
+    Commands.SetNum(Avatars.Num());
+    for (int32 i = 0; i < Avatars.Num(); ++i) {
+        Commands[i].Type = FSGComControlCommand::EType::Role;
+        Commands[i].Avatar = Avatars[i];
+        Commands[i].Role = ToEngineRole(Role);
+    }
+    FSGComControlQueue::Get().Enqueue(Commands);
+}
@@ -0,0 +1,250 @@
+#include "SGComControlQueue.h"
+
+#include "Algo/Count.h"
+#include "Misc/ScopeLock.h"
+
+// ========================================================
+// Log a failed call with the exception text if any
+// ========================================================
+static void LogControlError(const TCHAR* What, SG_COM_Error err)
+{
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to set %s: %d"), What, err);
+    if (err == SG_COM_Error::SG_COM_ERROR_EXCEPTION) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM Exception] : %s"), *FString(SG_COM_GetExceptionText()));
+    }
+}
+
+bool FSGComControlQueue::FPending::IsEmpty() const
+{
+    for (const TOptional<float>& Control : Controls) {
+        if (Control.IsSet()) {
+            return false;
+        }
+    }
+    return !Mood.IsSet() && !Role.IsSet();
+}
+
+void FSGComControlQueue::FPending::Reset()
+{
+    for (TOptional<float>& Control : Controls) {
+        Control.Reset();
+    }
+    Mood.Reset();
+    Role.Reset();
+}
+
+void FSGComControlQueue::FPending::Merge(const FPending& Other)
+{
+    for (int32 i = 0; i < (int32)UE_ARRAY_COUNT(Controls); ++i) {
+        if (Other.Controls[i].IsSet()) {
+            Controls[i] = Other.Controls[i];
+        }
+    }
+    if (Other.Mood.IsSet()) {
+        Mood = Other.Mood;
+    }
+    if (Other.Role.IsSet()) {
+        Role = Other.Role;
+    }
+}
+
+// ========================================================
+// Get the queue shared by all engines
+// ========================================================
+FSGComControlQueue& FSGComControlQueue::Get()
+{
+    static FSGComControlQueue Queue;
+    return Queue;
+}
+
+// ========================================================
+// Route the commands for an avatar to an engine
+// ========================================================
+void FSGComControlQueue::RegisterAvatar(int32 Avatar, SG_COM_EngineHandle Engine)
+{
+    FScopeLock ScopeLock(&Lock);
+    FAvatar& Entry = Avatars.FindOrAdd(Avatar);
+    if (Entry.Engine != Engine) {
+        // A new Engine starts from its defaults, changes queued since win.
+        // Ramping controls carry on from where the old Engine was.
+        FPending Restored = Entry.Applied;
+        Restored.Merge(Entry.Pending);
+        Entry.Pending = Restored;
+        Entry.Applied.Reset();
+        Entry.bResync = Entry.Engine != nullptr;
+    }
+    Entry.Engine = Engine;
+}
+
+void FSGComControlQueue::UnregisterAvatar(int32 Avatar)
+{
+    FScopeLock ScopeLock(&Lock);
+    Avatars.Remove(Avatar);
+}
+
+// ========================================================
+// Spread every engine control change over a number of
+// ticks
+// ========================================================
+void FSGComControlQueue::SetRampTicks(int32 InRampTicks)
+{
+    FScopeLock ScopeLock(&Lock);
+    RampTicks = FMath::Max(0, InRampTicks);
+}
+
+// ========================================================
+// Queue a change
+// ========================================================
+void FSGComControlQueue::SetEngineControl(int32 Avatar, SG_COM_EngineControl Control, float Value)
+{
+    FSGComControlCommand Command;
+    Command.Type = FSGComControlCommand::EType::EngineControl;
+    Command.Avatar = Avatar;
+    Command.Control = Control;
+    Command.Value = Value;
+    Enqueue(MakeArrayView(&Command, 1));
+}
+
+void FSGComControlQueue::SetMood(int32 Avatar, const FString& Mood)
+{
+    FSGComControlCommand Command;
+    Command.Type = FSGComControlCommand::EType::Mood;
+    Command.Avatar = Avatar;
+    Command.Mood = Mood;
+    Enqueue(MakeArrayView(&Command, 1));
+}
+
+void FSGComControlQueue::SetRole(int32 Avatar, SG_COM_EngineRole Role)
+{
+    FSGComControlCommand Command;
+    Command.Type = FSGComControlCommand::EType::Role;
+    Command.Avatar = Avatar;
+    Command.Role = Role;
+    Enqueue(MakeArrayView(&Command, 1));
+}
+
+// ========================================================
+// Queue the changes for many avatars at once
+// ========================================================
+void FSGComControlQueue::Enqueue(TArrayView<const FSGComControlCommand> Commands)
+{
+    FScopeLock ScopeLock(&Lock);
+    for (const FSGComControlCommand& Command : Commands) {
+        Add(Command);
+    }
+}
+
+// ========================================================
+// Apply the changes queued for the avatars of an engine
+// ========================================================
+int32 FSGComControlQueue::Apply(SG_COM_EngineHandle Engine)
+{
+    if (!Engine) {
+        return 0;
+    }
+
+    // Take the changes so the engine calls are made without the lock
+    TArray<FPending, TInlineAllocator<4>> Changes;
+    {
+        FScopeLock ScopeLock(&Lock);
+        for (auto& Pair : Avatars) {
+            FAvatar& Entry = Pair.Value;
+            if (Entry.Engine != Engine) {
+                continue;
+            }
+
+            // Mood and role are applied at once, controls start ramping
+            FPending Change;
+            Change.Mood = Entry.Pending.Mood;
+            Change.Role = Entry.Pending.Role;
+            for (int32 i = 0; i < (int32)UE_ARRAY_COUNT(Entry.Ramps); ++i) {
+                FRamp& Ramp = Entry.Ramps[i];
+                if (Entry.Pending.Controls[i].IsSet()) {
+                    Ramp.Target = Entry.Pending.Controls[i].GetValue();
+                    Ramp.Step = FMath::Abs(Ramp.Target - Ramp.Current) / FMath::Max(1, RampTicks);
+                }
+
+                if (Ramp.Current != Ramp.Target) {
+                    Ramp.Current = Ramp.Target > Ramp.Current ? FMath::Min(Ramp.Current + Ramp.Step, Ramp.Target)
+                                                              : FMath::Max(Ramp.Current - Ramp.Step, Ramp.Target);
+                    Change.Controls[i] = Ramp.Current;
+                }
+                else if (Entry.bResync && Ramp.Current != 1.f) {
+                    Change.Controls[i] = Ramp.Current;
+                }
+            }
+            Entry.bResync = false;
+
+            Entry.Applied.Mood = Entry.Pending.Mood.IsSet() ? Entry.Pending.Mood : Entry.Applied.Mood;
+            Entry.Applied.Role = Entry.Pending.Role.IsSet() ? Entry.Pending.Role : Entry.Applied.Role;
+            Entry.Pending.Reset();
+
+            if (!Change.IsEmpty()) {
+                Changes.Add(MoveTemp(Change));
+            }
+        }
+    }
+
+    int32 NumApplied = 0;
+    for (const FPending& Pending : Changes) {
+        for (int32 i = 0; i < (int32)UE_ARRAY_COUNT(Pending.Controls); ++i) {
+            if (Pending.Controls[i].IsSet()) {
+                const SG_COM_Error err = SG_COM_SetEngineControl(Engine, (SG_COM_EngineControl)i, Pending.Controls[i].GetValue());
+                if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                    LogControlError(TEXT("engine control"), err);
+                }
+                NumApplied++;
+            }
+        }
+
+        if (Pending.Mood.IsSet()) {
+            const SG_COM_Error err = SG_COM_SetMood(Engine, TCHAR_TO_UTF8(*Pending.Mood.GetValue()));
+            if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                LogControlError(TEXT("mood"), err);
+            }
+            NumApplied++;
+        }
+
+        if (Pending.Role.IsSet()) {
+            const SG_COM_Error err = SG_COM_SetRole(Engine, Pending.Role.GetValue());
+            if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                LogControlError(TEXT("role"), err);
+            }
+            NumApplied++;
+        }
+    }
+
+    return NumApplied;
+}
+
+// ========================================================
+// Merge a command into the pending changes
+// ========================================================
+void FSGComControlQueue::Add(const FSGComControlCommand& Command)
+{
+    // Kept until the avatar registers
+    FAvatar* Entry = Avatars.Find(Command.Avatar);
+    if (!Entry) {
+        const int32 NumWaiting = Algo::CountIf(Avatars, [](const TPair<int32, FAvatar>& Pair) { return Pair.Value.Engine == nullptr; });
+        if (NumWaiting >= MaxWaitingAvatars) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : No engine for avatar %d, dropped"), Command.Avatar);
+            return;
+        }
+        Entry = &Avatars.Add(Command.Avatar);
+    }
+    FPending* Pending = &Entry->Pending;
+
+    switch (Command.Type) {
+        case FSGComControlCommand::EType::EngineControl:
+            if ((int32)Command.Control >= 0 && (int32)Command.Control < (int32)UE_ARRAY_COUNT(Pending->Controls)) {
+                Pending->Controls[Command.Control] = Command.Value;
+            }
+            break;
+        case FSGComControlCommand::EType::Mood:
+            Pending->Mood = Command.Mood;
+            break;
+        case FSGComControlCommand::EType::Role:
+            Pending->Role = Command.Role;
+            break;
+    }
+}
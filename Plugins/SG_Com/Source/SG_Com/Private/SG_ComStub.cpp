@@ -0,0 +1,431 @@
+// Stub of the SG_Com API for soak runs without the SG_Com binaries, built in
+// place of the library when SG_COM_STUB=1 is set for the build. Engines turn
+// every 10 ms of input, or of idle, into one frame of synthetic animation on
+// their local Player and broadcast its time to remote Players.
+
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+#if SG_COM_STUB
+
+// Duration of one engine frame
+static const double StubFrameMs = 10.0;
+
+// Animation nodes of the stub character: a joint, a blendshape and an other node
+static const char* StubJointChannels[] = { "tx", "ty", "tz", "rx", "ry", "rz", "sx", "sy", "sz" };
+static const char* StubBlendshapeChannels[] = { "jaw_open", "eye_blink_L", "eye_blink_R" };
+static const char* StubOtherChannels[] = { "jawOpen", "mouthClose" };
+
+struct SG_COM_Player
+{
+    FCriticalSection Lock;
+    double BufferMs = 0.0;
+    double MinTimeMs = 0.0;
+    double MaxTimeMs = 0.0;
+    double TimeMs = 0.0;
+
+    TArray<SG_AnimationNode> Nodes;
+    TArray<float> Values;
+
+    // Add one frame at the end of the playable range, dropping the oldest
+    // beyond the buffer
+    void AddFrame(double EndTimeMs)
+    {
+        FScopeLock ScopeLock(&Lock);
+        MaxTimeMs = FMath::Max(MaxTimeMs, EndTimeMs);
+        MinTimeMs = FMath::Max(MinTimeMs, MaxTimeMs - BufferMs);
+    }
+};
+
+struct SG_COM_Engine
+{
+    FCriticalSection Lock;
+    SG_COM_EngineConfig Config;
+    int32 FrameBytes = 0;
+    int64 CapacityBytes = 0;
+    int64 BufferedBytes = 0;
+    double TimeMs = 0.0;
+    bool bTicking = false;
+    SG_COM_EngineRole Role = SG_COM_ROLE_SPEAK;
+    FString Mood = TEXT("neutral");
+    float Controls[3] = { 1.f, 1.f, 1.f };
+};
+
+static FCriticalSection StubLock;
+static bool bStubInitialized = false;
+static SG_LoggingCallback StubLoggingCallback = nullptr;
+
+static void StubLog(const char* Message)
+{
+    if (StubLoggingCallback) {
+        StubLoggingCallback(Message);
+    }
+}
+
+static int32 GetStubBytesPerSample(SG_AudioSampleType SampleType)
+{
+    return SampleType == SG_AUDIO_INT_16 ? 2 : 4;
+}
+
+static void AddStubNode(SG_COM_Player* Player, const char* Name, SG_AnimationNodeType Type, const char** ChannelNames, sg_size NumChannels)
+{
+    SG_AnimationNode Node;
+    Node.name = Name;
+    Node.type = Type;
+    Node.num_channels = NumChannels;
+    Node.channel_names = ChannelNames;
+    Node.channel_values = nullptr;
+    Player->Nodes.Add(Node);
+}
+
+extern "C" {
+
+const char* SG_COM_GetExceptionText(void)
+{
+    return "SG_Com stub";
+}
+
+SG_COM_Error SG_COM_Initialize(SG_LoggingLevel logging_level, SG_LoggingCallback logging_callback, const char* license_data, const char* license_unique_id, const char* license_custom_data)
+{
+    FScopeLock ScopeLock(&StubLock);
+    bStubInitialized = true;
+    StubLoggingCallback = logging_callback;
+    StubLog("SG_Com stub initialized");
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_Shutdown(void)
+{
+    FScopeLock ScopeLock(&StubLock);
+    bStubInitialized = false;
+    StubLoggingCallback = nullptr;
+    return SG_COM_ERROR_OK;
+}
+
+const char* SG_COM_GetVersionString(void)
+{
+    return "0.0.0-stub";
+}
+
+unsigned int SG_COM_GetVersionNumber(void)
+{
+    return 0;
+}
+
+SG_COM_Error SG_COM_CreateEngine(const SG_COM_EngineConfig* engine_config, SG_COM_EngineHandle* engine_handle)
+{
+    if (!engine_config || !engine_handle || engine_config->buffer_sec <= 0.f) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+    if (!bStubInitialized) {
+        return SG_COM_ERROR_INVALID_LICENSE;
+    }
+
+    SG_COM_Engine* Engine = new SG_COM_Engine();
+    Engine->Config = *engine_config;
+    const int32 BytesPerSecond = get_audio_sample_rate(engine_config->audio_sample_rate) * GetStubBytesPerSample(engine_config->audio_sample_type);
+    Engine->FrameBytes = (int32)(BytesPerSecond * StubFrameMs / 1000.0);
+    Engine->CapacityBytes = (int64)(BytesPerSecond * engine_config->buffer_sec);
+    *engine_handle = Engine;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_DestroyEngine(SG_COM_EngineHandle engine_handle)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    delete engine_handle;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_InputAudio(SG_COM_EngineHandle engine_handle, const void* data, sg_size data_bytes)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!data && data_bytes > 0) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    if (engine_handle->BufferedBytes + data_bytes > engine_handle->CapacityBytes) {
+        return SG_COM_ERROR_INPUT_OVERRUN;
+    }
+    engine_handle->BufferedBytes += data_bytes;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_InputAuxData(SG_COM_EngineHandle engine_handle, const void* data, sg_size data_bytes)
+{
+    return engine_handle ? SG_COM_ERROR_NOT_IMPLEMENTED : SG_COM_ERROR_INVALID_HANDLE;
+}
+
+SG_COM_Error SG_COM_ProcessTick(SG_COM_EngineHandle engine_handle, int* processed_frames, int* remaining_frames)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+
+    double EndTimeMs = 0.0;
+    int32 NumProcessed = 0;
+    {
+        FScopeLock ScopeLock(&engine_handle->Lock);
+        if (engine_handle->bTicking) {
+            return SG_COM_ERROR_TICK_IN_PROGRESS;
+        }
+
+        // Idle frames are produced once the input runs out, if enabled
+        const bool bInput = engine_handle->BufferedBytes >= engine_handle->FrameBytes;
+        if (bInput || (engine_handle->Config.flag & SG_COM_ENGINE_CONFIG_ENABLE_IDLE)) {
+            engine_handle->BufferedBytes -= bInput ? engine_handle->FrameBytes : 0;
+            engine_handle->TimeMs += StubFrameMs;
+            NumProcessed = 1;
+        }
+        EndTimeMs = engine_handle->TimeMs;
+        engine_handle->bTicking = NumProcessed > 0;
+
+        if (remaining_frames) {
+            *remaining_frames = engine_handle->FrameBytes > 0 ? (int)(engine_handle->BufferedBytes / engine_handle->FrameBytes) : 0;
+        }
+    }
+    if (processed_frames) {
+        *processed_frames = NumProcessed;
+    }
+    if (NumProcessed == 0) {
+        return SG_COM_ERROR_OK;
+    }
+
+    // The frame reaches the local Player directly and remote Players as a packet
+    const SG_COM_EngineConfig& Config = engine_handle->Config;
+    if (Config.local_player) {
+        Config.local_player->AddFrame(EndTimeMs);
+    }
+    if (Config.engine_broadcast_callback) {
+        Config.engine_broadcast_callback(engine_handle, (char*)&EndTimeMs, sizeof(EndTimeMs), Config.custom_engine_data);
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    engine_handle->bTicking = false;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_Reset(SG_COM_EngineHandle engine_handle)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    engine_handle->BufferedBytes = 0;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_SetMood(SG_COM_EngineHandle engine_handle, const char* mood)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!mood) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    engine_handle->Mood = UTF8_TO_TCHAR(mood);
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetMood(SG_COM_EngineHandle engine_handle, char* mood, sg_size buffersize)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    const FTCHARToUTF8 Mood(*engine_handle->Mood);
+    if (!mood || buffersize <= (sg_size)Mood.Length()) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+    FMemory::Memcpy(mood, Mood.Get(), Mood.Length() + 1);
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetMoodList(SG_COM_EngineHandle engine_handle, char* mood_list, sg_size buffersize)
+{
+    static const char MoodList[] = "neutral,positive,negative";
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!mood_list || buffersize < sizeof(MoodList)) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+    FMemory::Memcpy(mood_list, MoodList, sizeof(MoodList));
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_SetRole(SG_COM_EngineHandle engine_handle, SG_COM_EngineRole role)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    engine_handle->Role = role;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetRole(SG_COM_EngineHandle engine_handle, SG_COM_EngineRole* role)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!role) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    *role = engine_handle->Role;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetEngineControl(SG_COM_EngineHandle engine_handle, SG_COM_EngineControl engine_control, float* value)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!value || engine_control < SG_COM_CTRL_SCALE || engine_control > SG_COM_CTRL_EXPRESSION_FREQ) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    *value = engine_handle->Controls[engine_control];
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_SetEngineControl(SG_COM_EngineHandle engine_handle, SG_COM_EngineControl engine_control, float value)
+{
+    if (!engine_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (engine_control < SG_COM_CTRL_SCALE || engine_control > SG_COM_CTRL_EXPRESSION_FREQ) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&engine_handle->Lock);
+    engine_handle->Controls[engine_control] = value;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_CreatePlayer(const SG_COM_PlayerConfig* player_config, SG_COM_PlayerHandle* player_handle)
+{
+    if (!player_config || !player_handle || player_config->buffer_sec <= 0.f) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    SG_COM_Player* Player = new SG_COM_Player();
+    Player->BufferMs = player_config->buffer_sec * 1000.0;
+    AddStubNode(Player, "head", SG_JOINT, StubJointChannels, UE_ARRAY_COUNT(StubJointChannels));
+    AddStubNode(Player, "head_lod0_mesh", SG_BLENDSHAPE, StubBlendshapeChannels, UE_ARRAY_COUNT(StubBlendshapeChannels));
+    AddStubNode(Player, "CTRL_expressions", SG_OTHER_ANIMATION_NODE, StubOtherChannels, UE_ARRAY_COUNT(StubOtherChannels));
+
+    // Channel values are laid out in node order, joints at rest with unit scale
+    int32 NumChannels = 0;
+    for (const SG_AnimationNode& Node : Player->Nodes) {
+        NumChannels += Node.num_channels;
+    }
+    Player->Values.SetNumZeroed(NumChannels);
+    Player->Values[6] = Player->Values[7] = Player->Values[8] = 1.f;
+
+    float* Values = Player->Values.GetData();
+    for (SG_AnimationNode& Node : Player->Nodes) {
+        Node.channel_values = Values;
+        Values += Node.num_channels;
+    }
+
+    *player_handle = Player;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_DestroyPlayer(SG_COM_PlayerHandle player_handle)
+{
+    if (!player_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    delete player_handle;
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_ReceivePacket(SG_COM_PlayerHandle player_handle, const char* packet, sg_size packet_bytes)
+{
+    if (!player_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!packet || packet_bytes != sizeof(double)) {
+        return SG_COM_ERROR_INVALID_PACKET;
+    }
+
+    double EndTimeMs = 0.0;
+    FMemory::Memcpy(&EndTimeMs, packet, sizeof(EndTimeMs));
+    player_handle->AddFrame(EndTimeMs);
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetAnimationNodes(SG_COM_PlayerHandle player_handle, SG_AnimationNode** animation_nodes, sg_size* num_animation_nodes)
+{
+    if (!player_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!animation_nodes || !num_animation_nodes) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    *animation_nodes = player_handle->Nodes.GetData();
+    *num_animation_nodes = player_handle->Nodes.Num();
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_UpdateAnimation(SG_COM_PlayerHandle player_handle, double time_ms, double* current_time_ms)
+{
+    if (!player_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+
+    FScopeLock ScopeLock(&player_handle->Lock);
+    const double TimeMs = FMath::Clamp(time_ms, player_handle->MinTimeMs, player_handle->MaxTimeMs);
+    player_handle->TimeMs = TimeMs;
+    if (current_time_ms) {
+        *current_time_ms = TimeMs;
+    }
+
+    // A slow nod, a talking jaw and a blink every few seconds
+    const float Seconds = (float)(TimeMs / 1000.0);
+    float* Values = player_handle->Values.GetData();
+    Values[3] = 2.f * FMath::Sin(Seconds * 0.7f);
+    Values[9] = 0.5f + 0.5f * FMath::Sin(Seconds * 12.f);
+    Values[10] = Values[11] = FMath::Fmod(Seconds, 4.f) < 0.15f ? 1.f : 0.f;
+    Values[12] = Values[9];
+    Values[13] = 1.f - Values[9];
+    return SG_COM_ERROR_OK;
+}
+
+SG_COM_Error SG_COM_GetPlayableRange(SG_COM_PlayerHandle player_handle, double* min_time_ms, double* max_time_ms)
+{
+    if (!player_handle) {
+        return SG_COM_ERROR_INVALID_HANDLE;
+    }
+    if (!min_time_ms || !max_time_ms) {
+        return SG_COM_ERROR_INVALID_PARAM;
+    }
+
+    FScopeLock ScopeLock(&player_handle->Lock);
+    *min_time_ms = player_handle->MinTimeMs;
+    *max_time_ms = player_handle->MaxTimeMs;
+    return SG_COM_ERROR_OK;
+}
+
+} // extern "C"
+
+#endif // SG_COM_STUB
@@ -6,12 +6,51 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "MyBlueprintFunctionLibrary.generated.h"
 
+// Engine controls, see SG_COM_EngineControl
+UENUM(BlueprintType)
+enum class ESGEngineControl : uint8
+{
+    Scale,              // Scale factor of muscle motion
+    Speed,              // Speed factor of muscle motion
+    ExpressionFrequency // Frequency of expression change
+};
+
+// Engine roles, see SG_COM_EngineRole
+UENUM(BlueprintType)
+enum class ESGEngineRole : uint8
+{
+    Speak,
+    Listen
+};
+
 /**
- * 
+ * Sets the controls, mood and role of the avatars' engines. Changes are
+ * queued and applied between engine ticks, so these never wait for a tick.
  */
 UCLASS()
 class SG_COM_API UMyBlueprintFunctionLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
-	
+
+public:
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetEngineControl(int32 Avatar, ESGEngineControl Control, float Value);
+
+    // The mood must be one of the character setup, or "auto"
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetMood(int32 Avatar, const FString& Mood);
+
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetRole(int32 Avatar, ESGEngineRole Role);
+
+    // Set a control of many avatars in one call, Values holds one value per
+    // avatar or a single value for all of them
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetEngineControlBatch(const TArray<int32>& Avatars, ESGEngineControl Control, const TArray<float>& Values);
+
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetMoodBatch(const TArray<int32>& Avatars, const FString& Mood);
+
+    UFUNCTION(BlueprintCallable, Category = "SG_Com")
+    static void SetRoleBatch(const TArray<int32>& Avatars, ESGEngineRole Role);
 };
@@ -0,0 +1,108 @@
+// Engine controls, moods and roles set from any thread and applied to the
+// engines between their ticks
+
+#pragma once
+
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Optional.h"
+
+// A control, mood or role change for one avatar
+struct FSGComControlCommand
+{
+    enum class EType : uint8
+    {
+        EngineControl,
+        Mood,
+        Role
+    };
+
+    EType Type = EType::EngineControl;
+    int32 Avatar = 0;
+    SG_COM_EngineControl Control = SG_COM_CTRL_SCALE;
+    float Value = 1.f;
+    SG_COM_EngineRole Role = SG_COM_ROLE_SPEAK;
+    FString Mood;
+};
+
+class SG_COM_API FSGComControlQueue
+{
+public:
+    static FSGComControlQueue& Get();
+
+    // Route the commands for Avatar to Engine. Commands queued before the
+    // avatar registered are applied once it does. When the avatar moves to a
+    // new Engine, the controls, mood and role applied to the old one are
+    // applied to the new one too.
+    void RegisterAvatar(int32 Avatar, SG_COM_EngineHandle Engine);
+    void UnregisterAvatar(int32 Avatar);
+
+    // Spread every engine control change over RampTicks ticks, changing the
+    // control linearly from its current value. 0 applies changes at once.
+    void SetRampTicks(int32 RampTicks);
+
+    // Queue a change, never waiting for a tick in progress
+    void SetEngineControl(int32 Avatar, SG_COM_EngineControl Control, float Value);
+    void SetMood(int32 Avatar, const FString& Mood);
+    void SetRole(int32 Avatar, SG_COM_EngineRole Role);
+
+    // Queue the changes for many avatars at once
+    void Enqueue(TArrayView<const FSGComControlCommand> Commands);
+
+    // Apply the changes queued for the avatars of Engine, and the next step
+    // of the controls still ramping. Only the latest value of each control,
+    // the mood and the role is applied. Called on the thread ticking Engine,
+    // once before every tick. Returns the number of changes applied.
+    int32 Apply(SG_COM_EngineHandle Engine);
+
+private:
+    // Latest value of each control, the mood and the role of one avatar
+    struct FPending
+    {
+        TOptional<float> Controls[SG_COM_CTRL_EXPRESSION_FREQ + 1];
+        TOptional<FString> Mood;
+        TOptional<SG_COM_EngineRole> Role;
+
+        bool IsEmpty() const;
+        void Reset();
+
+        // Take the values set in Other
+        void Merge(const FPending& Other);
+    };
+
+    // A control moving towards its target by Step every tick
+    struct FRamp
+    {
+        float Current = 1.f;
+        float Target = 1.f;
+        float Step = 0.f;
+    };
+
+    struct FAvatar
+    {
+        // Null until the avatar registers
+        SG_COM_EngineHandle Engine = nullptr;
+
+        // Changes not applied yet, and the mood and role applied to the Engine
+        FPending Pending;
+        FPending Applied;
+
+        // Engine controls, all at their default of 1 on a new Engine
+        FRamp Ramps[SG_COM_CTRL_EXPRESSION_FREQ + 1];
+
+        // Set every control to its current value on the next Apply
+        bool bResync = false;
+    };
+
+    // Merge a command into the pending changes, called with the lock held
+    void Add(const FSGComControlCommand& Command);
+
+    FCriticalSection Lock;
+    TMap<int32, FAvatar> Avatars;
+    int32 RampTicks = 0;
+
+    // Unregistered avatars with commands waiting, beyond this they are dropped
+    static constexpr int32 MaxWaitingAvatars = 64;
+};
@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System;
 using System.IO;
 using UnrealBuildTool;
 
@@ -51,7 +52,16 @@ public class SG_Com : ModuleRules
             }
             );
 
-        if (Target.Platform == UnrealTargetPlatform.Win64) {
+        // Soak runs without the SG_Com binaries build the stub of the API in
+        // Private/SG_ComStub.cpp instead, set SG_COM_STUB=1 for the build
+        bool bStub = Environment.GetEnvironmentVariable("SG_COM_STUB") == "1";
+        PublicDefinitions.Add("SG_COM_STUB=" + (bStub ? "1" : "0"));
+
+        if (bStub) {
+            // SG_DYN exports the stubbed API from this module, nothing to link or stage
+            PrivateDefinitions.Add("BUILDING_DLL=1");
+        }
+        else if (Target.Platform == UnrealTargetPlatform.Win64) {
             string dll_path = Path.Combine(PluginDirectory, "Binaries/Win64/SG_Com.dll");
             string lib_path = Path.Combine(PluginDirectory, "Binaries/Win64/SG_Com.lib");
             PublicDelayLoadDLLs.Add(dll_path);
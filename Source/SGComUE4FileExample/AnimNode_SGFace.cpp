@@ -0,0 +1,97 @@
+#include "AnimNode_SGFace.h"
+
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+
+// ========================================================
+// Initialize the input pose, the animation nodes are
+// fetched and bound again for the new skeleton
+// ========================================================
+void FAnimNode_SGFace::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+    FAnimNode_Base::Initialize_AnyThread(Context);
+    Source.Initialize(Context);
+
+    Face.Reset();
+    ActualAlpha = 0.f;
+    bApply = false;
+}
+
+// ========================================================
+// Try to bind the animation nodes before the first
+// evaluation. Binding fails until the session loaded the
+// binding cache, Update_AnyThread binds them then. The
+// binding is kept across LOD changes since the node
+// kernels skip the bones missing from the current LOD
+// ========================================================
+void FAnimNode_SGFace::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+    Source.CacheBones(Context);
+    Face.UpdateBinding(PlayerIndex, Context.AnimInstanceProxy->GetSkeleton(), Context.AnimInstanceProxy->GetSkelMeshComponent());
+}
+
+// ========================================================
+// Update the exposed inputs and the binding, which only
+// changes when the Player or its nodes changed
+// ========================================================
+void FAnimNode_SGFace::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+    // Pins bound to members are copied on the fast path
+    GetEvaluateGraphExposedInputs().Execute(Context);
+    Source.Update(Context);
+
+    ActualAlpha = FMath::Clamp(Alpha, 0.f, 1.f);
+    DeltaSeconds = Context.GetDeltaTime();
+    bApply = FAnimWeight::IsRelevant(ActualAlpha) && IsLODEnabled(Context.AnimInstanceProxy)
+          && Face.UpdateBinding(PlayerIndex, Context.AnimInstanceProxy->GetSkeleton(), Context.AnimInstanceProxy->GetSkelMeshComponent());
+}
+
+// ========================================================
+// Set the morph targets without a curve on the game
+// thread, from the values of the last evaluation
+// ========================================================
+void FAnimNode_SGFace::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+    Face.ApplyMorphTargets(InAnimInstance->GetSkelMeshComponent());
+}
+
+// ========================================================
+// Apply the animation nodes on top of the input pose
+// ========================================================
+void FAnimNode_SGFace::Evaluate_AnyThread(FPoseContext& Output)
+{
+    Source.Evaluate(Output);
+    if (!bApply) {
+        return;
+    }
+
+    USkeletalMeshComponent* Mesh = Output.AnimInstanceProxy->GetSkelMeshComponent();
+    if (FAnimWeight::IsFullWeight(ActualAlpha)) {
+        Face.Apply(Output, Mesh, DeltaSeconds);
+        return;
+    }
+
+    // Applied to Output and blended back towards one copy of the input pose.
+    // Morph targets without a curve are scaled by the alpha instead.
+    FPoseContext SourcePose(Output);
+    SourcePose.Pose.CopyBonesFrom(Output.Pose);
+    SourcePose.Curve.CopyFrom(Output.Curve);
+    if (!Face.Apply(Output, Mesh, DeltaSeconds, ActualAlpha)) {
+        return;
+    }
+
+    const float SourceWeight = 1.f - ActualAlpha;
+    for (const FCompactPoseBoneIndex BoneIndex : Output.Pose.ForEachBoneIndex()) {
+        Output.Pose[BoneIndex].BlendWith(SourcePose.Pose[BoneIndex], SourceWeight);
+    }
+    Output.Curve.LerpTo(SourcePose.Curve, SourceWeight);
+}
+
+void FAnimNode_SGFace::GatherDebugData(FNodeDebugData& DebugData)
+{
+    FString DebugLine = DebugData.GetNodeName(this);
+    DebugLine += FString::Printf(TEXT("(Alpha: %.1f%% Player: %d Bound: %s)"), ActualAlpha * 100.f, PlayerIndex, Face.IsBound() ? TEXT("true") : TEXT("false"));
+    DebugData.AddDebugItem(DebugLine);
+
+    Source.GatherDebugData(DebugData.BranchFlow(1.f));
+}
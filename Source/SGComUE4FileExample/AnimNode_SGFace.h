@@ -0,0 +1,51 @@
+// AnimGraph node applying SG animation data on top of its input pose, so the
+// face is evaluated with the body animation in a single graph
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "SGFaceEvaluator.h"
+#include "AnimNode_SGFace.generated.h"
+
+USTRUCT(BlueprintInternalUseOnly)
+struct SGCOMUE4FILEEXAMPLE_API FAnimNode_SGFace : public FAnimNode_Base
+{
+    GENERATED_BODY()
+
+    // Pose the SG animation data is applied to
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Links)
+    FPoseLink Source;
+
+    // Weight of the SG animation data over the input pose
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinShownByDefault))
+    float Alpha = 1.f;
+
+    // Player of the engine this avatar shows, 0 for the local player and
+    // 1 to FanOutPlayers for the players fed its broadcast packets
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault))
+    int32 PlayerIndex = 0;
+
+    // Highest LOD the SG animation data is applied at, every LOD when -1
+    UPROPERTY(EditAnywhere, Category = Performance, meta = (DisplayName = "LOD Threshold"))
+    int32 LODThreshold = INDEX_NONE;
+
+    // FAnimNode_Base interface
+    virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+    virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+    virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+    virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+    virtual bool HasPreUpdate() const override { return true; }
+    virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+    virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+    virtual int32 GetLODThreshold() const override { return LODThreshold; }
+
+private:
+    // Animation nodes of the Player and their binding to the skeleton
+    FSGFaceEvaluator Face;
+
+    // Alpha and LOD check of the last update, used by the evaluation
+    float ActualAlpha = 0.f;
+    bool bApply = false;
+    float DeltaSeconds = 0.f;
+};
@@ -5,25 +5,25 @@
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
 #include "Animation/AnimInstanceProxy.h"
-#include "CommonStructs.h"
+#include "SGFaceEvaluator.h"
 #include "SGAnimInstance.generated.h"
 
-struct SGAnimationNodes {
-    SG_AnimationNode* Nodes = nullptr;
-    sg_size NumNodes = 0;
-};
-
 class USGAnimInstance;
 struct FSGAnimInstanceProxy : public FAnimInstanceProxy
 {
 	FSGAnimInstanceProxy() : FAnimInstanceProxy(), SGAnimInstance(nullptr) { UE_LOG(LogTemp, Warning, TEXT("FSGAnimInstanceProxy::Constructor 1")); }
 	FSGAnimInstanceProxy(UAnimInstance* Instance) : FAnimInstanceProxy(Instance), SGAnimInstance(nullptr) { UE_LOG(LogTemp, Warning, TEXT("FSGAnimInstanceProxy::Constructor 2")); }
     
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
 	virtual bool Evaluate(FPoseContext& Output) override;
 
 	USGAnimInstance* SGAnimInstance;
 
-    SGAnimationNodes AnimationNodes;
+    // Player of the engine this avatar shows, copied from the anim instance
+    int32 PlayerIndex = 0;
+
+    // Animation nodes of the Player and their binding to the skeleton
+    FSGFaceEvaluator Face;
 };
 
 
@@ -35,6 +35,15 @@ class SGCOMUE4FILEEXAMPLE_API USGAnimInstance : public UAnimInstance
 public:
     USGAnimInstance(const FObjectInitializer& ObjectInitializer);
 
+    // Player of the engine this avatar shows, 0 for the local player and
+    // 1 to FanOutPlayers for the players fed its broadcast packets
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SG_Com")
+    int32 PlayerIndex = 0;
+
+    // Baked animation already holds the output of the rig logic, so the rig
+    // logic in the post-process blueprint of the mesh is bypassed
+    virtual void NativeInitializeAnimation() override;
+
 private:
     FAnimInstanceProxy* CreateAnimInstanceProxy() override { return& Proxy; }
     virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
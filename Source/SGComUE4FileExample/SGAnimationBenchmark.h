@@ -0,0 +1,29 @@
+// Times the whole animation evaluation of an avatar with the rig logic in its
+// post-process animation blueprint running and bypassed
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkeletalMeshComponent;
+
+// Average cost of one frame of animation update and evaluation
+struct FSGAnimationBenchmarkResult
+{
+    int32 NumFrames = 0;
+    double RigLogicUs = 0.0;
+    double BypassedUs = 0.0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGAnimationBenchmark
+{
+public:
+    // Update and evaluate Mesh NumFrames times with the post-process
+    // animation blueprint enabled, then NumFrames times with it disabled.
+    // Runs on the game thread and restores the post-process state.
+    static bool Run(USkeletalMeshComponent* Mesh, int32 NumFrames, FSGAnimationBenchmarkResult& OutResult);
+
+private:
+    // Average microseconds of one frame of update and evaluation
+    static double TimeFrames(USkeletalMeshComponent* Mesh, int32 NumFrames);
+};
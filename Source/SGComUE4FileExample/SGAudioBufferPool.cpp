@@ -0,0 +1,130 @@
+#include "SGAudioBufferPool.h"
+
+#include "Misc/ScopeLock.h"
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGAudioBufferPool::~FSGAudioBufferPool()
+{
+    for (FSGAudioBlock* Block : FreeBlocks) {
+        delete Block;
+    }
+}
+
+// ========================================================
+// Set the block size and the budget for all blocks
+// ========================================================
+void FSGAudioBufferPool::Configure(int32 InBlockBytes, int64 InBudgetBytes)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (InBlockBytes != BlockBytes) {
+        for (FSGAudioBlock* Block : FreeBlocks) {
+            AllocatedBytes -= Block->Capacity;
+            delete Block;
+        }
+        FreeBlocks.Reset();
+    }
+
+    BlockBytes = InBlockBytes;
+    BudgetBytes = InBudgetBytes;
+}
+
+// ========================================================
+// Get an empty block
+// ========================================================
+FSGAudioBlock* FSGAudioBufferPool::Acquire()
+{
+    FScopeLock ScopeLock(&Lock);
+
+    FSGAudioBlock* Block = nullptr;
+    if (FreeBlocks.Num() > 0) {
+        Block = FreeBlocks.Pop(false);
+    }
+    else {
+        if (BlockBytes <= 0 || AllocatedBytes + BlockBytes > BudgetBytes) {
+            return nullptr;
+        }
+
+        Block = new FSGAudioBlock();
+        Block->Data.Reserve(BlockBytes);
+        Block->Capacity = BlockBytes;
+        AllocatedBytes += BlockBytes;
+    }
+
+    InUseBytes += Block->Capacity;
+    return Block;
+}
+
+// ========================================================
+// Return a block to the pool
+// ========================================================
+void FSGAudioBufferPool::Release(FSGAudioBlock* Block)
+{
+    if (!Block) {
+        return;
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    InUseBytes -= Block->Capacity;
+
+    // Blocks from before the pool was reconfigured are not reused
+    if (Block->Capacity != BlockBytes) {
+        AllocatedBytes -= Block->Capacity;
+        delete Block;
+        return;
+    }
+
+    Block->Data.Reset();
+    Block->bUtteranceStart = false;
+    Block->bUtteranceEnd = false;
+    FreeBlocks.Push(Block);
+}
+
+// ========================================================
+// Read spans of audio in order as one stream
+// ========================================================
+FSGAudioSpanReader::FSGAudioSpanReader(TArrayView<const TArrayView<const uint8>> InSpans)
+    : Spans(InSpans)
+{
+    for (const TArrayView<const uint8>& Span : Spans) {
+        TotalBytes += Span.Num();
+    }
+}
+
+int32 FSGAudioSpanReader::Read(TArray<uint8>& OutData, int32 MaxBytes)
+{
+    int32 NumRead = 0;
+    while (NumRead < MaxBytes && SpanIndex < Spans.Num()) {
+        const TArrayView<const uint8>& Span = Spans[SpanIndex];
+        const int32 NumBytes = FMath::Min(Span.Num() - SpanOffset, MaxBytes - NumRead);
+        OutData.Append(Span.GetData() + SpanOffset, NumBytes);
+        NumRead += NumBytes;
+        SpanOffset += NumBytes;
+        if (SpanOffset >= Span.Num()) {
+            SpanIndex++;
+            SpanOffset = 0;
+        }
+    }
+    ReadBytes += NumRead;
+    return NumRead;
+}
+
+int32 FSGAudioBufferPool::GetBlockBytes() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return BlockBytes;
+}
+
+int64 FSGAudioBufferPool::GetAllocatedBytes() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return AllocatedBytes;
+}
+
+int64 FSGAudioBufferPool::GetInUseBytes() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return InUseBytes;
+}
@@ -0,0 +1,76 @@
+// Pool of fixed size PCM blocks reused across utterances
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// A block of PCM audio data. Data.Num() is the number of valid bytes.
+struct FSGAudioBlock
+{
+    TArray<uint8> Data;
+
+    // Number of bytes the block can hold, fixed by the pool
+    int32 Capacity = 0;
+
+    // Utterance the block belongs to, and if it is the first or last of it
+    uint32 Utterance = 0;
+    bool bUtteranceStart = false;
+    bool bUtteranceEnd = false;
+};
+
+// Reads a list of audio buffers in order as one stream, so they are copied
+// into blocks without being joined into one contiguous buffer first
+struct SGCOMUE4FILEEXAMPLE_API FSGAudioSpanReader
+{
+    explicit FSGAudioSpanReader(TArrayView<const TArrayView<const uint8>> InSpans);
+
+    // Append up to MaxBytes of the next audio to OutData. Returns the number
+    // of bytes appended.
+    int32 Read(TArray<uint8>& OutData, int32 MaxBytes);
+
+    int64 GetTotalBytes() const { return TotalBytes; }
+    int64 GetRemainingBytes() const { return TotalBytes - ReadBytes; }
+
+private:
+    TArrayView<const TArrayView<const uint8>> Spans;
+    int32 SpanIndex = 0;
+    int32 SpanOffset = 0;
+    int64 TotalBytes = 0;
+    int64 ReadBytes = 0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGAudioBufferPool
+{
+public:
+    FSGAudioBufferPool() {};
+    ~FSGAudioBufferPool();
+
+    // Set the block size and the budget for all blocks. Free blocks of a
+    // different size are released.
+    void Configure(int32 InBlockBytes, int64 InBudgetBytes);
+
+    // Get an empty block, or nullptr if the budget is used up
+    FSGAudioBlock* Acquire();
+
+    // Return a block to the pool
+    void Release(FSGAudioBlock* Block);
+
+    int32 GetBlockBytes() const;
+
+    // Bytes held by the pool, in use or free
+    int64 GetAllocatedBytes() const;
+
+    // Bytes held by blocks that have not been released
+    int64 GetInUseBytes() const;
+
+private:
+    mutable FCriticalSection Lock;
+
+    TArray<FSGAudioBlock*> FreeBlocks;
+
+    int32 BlockBytes = 0;
+    int64 BudgetBytes = 0;
+    int64 AllocatedBytes = 0;
+    int64 InUseBytes = 0;
+};
@@ -0,0 +1,255 @@
+#include "SGAudioCapture.h"
+
+#include "Async/Async.h"
+#include "Audio.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+
+// Duration of audio the ring can hold (s)
+static const int32 RingSeconds = 2;
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGAudioCapture::FSGAudioCapture()
+{
+    Ring.SetCapacity(SampleRate * RingSeconds);
+}
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGAudioCapture::~FSGAudioCapture()
+{
+    Stop();
+}
+
+// ========================================================
+// Set the engine input format and the block size
+// ========================================================
+void FSGAudioCapture::Configure(SG_AudioSampleType InSampleType, int32 InSampleRate, double BlockMs)
+{
+    SampleType = InSampleType;
+    SampleRate = InSampleRate;
+    BlockFrames = FMath::Max(1, (int32)(BlockMs * SampleRate / 1000.0));
+
+    Ring.SetCapacity(SampleRate * RingSeconds);
+    ResamplePosition = 0.0;
+    LastSample = 0.f;
+}
+
+// ========================================================
+// Start capturing from the default audio capture device
+// ========================================================
+bool FSGAudioCapture::StartDevice()
+{
+    Audio::FAudioCaptureDeviceParams Params;
+    Audio::FOnCaptureFunction OnCapture = [this](const float* InAudio, int32 NumFrames, int32 NumChannels, int32 InSampleRate, double StreamTime, bool bOverFlow)
+    {
+        PushAudio(InAudio, NumFrames, NumChannels, InSampleRate);
+    };
+
+    // Ask the device for blocks of the same duration as the engine blocks
+    Audio::FCaptureDeviceInfo DeviceInfo;
+    uint32 NumFramesDesired = BlockFrames;
+    if (AudioCapture.GetCaptureDeviceInfo(DeviceInfo)) {
+        NumFramesDesired = FMath::Max(1, BlockFrames * DeviceInfo.PreferredSampleRate / SampleRate);
+    }
+
+    if (!AudioCapture.OpenDefaultCaptureStream(Params, MoveTemp(OnCapture), NumFramesDesired)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to open the audio capture device"));
+        return false;
+    }
+    bDeviceOpen = true;
+
+    if (!AudioCapture.StartStream()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to start the audio capture stream"));
+        Stop();
+        return false;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Capturing audio from %s"), *DeviceInfo.DeviceName);
+    return true;
+}
+
+// ========================================================
+// Start capturing from a WAV file played back in realtime
+// ========================================================
+bool FSGAudioCapture::StartFile(const FString& FilePath)
+{
+    TArray<uint8> RawAudioData;
+    if (!FFileHelper::LoadFileToArray(RawAudioData, *FilePath)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to read capture file %s"), *FilePath);
+        return false;
+    }
+
+    FWaveModInfo WaveInfo;
+    if (!WaveInfo.ReadWaveInfo(RawAudioData.GetData(), RawAudioData.Num())) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Capture file %s is not a valid wav file"), *FilePath);
+        return false;
+    }
+
+    // Convert to interleaved float samples
+    const uint16 FormatTag = *WaveInfo.pFormatTag;
+    const uint16 BitsPerSample = *WaveInfo.pBitsPerSample;
+    const int32 NumSamples = WaveInfo.SampleDataSize / (BitsPerSample / 8);
+    FileSamples.SetNumUninitialized(NumSamples);
+    if (FormatTag == 0x0001 && BitsPerSample == 16) {
+        const int16* Samples = (const int16*)WaveInfo.SampleDataStart;
+        for (int32 i = 0; i < NumSamples; ++i) {
+            FileSamples[i] = Samples[i] / 32768.f;
+        }
+    }
+    else if (FormatTag == 0x0003 && BitsPerSample == 32) {
+        FMemory::Memcpy(FileSamples.GetData(), WaveInfo.SampleDataStart, NumSamples * sizeof(float));
+    }
+    else {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Capture file must be 16 bit PCM or 32 bit IEEE float"));
+        FileSamples.Reset();
+        return false;
+    }
+
+    FileSampleRate = *WaveInfo.pSamplesPerSec;
+    const int32 NumChannels = *WaveInfo.pChannels;
+
+    bFileCaptureRunning = true;
+    FileFuture = Async(EAsyncExecution::Thread, [this, NumChannels]() {
+        const int32 FramesPerBlock = FMath::Max(1, BlockFrames * FileSampleRate / SampleRate);
+        const double BlockSeconds = (double)FramesPerBlock / FileSampleRate;
+        const int32 NumFrames = FileSamples.Num() / NumChannels;
+
+        // Pace the blocks against the wall clock like a capture device would
+        double NextBlockTime = FPlatformTime::Seconds();
+        for (int32 Frame = 0; Frame < NumFrames && bFileCaptureRunning; Frame += FramesPerBlock) {
+            const int32 Count = FMath::Min(FramesPerBlock, NumFrames - Frame);
+            PushAudio(FileSamples.GetData() + Frame * NumChannels, Count, NumChannels, FileSampleRate);
+
+            NextBlockTime += BlockSeconds;
+            const double SleepTime = NextBlockTime - FPlatformTime::Seconds();
+            if (SleepTime > 0.0) {
+                FPlatformProcess::Sleep((float)SleepTime);
+            }
+        }
+        bFileCaptureRunning = false;
+    });
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Capturing audio from file %s"), *FilePath);
+    return true;
+}
+
+// ========================================================
+// Stop capturing
+// ========================================================
+void FSGAudioCapture::Stop()
+{
+    if (bDeviceOpen) {
+        AudioCapture.StopStream();
+        AudioCapture.CloseStream();
+        bDeviceOpen = false;
+    }
+
+    bFileCaptureRunning = false;
+    if (FileFuture.IsValid()) {
+        FileFuture.Get();
+        FileFuture = TFuture<void>();
+    }
+}
+
+bool FSGAudioCapture::IsCapturing() const
+{
+    return bDeviceOpen || bFileCaptureRunning;
+}
+
+void FSGAudioCapture::SetMuted(bool bInMuted)
+{
+    bMuted = bInMuted;
+}
+
+// ========================================================
+// Push captured audio into the ring
+// ========================================================
+void FSGAudioCapture::PushAudio(const float* InAudio, int32 NumFrames, int32 NumChannels, int32 InSampleRate)
+{
+    if (NumFrames <= 0 || NumChannels <= 0 || bMuted) {
+        return;
+    }
+
+    // The ring takes a single producer, uncontended with one capture source
+    FScopeLock ScopeLock(&PushLock);
+
+    // Mix down to mono
+    MonoScratch.SetNumUninitialized(NumFrames);
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        float Sum = 0.f;
+        for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+            Sum += InAudio[Frame * NumChannels + Channel];
+        }
+        MonoScratch[Frame] = Sum / NumChannels;
+    }
+
+    const float* Samples = MonoScratch.GetData();
+    int32 NumSamples = NumFrames;
+
+    // Linear resample to the engine rate, position -1 is the last sample of the previous block
+    if (InSampleRate != SampleRate) {
+        const double Step = (double)InSampleRate / SampleRate;
+        ResampleScratch.Reset();
+        for (; ResamplePosition < NumFrames - 1; ResamplePosition += Step) {
+            const int32 Index = (int32)FMath::FloorToDouble(ResamplePosition);
+            const float Alpha = (float)(ResamplePosition - Index);
+            const float A = Index < 0 ? LastSample : MonoScratch[Index];
+            const float B = MonoScratch[Index + 1];
+            ResampleScratch.Add(A + (B - A) * Alpha);
+        }
+        ResamplePosition -= NumFrames;
+        LastSample = MonoScratch[NumFrames - 1];
+
+        Samples = ResampleScratch.GetData();
+        NumSamples = ResampleScratch.Num();
+    }
+
+    const uint32 NumPushed = Ring.Push(Samples, NumSamples);
+    if (NumPushed < (uint32)NumSamples && !bOverflowLogged) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Audio capture ring overflow, the engine is not keeping up"));
+        bOverflowLogged = true;
+    }
+}
+
+// ========================================================
+// Pop one block of audio in the engine input format
+// ========================================================
+bool FSGAudioCapture::ReadBlock(TArray<uint8>& OutData)
+{
+    if (Ring.Num() < (uint32)BlockFrames) {
+        return false;
+    }
+
+    BlockScratch.SetNumUninitialized(BlockFrames);
+    Ring.Pop(BlockScratch.GetData(), BlockFrames);
+
+    switch (SampleType) {
+        case SG_AUDIO_INT_16: {
+            OutData.SetNumUninitialized(BlockFrames * sizeof(int16));
+            int16* Out = (int16*)OutData.GetData();
+            for (int32 i = 0; i < BlockFrames; ++i) {
+                Out[i] = (int16)(FMath::Clamp(BlockScratch[i], -1.f, 1.f) * 32767.f);
+            }
+            break;
+        }
+        case SG_AUDIO_INT_32: {
+            OutData.SetNumUninitialized(BlockFrames * sizeof(int32));
+            int32* Out = (int32*)OutData.GetData();
+            for (int32 i = 0; i < BlockFrames; ++i) {
+                Out[i] = (int32)(FMath::Clamp(BlockScratch[i], -1.f, 1.f) * 2147483647.0);
+            }
+            break;
+        }
+        case SG_AUDIO_FLOAT_32:
+        default:
+            OutData.SetNumUninitialized(BlockFrames * sizeof(float));
+            FMemory::Memcpy(OutData.GetData(), BlockScratch.GetData(), BlockFrames * sizeof(float));
+            break;
+    };
+
+    return true;
+}
@@ -0,0 +1,76 @@
+// Streams captured audio into the SG_Com engine input
+
+#pragma once
+
+#include "SG.h"
+
+#include "CoreMinimal.h"
+#include "AudioCaptureCore.h"
+#include "DSP/Dsp.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGAudioCapture
+{
+public:
+    FSGAudioCapture();
+    ~FSGAudioCapture();
+
+    // Set the engine input format and the block size, called before starting
+    void Configure(SG_AudioSampleType InSampleType, int32 InSampleRate, double BlockMs);
+
+    // Start capturing from the default audio capture device
+    bool StartDevice();
+
+    // Start capturing from a WAV file played back in realtime, for machines
+    // without a capture device
+    bool StartFile(const FString& FilePath);
+
+    // Stop capturing
+    void Stop();
+
+    bool IsCapturing() const;
+
+    // Drop captured audio while muted, e.g. while the avatar is speaking
+    void SetMuted(bool bInMuted);
+
+    // Push captured audio into the ring. Safe to call from several producer
+    // threads, e.g. the capture device and the file playback, which take
+    // turns pushing whole calls.
+    void PushAudio(const float* InAudio, int32 NumFrames, int32 NumChannels, int32 InSampleRate);
+
+    // Pop one block of audio in the engine input format. Called from a single
+    // consumer thread. Returns false if less than a block is available.
+    bool ReadBlock(TArray<uint8>& OutData);
+
+private:
+    // Lock free ring between the capture and processing threads, mono at the engine rate
+    Audio::TCircularAudioBuffer<float> Ring;
+
+    Audio::FAudioCapture AudioCapture;
+    bool bDeviceOpen = false;
+
+    // Engine input format
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 SampleRate = 16000;
+    int32 BlockFrames = 160;
+
+    FThreadSafeBool bMuted = false;
+
+    // Producer side scratch and resampler state, held by one producer at a time
+    FCriticalSection PushLock;
+    TArray<float> MonoScratch;
+    TArray<float> ResampleScratch;
+    double ResamplePosition = 0.0;
+    float LastSample = 0.f;
+    bool bOverflowLogged = false;
+
+    // Consumer side scratch
+    TArray<float> BlockScratch;
+
+    // File backed capture
+    TArray<float> FileSamples;
+    int32 FileSampleRate = 0;
+    FThreadSafeBool bFileCaptureRunning = false;
+    TFuture<void> FileFuture;
+};
@@ -0,0 +1,301 @@
+#include "SGAudioIngestServer.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Largest payload accepted in one frame
+static const uint32 MaxPayloadBytes = 1024 * 1024;
+
+// Longest a client may pause in the middle of a frame before it is disconnected
+static const double FrameTimeoutSec = 2.0;
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGAudioIngestServer::FSGAudioIngestServer()
+{
+}
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGAudioIngestServer::~FSGAudioIngestServer()
+{
+    Shutdown();
+}
+
+// ========================================================
+// Start listening on the loopback interface
+// ========================================================
+bool FSGAudioIngestServer::Start(int32 Port, SG_AudioSampleType InSampleType, int32 InSampleRate)
+{
+    SampleType = InSampleType;
+    SampleRate = InSampleRate;
+
+    ListenSocket = FTcpSocketBuilder(TEXT("SGAudioIngest"))
+        .AsReusable()
+        .BoundToEndpoint(FIPv4Endpoint(FIPv4Address::InternalLoopback, Port))
+        .Listening(1);
+
+    if (!ListenSocket) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to listen for audio on port %d"), Port);
+        return false;
+    }
+
+    bStopping = false;
+    Thread = FRunnableThread::Create(this, TEXT("SGAudioIngest"));
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Listening for audio on 127.0.0.1:%d"), Port);
+    return true;
+}
+
+// ========================================================
+// Stop listening and disconnect the client
+// ========================================================
+void FSGAudioIngestServer::Shutdown()
+{
+    if (Thread) {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    CloseClient();
+    if (ListenSocket) {
+        ListenSocket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+        ListenSocket = nullptr;
+    }
+
+    FSGIngestFrame* Frame = nullptr;
+    while (Frames.Dequeue(Frame)) {
+        delete Frame;
+    }
+    Acks.Empty();
+}
+
+bool FSGAudioIngestServer::IsRunning() const
+{
+    return Thread != nullptr;
+}
+
+// ========================================================
+// Pop the next received frame
+// ========================================================
+bool FSGAudioIngestServer::PopFrame(FSGIngestFrame& OutFrame)
+{
+    FSGIngestFrame* Frame = nullptr;
+    if (!Frames.Dequeue(Frame)) {
+        return false;
+    }
+
+    OutFrame = MoveTemp(*Frame);
+    delete Frame;
+    return true;
+}
+
+// ========================================================
+// Acknowledge a frame once its audio was queued
+// ========================================================
+void FSGAudioIngestServer::Acknowledge(const FSGIngestFrame& Frame, ESGIngestStatus Status, int32 BytesAccepted)
+{
+    FSGIngestAck Ack;
+    Ack.Magic = SG_INGEST_ACK_MAGIC;
+    Ack.Status = Status;
+    Ack.Flags = Frame.Flags;
+    Ack.UtteranceId = Frame.UtteranceId;
+    Ack.BytesAccepted = BytesAccepted;
+    Ack.QueueLatencyUs = (uint32)((FPlatformTime::Seconds() - Frame.ReceivedTime) * 1000000.0);
+    Acks.Enqueue(Ack);
+}
+
+// ========================================================
+// Accept a client and read its frames
+// ========================================================
+uint32 FSGAudioIngestServer::Run()
+{
+    const FTimespan WaitTime = FTimespan::FromMilliseconds(5);
+
+    while (!bStopping) {
+        if (!ClientSocket) {
+            bool bHasPendingConnection = false;
+            if (ListenSocket->WaitForPendingConnection(bHasPendingConnection, FTimespan::FromMilliseconds(100)) && bHasPendingConnection) {
+                ClientSocket = ListenSocket->Accept(TEXT("SGAudioIngestClient"));
+
+                // Never blocks the thread, so it sees Stop with a client connected
+                if (ClientSocket) {
+                    ClientSocket->SetNonBlocking(true);
+                }
+            }
+            continue;
+        }
+
+        SendAcks();
+
+        if (ClientSocket->Wait(ESocketWaitConditions::WaitForRead, WaitTime)) {
+            if (!ReadFrame()) {
+                CloseClient();
+            }
+        }
+    }
+
+    return 0;
+}
+
+// ========================================================
+// Called to stop the thread
+// ========================================================
+void FSGAudioIngestServer::Stop()
+{
+    bStopping = true;
+}
+
+// ========================================================
+// Read a whole frame from the client
+// ========================================================
+bool FSGAudioIngestServer::ReadFrame()
+{
+    FSGIngestHeader Header;
+    if (!ReceiveAll((uint8*)&Header, sizeof(Header))) {
+        return false;
+    }
+
+    if (Header.Magic != SG_INGEST_HEADER_MAGIC || Header.Version != SG_INGEST_VERSION) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Invalid audio ingest header, disconnecting"));
+        return false;
+    }
+
+    // Reject the payload of frames that cannot be input, but stay in sync with the stream
+    ESGIngestStatus Status = SG_INGEST_STATUS_OK;
+    if (Header.PayloadBytes > MaxPayloadBytes) {
+        Status = SG_INGEST_STATUS_TOO_LARGE;
+    }
+    else if (Header.SampleRate != (uint32)SampleRate || Header.SampleType != SampleType || Header.NumChannels != 1) {
+        Status = SG_INGEST_STATUS_BAD_FORMAT;
+    }
+
+    if (Status != SG_INGEST_STATUS_OK) {
+        uint8 Discard[4096];
+        uint32 Remaining = Header.PayloadBytes;
+        while (Remaining > 0) {
+            const int32 Count = (int32)FMath::Min<uint32>(Remaining, sizeof(Discard));
+            if (!ReceiveAll(Discard, Count)) {
+                return false;
+            }
+            Remaining -= Count;
+        }
+
+        FSGIngestAck Ack;
+        Ack.Magic = SG_INGEST_ACK_MAGIC;
+        Ack.Status = Status;
+        Ack.Flags = Header.Flags;
+        Ack.UtteranceId = Header.UtteranceId;
+        Ack.BytesAccepted = 0;
+        Ack.QueueLatencyUs = 0;
+        SendAck(Ack);
+        return true;
+    }
+
+    FSGIngestFrame* Frame = new FSGIngestFrame();
+    Frame->UtteranceId = Header.UtteranceId;
+    Frame->Flags = Header.Flags;
+    Frame->Data.SetNumUninitialized(Header.PayloadBytes);
+    if (!ReceiveAll(Frame->Data.GetData(), Frame->Data.Num())) {
+        delete Frame;
+        return false;
+    }
+
+    Frame->ReceivedTime = FPlatformTime::Seconds();
+    Frames.Enqueue(Frame);
+    return true;
+}
+
+// ========================================================
+// Receive exactly NumBytes from the client, giving up when
+// stopped or when the client stalls mid-frame
+// ========================================================
+bool FSGAudioIngestServer::ReceiveAll(uint8* Data, int32 NumBytes)
+{
+    const FTimespan WaitTime = FTimespan::FromMilliseconds(50);
+    double LastDataTime = FPlatformTime::Seconds();
+
+    while (NumBytes > 0) {
+        if (bStopping) {
+            return false;
+        }
+
+        if (!ClientSocket->Wait(ESocketWaitConditions::WaitForRead, WaitTime)) {
+            if (FPlatformTime::Seconds() - LastDataTime > FrameTimeoutSec) {
+                UE_LOG(LogTemp, Warning, TEXT("[APP] : Audio ingest client stalled mid-frame, disconnecting"));
+                return false;
+            }
+            continue;
+        }
+
+        // Readable with nothing to read means the client disconnected
+        int32 BytesRead = 0;
+        if (!ClientSocket->Recv(Data, NumBytes, BytesRead)) {
+            if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK) {
+                continue;
+            }
+            return false;
+        }
+        if (BytesRead <= 0) {
+            return false;
+        }
+
+        Data += BytesRead;
+        NumBytes -= BytesRead;
+        LastDataTime = FPlatformTime::Seconds();
+    }
+
+    return true;
+}
+
+// ========================================================
+// Send the acks queued on the game thread
+// ========================================================
+void FSGAudioIngestServer::SendAcks()
+{
+    FSGIngestAck Ack;
+    while (Acks.Dequeue(Ack)) {
+        SendAck(Ack);
+    }
+}
+
+// ========================================================
+// Send one ack to the client
+// ========================================================
+void FSGAudioIngestServer::SendAck(const FSGIngestAck& Ack)
+{
+    // Acks are small, a client not reading them for a while loses some
+    const uint8* Data = (const uint8*)&Ack;
+    int32 NumBytes = sizeof(Ack);
+    while (NumBytes > 0 && !bStopping) {
+        int32 BytesSent = 0;
+        if (!ClientSocket->Send(Data, NumBytes, BytesSent)) {
+            if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK
+                || !ClientSocket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::FromMilliseconds(50))) {
+                return;
+            }
+            continue;
+        }
+        Data += BytesSent;
+        NumBytes -= BytesSent;
+    }
+}
+
+// ========================================================
+// Disconnect the client
+// ========================================================
+void FSGAudioIngestServer::CloseClient()
+{
+    if (ClientSocket) {
+        ClientSocket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ClientSocket);
+        ClientSocket = nullptr;
+    }
+}
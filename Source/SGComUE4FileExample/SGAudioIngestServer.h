@@ -0,0 +1,122 @@
+// Local socket endpoint for handing audio to the engine without the file system
+//
+// A client connects to 127.0.0.1:IngestPort and sends frames of a
+// FSGIngestHeader followed by PayloadBytes of mono PCM in the engine input
+// format. Frames with the same UtteranceId are one utterance, the last one
+// has SG_INGEST_FLAG_END_OF_UTTERANCE set. Every frame is answered with a
+// FSGIngestAck once its audio has been queued for the engine. All fields
+// are little endian.
+
+#pragma once
+
+#include "SG.h"
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FSocket;
+class FRunnableThread;
+
+#define SG_INGEST_HEADER_MAGIC 0x49414753 // "SGAI"
+#define SG_INGEST_ACK_MAGIC 0x4B414753    // "SGAK"
+#define SG_INGEST_VERSION 1
+
+// Frame flags
+#define SG_INGEST_FLAG_END_OF_UTTERANCE 0x0001
+
+// Ack status codes
+enum ESGIngestStatus : uint16
+{
+    SG_INGEST_STATUS_OK = 0,
+    SG_INGEST_STATUS_BAD_FORMAT = 1,  // Sample rate, type or channels differ from the engine input
+    SG_INGEST_STATUS_TOO_LARGE = 2,   // Payload larger than the maximum frame size
+    SG_INGEST_STATUS_DROPPED = 3      // The engine input queue had no room
+};
+
+#pragma pack(push, 1)
+struct FSGIngestHeader
+{
+    uint32 Magic;
+    uint16 Version;
+    uint16 Flags;
+    uint64 UtteranceId;
+    uint32 SampleRate;   // Hz
+    uint16 SampleType;   // SG_AudioSampleType
+    uint16 NumChannels;  // Must be 1
+    uint32 PayloadBytes;
+};
+
+struct FSGIngestAck
+{
+    uint32 Magic;
+    uint16 Status;       // ESGIngestStatus
+    uint16 Flags;        // Flags of the acknowledged frame
+    uint64 UtteranceId;
+    uint32 BytesAccepted;
+    uint32 QueueLatencyUs; // From the frame being received to its audio being queued for the engine
+};
+#pragma pack(pop)
+
+// A received frame waiting to be queued for the engine
+struct FSGIngestFrame
+{
+    uint64 UtteranceId = 0;
+    uint16 Flags = 0;
+    TArray<uint8> Data;
+    double ReceivedTime = 0.0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGAudioIngestServer : public FRunnable
+{
+public:
+    FSGAudioIngestServer();
+    ~FSGAudioIngestServer();
+
+    // Start listening on the loopback interface
+    bool Start(int32 Port, SG_AudioSampleType InSampleType, int32 InSampleRate);
+
+    // Stop listening and disconnect the client
+    void Shutdown();
+
+    bool IsRunning() const;
+
+    // Pop the next received frame, called on the game thread
+    bool PopFrame(FSGIngestFrame& OutFrame);
+
+    // Acknowledge a frame once its audio was queued for the engine
+    void Acknowledge(const FSGIngestFrame& Frame, ESGIngestStatus Status, int32 BytesAccepted);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    // Read a whole frame from the client, false if the client disconnected
+    bool ReadFrame();
+
+    // Receive exactly NumBytes from the client, false if it disconnected,
+    // stalled mid-frame or the server is stopping
+    bool ReceiveAll(uint8* Data, int32 NumBytes);
+
+    // Send the acks queued on the game thread to the client
+    void SendAcks();
+
+    // Send one ack to the client
+    void SendAck(const FSGIngestAck& Ack);
+
+    void CloseClient();
+
+    FSocket* ListenSocket = nullptr;
+    FSocket* ClientSocket = nullptr;
+    FRunnableThread* Thread = nullptr;
+    FThreadSafeBool bStopping = false;
+
+    // Engine input format frames must match
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 SampleRate = 16000;
+
+    TQueue<FSGIngestFrame*, EQueueMode::Spsc> Frames;
+    TQueue<FSGIngestAck, EQueueMode::Spsc> Acks;
+};
@@ -0,0 +1,176 @@
+#include "SGAudioPlayback.h"
+
+#include "Misc/ScopeLock.h"
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGAudioPlayback::~FSGAudioPlayback()
+{
+    Reset();
+}
+
+// ========================================================
+// Set the pool played blocks are returned to
+// ========================================================
+void FSGAudioPlayback::Configure(FSGAudioBufferPool* InPool, SG_AudioSampleType InSampleType, int32 InBytesPerSecond)
+{
+    Reset();
+
+    FScopeLock ScopeLock(&RenderLock);
+    Pool = InPool;
+    SampleType = InSampleType;
+    BytesPerSample = InSampleType == SG_AUDIO_INT_16 ? 2 : 4;
+    BytesPerSecond = FMath::Max(1, InBytesPerSecond);
+}
+
+// ========================================================
+// Queue a block for playback
+// ========================================================
+void FSGAudioPlayback::Enqueue(FSGAudioBlock* Block)
+{
+    NumQueued.Increment();
+    Blocks.Enqueue(Block);
+}
+
+// ========================================================
+// Drop the queued audio of an utterance and all before it
+// ========================================================
+void FSGAudioPlayback::Flush(uint32 Utterance)
+{
+    FScopeLock ScopeLock(&RenderLock);
+    FlushedUtterance = Utterance;
+    if (PlayingUtterance <= Utterance) {
+        PlayingUtterance = 0;
+    }
+}
+
+// ========================================================
+// Fill PCMData with the next queued audio
+// ========================================================
+int32 FSGAudioPlayback::Render(int16* PCMData, int32 NumSamples)
+{
+    FScopeLock ScopeLock(&RenderLock);
+
+    const uint32 Flushed = FlushedUtterance;
+    int32 Written = 0;
+    FSGAudioBlock* Block = nullptr;
+    while (Written < NumSamples && Blocks.Peek(Block)) {
+        const bool bDropped = Block->Utterance <= Flushed;
+        if (!bDropped) {
+            if (HeadOffset == 0 && Block->bUtteranceStart) {
+                PlayingUtterance = Block->Utterance;
+                PlayedBytes = 0;
+            }
+
+            const int32 NumCopied = FMath::Min((Block->Data.Num() - HeadOffset) / BytesPerSample, NumSamples - Written);
+            ConvertSamples(Block->Data.GetData() + HeadOffset, NumCopied, PCMData + Written);
+            Written += NumCopied;
+            HeadOffset += NumCopied * BytesPerSample;
+            PlayedBytes += NumCopied * BytesPerSample;
+
+            // A trailing partial sample is dropped with the block
+            if (HeadOffset + BytesPerSample <= Block->Data.Num()) {
+                break;
+            }
+
+            if (Block->bUtteranceEnd) {
+                FinishedUtterance = Block->Utterance;
+                PlayingUtterance = 0;
+            }
+        }
+
+        Blocks.Pop();
+        NumQueued.Decrement();
+        HeadOffset = 0;
+        if (Pool) {
+            Pool->Release(Block);
+        }
+    }
+
+    // Keep the source running on silence until more audio is queued
+    FMemory::Memzero(PCMData + Written, (NumSamples - Written) * sizeof(int16));
+    RenderTime = FPlatformTime::Seconds();
+    return NumSamples * (int32)sizeof(int16);
+}
+
+// ========================================================
+// Convert samples of the block format to 16 bit PCM
+// ========================================================
+void FSGAudioPlayback::ConvertSamples(const uint8* Data, int32 NumSamples, int16* OutSamples) const
+{
+    switch (SampleType) {
+        case SG_AUDIO_INT_32: {
+            const int32* Samples = (const int32*)Data;
+            for (int32 i = 0; i < NumSamples; ++i) {
+                OutSamples[i] = (int16)(Samples[i] / 65536);
+            }
+            break;
+        }
+        case SG_AUDIO_FLOAT_32: {
+            const float* Samples = (const float*)Data;
+            for (int32 i = 0; i < NumSamples; ++i) {
+                OutSamples[i] = (int16)FMath::Clamp(FMath::RoundToInt(Samples[i] * 32767.f), -32768, 32767);
+            }
+            break;
+        }
+        default:
+            FMemory::Memcpy(OutSamples, Data, NumSamples * sizeof(int16));
+            break;
+    }
+}
+
+// ========================================================
+// Get the position of the utterance being played
+// ========================================================
+bool FSGAudioPlayback::GetClock(uint32& OutUtterance, double& OutPositionMs, double& OutRenderTime) const
+{
+    FScopeLock ScopeLock(&RenderLock);
+    if (PlayingUtterance == 0) {
+        return false;
+    }
+
+    OutUtterance = PlayingUtterance;
+    OutPositionMs = PlayedBytes * 1000.0 / BytesPerSecond;
+    OutRenderTime = RenderTime;
+    return true;
+}
+
+bool FSGAudioPlayback::IsPlaying() const
+{
+    FScopeLock ScopeLock(&RenderLock);
+    return PlayingUtterance != 0 || NumQueued.GetValue() > 0;
+}
+
+uint32 FSGAudioPlayback::TakeFinished()
+{
+    return FinishedUtterance.Exchange(0);
+}
+
+// ========================================================
+// Return all queued blocks to the pool
+// ========================================================
+void FSGAudioPlayback::Reset()
+{
+    FScopeLock ScopeLock(&RenderLock);
+
+    FSGAudioBlock* Block = nullptr;
+    while (Blocks.Dequeue(Block)) {
+        NumQueued.Decrement();
+        if (Pool) {
+            Pool->Release(Block);
+        }
+    }
+    HeadOffset = 0;
+    PlayingUtterance = 0;
+    PlayedBytes = 0;
+    FinishedUtterance = 0;
+}
+
+// ========================================================
+// Render the queued blocks as 16 bit PCM
+// ========================================================
+int32 USGPlaybackSoundWave::GeneratePCMData(uint8* PCMData, const int32 SamplesNeeded)
+{
+    return Playback.Render((int16*)PCMData, SamplesNeeded);
+}
@@ -0,0 +1,89 @@
+// Plays the pooled audio blocks fed to the SG_Com engine through one
+// procedural sound wave that lives for the whole session, converting them
+// from the engine input format to 16 bit PCM
+
+#pragma once
+
+#include "SG.h"
+#include "SGAudioBufferPool.h"
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Sound/SoundWaveProcedural.h"
+
+#include "SGAudioPlayback.generated.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGAudioPlayback
+{
+public:
+    ~FSGAudioPlayback();
+
+    // Set the pool played blocks are returned to, and the sample type and
+    // byte rate of the audio in the blocks
+    void Configure(FSGAudioBufferPool* InPool, SG_AudioSampleType InSampleType, int32 InBytesPerSecond);
+
+    // Queue a block for playback, taking it over until it has been played.
+    // Called from any thread.
+    void Enqueue(FSGAudioBlock* Block);
+
+    // Drop the queued audio of Utterance and all utterances before it
+    void Flush(uint32 Utterance);
+
+    // Fill PCMData with the next NumSamples samples of queued audio as 16 bit
+    // PCM, silence when there is none. Called on the audio render thread.
+    int32 Render(int16* PCMData, int32 NumSamples);
+
+    // Get the utterance being played, its rendered position (ms) and when
+    // it was rendered. Returns false if no utterance is playing.
+    bool GetClock(uint32& OutUtterance, double& OutPositionMs, double& OutRenderTime) const;
+
+    bool IsPlaying() const;
+
+    // Take the last utterance that finished playing, 0 if none since the last call
+    uint32 TakeFinished();
+
+    // Return all queued blocks to the pool
+    void Reset();
+
+private:
+    // Convert NumSamples samples of the block format to 16 bit PCM
+    void ConvertSamples(const uint8* Data, int32 NumSamples, int16* OutSamples) const;
+
+    FSGAudioBufferPool* Pool = nullptr;
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 BytesPerSample = 2;
+    int32 BytesPerSecond = 32000;
+
+    // Blocks waiting to be played, the head block is partly played up to HeadOffset
+    TQueue<FSGAudioBlock*, EQueueMode::Mpsc> Blocks;
+    FThreadSafeCounter NumQueued;
+    int32 HeadOffset = 0;
+
+    // Utterances up to this one are dropped when rendered
+    TAtomic<uint32> FlushedUtterance{ 0 };
+
+    // Held while rendering, so a flush takes effect before the next render
+    mutable FCriticalSection RenderLock;
+    uint32 PlayingUtterance = 0;
+    int64 PlayedBytes = 0;
+    double RenderTime = 0.0;
+
+    TAtomic<uint32> FinishedUtterance{ 0 };
+};
+
+// Procedural sound wave rendering an FSGAudioPlayback, created once and
+// reused for every utterance
+UCLASS()
+class SGCOMUE4FILEEXAMPLE_API USGPlaybackSoundWave : public USoundWaveProcedural
+{
+    GENERATED_BODY()
+
+public:
+    // Render the queued blocks as 16 bit PCM
+    int32 GeneratePCMData(uint8* PCMData, const int32 SamplesNeeded) override;
+
+    // Lives as long as the sound wave, which the audio renderer keeps alive while it plays
+    FSGAudioPlayback Playback;
+};
@@ -0,0 +1,186 @@
+#include "SGBufferController.h"
+
+#include "SGComSettings.h"
+
+#include "Misc/ScopeLock.h"
+
+// Weight of a new sample in the moving averages
+static const double SmoothingFactor = 0.05;
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGBufferController::FSGBufferController()
+{
+    Reset();
+}
+
+// ========================================================
+// Forget all measurements
+// ========================================================
+void FSGBufferController::Reset()
+{
+    FScopeLock ScopeLock(&Lock);
+    RealtimeFactor = 1.0;
+    JitterMs = 0.0;
+    UnderrunPenaltyMs = 0.0;
+    UtteranceMs = 0.0;
+    UtteranceInputTime = 0.0;
+    bUnderrunThisUtterance = false;
+    TotalStartLatencyMs = 0.0;
+    LastStartLatencyMs = 0.0;
+    NumUtterances = 0;
+    NumUnderruns = 0;
+}
+
+// ========================================================
+// Record one engine tick
+// ========================================================
+void FSGBufferController::OnTick(double BusySeconds, double IntervalSeconds, int ProcessedFrames)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (ProcessedFrames > 0 && BusySeconds > 0.0) {
+        const double Factor = (ProcessedFrames * FrameMs) / (BusySeconds * 1000.0);
+        RealtimeFactor += (Factor - RealtimeFactor) * SmoothingFactor;
+    }
+
+    // Ticks are paced at one frame, anything later delays the output
+    const double LateMs = FMath::Max(0.0, IntervalSeconds * 1000.0 - FrameMs);
+    JitterMs += (LateMs - JitterMs) * SmoothingFactor;
+}
+
+// ========================================================
+// Record new audio input
+// ========================================================
+void FSGBufferController::OnUtteranceInput(double DurationMs)
+{
+    FScopeLock ScopeLock(&Lock);
+    UtteranceMs = DurationMs;
+    UtteranceInputTime = FPlatformTime::Seconds();
+
+    // Back off the penalty after an utterance that played cleanly
+    if (!bUnderrunThisUtterance) {
+        UnderrunPenaltyMs *= 0.5;
+    }
+    bUnderrunThisUtterance = false;
+}
+
+// ========================================================
+// Record the animation of the current utterance starting
+// ========================================================
+void FSGBufferController::OnAnimationStarted()
+{
+    FScopeLock ScopeLock(&Lock);
+    if (UtteranceInputTime == 0.0) {
+        return;
+    }
+
+    LastStartLatencyMs = (FPlatformTime::Seconds() - UtteranceInputTime) * 1000.0;
+    TotalStartLatencyMs += LastStartLatencyMs;
+    NumUtterances++;
+    UtteranceInputTime = 0.0;
+}
+
+// ========================================================
+// Record an underrun
+// ========================================================
+void FSGBufferController::OnUnderrun()
+{
+    FScopeLock ScopeLock(&Lock);
+    if (bUnderrunThisUtterance) {
+        return;
+    }
+
+    bUnderrunThisUtterance = true;
+    NumUnderruns++;
+    UnderrunPenaltyMs = FMath::Max(UnderrunPenaltyMs * 2.0, 2.0 * FrameMs);
+}
+
+// ========================================================
+// Smallest playable range that avoids underruns
+// ========================================================
+double FSGBufferController::GetStartThresholdMs() const
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    FScopeLock ScopeLock(&Lock);
+
+    // An engine slower than realtime falls behind by (1 - speed) of the
+    // utterance, which has to be buffered up front
+    const double DeficitMs = FMath::Max(0.0, 1.0 - RealtimeFactor) * UtteranceMs;
+    const double ThresholdMs = FrameMs + 2.0 * JitterMs + DeficitMs + UnderrunPenaltyMs;
+
+    return FMath::Clamp(ThresholdMs, Settings.MinStartThresholdMs, Settings.MaxStartThresholdMs);
+}
+
+// ========================================================
+// Playback rate to use for the buffered animation
+// ========================================================
+double FSGBufferController::GetPlaybackRate(double BufferedMs) const
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    const double ThresholdMs = GetStartThresholdMs();
+    if (BufferedMs >= ThresholdMs) {
+        return 1.0;
+    }
+
+    // Stretch the animation in proportion to how empty the buffer is
+    return FMath::Lerp(Settings.MinPlaybackRate, 1.0, FMath::Max(0.0, BufferedMs) / ThresholdMs);
+}
+
+// ========================================================
+// Size of the player output buffer
+// ========================================================
+float FSGBufferController::GetPlayerBufferSec() const
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    if (Settings.PlayerBufferSec > 0.0) {
+        return (float)Settings.PlayerBufferSec;
+    }
+
+    double TickJitterMs = 0.0;
+    {
+        FScopeLock ScopeLock(&Lock);
+        TickJitterMs = JitterMs;
+    }
+
+    // The player holds the analysed lead, with room for a burst of late
+    // ticks, plus the second being played. Bounded by the size the maximum
+    // start threshold needs.
+    const double LeadMs = GetStartThresholdMs() + 4.0 * TickJitterMs;
+    const double MaxLeadMs = Settings.MaxStartThresholdMs;
+    return (float)((FMath::Min(LeadMs, MaxLeadMs) * 2.0 + 1000.0) / 1000.0);
+}
+
+// ========================================================
+// Get the metrics of the current session
+// ========================================================
+FSGBufferMetrics FSGBufferController::GetMetrics() const
+{
+    const double ThresholdMs = GetStartThresholdMs();
+
+    FScopeLock ScopeLock(&Lock);
+    FSGBufferMetrics Metrics;
+    Metrics.RealtimeFactor = RealtimeFactor;
+    Metrics.StartThresholdMs = ThresholdMs;
+    Metrics.LastStartLatencyMs = LastStartLatencyMs;
+    Metrics.AverageStartLatencyMs = NumUtterances > 0 ? TotalStartLatencyMs / NumUtterances : 0.0;
+    Metrics.NumUtterances = NumUtterances;
+    Metrics.NumUnderruns = NumUnderruns;
+    return Metrics;
+}
+
+// ========================================================
+// Log the metrics of the current session
+// ========================================================
+void FSGBufferController::LogMetrics() const
+{
+    const FSGBufferMetrics Metrics = GetMetrics();
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Speed %.2fx realtime, start threshold %.1f ms, start latency avg %.1f ms (last %.1f ms), %d underruns in %d utterances"),
+           Metrics.RealtimeFactor,
+           Metrics.StartThresholdMs,
+           Metrics.AverageStartLatencyMs,
+           Metrics.LastStartLatencyMs,
+           Metrics.NumUnderruns,
+           Metrics.NumUtterances);
+}
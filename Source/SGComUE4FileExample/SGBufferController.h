@@ -0,0 +1,91 @@
+// Adapts the startup threshold and buffer sizes to the measured engine speed
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// Latency and underrun metrics for the current session
+struct FSGBufferMetrics
+{
+    // Engine processing speed relative to realtime
+    double RealtimeFactor = 1.0;
+
+    // Current start threshold (ms)
+    double StartThresholdMs = 0.0;
+
+    // Time from audio input to animation start for the last utterance (ms)
+    double LastStartLatencyMs = 0.0;
+
+    // Average time from audio input to animation start (ms)
+    double AverageStartLatencyMs = 0.0;
+
+    int32 NumUtterances = 0;
+    int32 NumUnderruns = 0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGBufferController
+{
+public:
+    // Duration of one SG_Com frame (ms)
+    static constexpr double FrameMs = 10.0;
+
+    FSGBufferController();
+
+    // Forget all measurements, called when a session starts
+    void Reset();
+
+    // Record one engine tick, called from the processing thread
+    void OnTick(double BusySeconds, double IntervalSeconds, int ProcessedFrames);
+
+    // Record new audio input of the given duration
+    void OnUtteranceInput(double DurationMs);
+
+    // Record the animation of the current utterance starting
+    void OnAnimationStarted();
+
+    // Record the player running out of animation, or the engine out of input,
+    // before the end of the utterance was analysed
+    void OnUnderrun();
+
+    // Smallest playable range that avoids underruns at the measured speed (ms)
+    double GetStartThresholdMs() const;
+
+    // Playback rate to use for the given amount of buffered animation. Slows
+    // down when the buffer runs low instead of letting the animation freeze.
+    // Only meaningful while more of the utterance is to be analysed, the
+    // buffer of a fully analysed utterance runs out by design.
+    double GetPlaybackRate(double BufferedMs) const;
+
+    // Size of the player output buffer (s), from the start threshold and
+    // tick jitter measured so far. Players are sized when they are created,
+    // so a new session or spare engine picks up the last measurements.
+    float GetPlayerBufferSec() const;
+
+    FSGBufferMetrics GetMetrics() const;
+
+    // Log the metrics of the current session
+    void LogMetrics() const;
+
+private:
+    mutable FCriticalSection Lock;
+
+    // Exponential moving averages of the engine speed and tick jitter
+    double RealtimeFactor;
+    double JitterMs;
+
+    // Extra threshold added after underruns, decays on clean utterances
+    double UnderrunPenaltyMs;
+
+    // Duration of the current utterance (ms)
+    double UtteranceMs;
+
+    // When the current utterance was input, zero once started
+    double UtteranceInputTime;
+    bool bUnderrunThisUtterance;
+
+    double TotalStartLatencyMs;
+    double LastStartLatencyMs;
+    int32 NumUtterances;
+    int32 NumUnderruns;
+};
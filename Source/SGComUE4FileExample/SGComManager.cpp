@@ -3,15 +3,112 @@
 
 #include "SGComManager.h"
 
+#include "SGComControlQueue.h"
+#include "SGComSettings.h"
+#include "SGIdleLoops.h"
+#include "SGLatencyTracer.h"
+
+#include "CoreGlobals.h"
 #include "GenericPlatform/GenericPlatformMisc.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("A/V Offset (ms)"), STAT_SGCom_AVOffset, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Realtime Factor"), STAT_SGCom_RealtimeFactor, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Start Threshold (ms)"), STAT_SGCom_StartThreshold, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Start Latency (ms)"), STAT_SGCom_StartLatency, STATGROUP_SGCom);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Underruns"), STAT_SGCom_Underruns, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Barge-in Latency (ms)"), STAT_SGCom_BargeInLatency, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("VAD Skipped (ms)"), STAT_SGCom_VadSkipped, STATGROUP_SGCom);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("VAD CPU Saved (ms)"), STAT_SGCom_VadCpuSaved, STATGROUP_SGCom);
+DECLARE_CYCLE_STAT(TEXT("Player Update"), STAT_SGCom_PlayerUpdate, STATGROUP_SGCom);
 
 FString FSGComManager::LogPath;
 
 SG_COM_EngineHandle FSGComManager::EngineHandle = nullptr;
 SG_COM_PlayerHandle FSGComManager::PlayerHandle = nullptr;
-float FSGComManager::TotalTime = 0.f;
+TAtomic<bool> FSGComManager::bEngineReady{ false };
+double FSGComManager::TotalTime = 0.0;
 bool FSGComManager::bAnimationStarted = false;
+TAtomic<double> FSGComManager::LastMaxTimeMs{ 0.0 };
+TAtomic<double> FSGComManager::UtteranceAnchorMs{ 0.0 };
+double FSGComManager::AudioClockMs = 0.0;
+double FSGComManager::AudioClockStamp = 0.0;
+bool FSGComManager::bAudioClockValid = false;
+double FSGComManager::AVOffsetMs = 0.0;
+double FSGComManager::InputBytesPerSecond = 0.0;
+FSGBufferController FSGComManager::BufferController;
+double FSGComManager::LastTickTime = 0.0;
+bool FSGComManager::bUtteranceStarted = false;
+FSGAudioBufferPool FSGComManager::AudioPool;
+TQueue<FSGAudioBlock*, EQueueMode::Spsc> FSGComManager::PendingBlocks;
+FThreadSafeCounter64 FSGComManager::PendingBytes;
+FCriticalSection FSGComManager::EngineFeedLock;
+TArray<FSGEngineFeed*> FSGComManager::EngineFeeds;
+TAtomic<FSGAudioPlayback*> FSGComManager::Playback{ nullptr };
+uint32 FSGComManager::InputUtterance = 0;
+FSGVoiceActivity FSGComManager::VoiceActivity;
+bool FSGComManager::bVoiceGate = false;
+const FSGAudioBlock* FSGComManager::ClassifiedBlock = nullptr;
+bool FSGComManager::bClassifiedSilent = false;
+int64 FSGComManager::FedUtteranceBytes = 0;
+double FSGComManager::SilenceRunMs = 0.0;
+double FSGComManager::UtteranceSkippedMs = 0.0;
+bool FSGComManager::bGapSkipped = false;
+FSGVoiceActivity FSGComManager::CaptureVoiceActivity;
+double FSGComManager::CaptureSilenceRunMs = 0.0;
+bool FSGComManager::bCaptureGapSkipped = false;
+double FSGComManager::AnalyseTickSec = 0.0;
+int64 FSGComManager::NumAnalyseFrames = 0;
+double FSGComManager::GatedTickSec = 0.0;
+int64 FSGComManager::NumGatedFrames = 0;
+FCriticalSection FSGComManager::VoiceGateLock;
+FSGVoiceGateMetrics FSGComManager::VoiceGateMetrics;
+FThreadSafeBool FSGComManager::bUtteranceOpen;
+double FSGComManager::UtteranceEndMs = 0.0;
+FThreadSafeBool FSGComManager::bIdleLooping;
+bool FSGComManager::bIdleLoopsReady = false;
+TAtomic<FSGAudioCapture*> FSGComManager::CaptureSource{ nullptr };
+TArray<uint8> FSGComManager::CaptureBlock;
+TAtomic<int32> FSGComManager::LastRemainingFrames{ 0 };
+float FSGComManager::EngineBufferSec = 0.f;
+float FSGComManager::PlayerBufferSec = 0.f;
+int64 FSGComManager::CharacterFileBytes = 0;
+FString FSGComManager::CharacterHash;
+SG_AnimationType FSGComManager::AnimationType = SG_NORMAL_ANIMATION;
+FThreadSafeCounter64 FSGComManager::NumPlayerUpdates;
+FThreadSafeCounter64 FSGComManager::PlayerUpdateCycles;
+FThreadSafeCounter64 FSGComManager::NumAvatarFrames;
+FThreadSafeCounter64 FSGComManager::AvatarApplyCycles;
+FCriticalSection FSGComManager::CrossfadeLock;
+TArray<float> FSGComManager::CrossfadeSnapshot;
+uint32 FSGComManager::CrossfadeSerial = 0;
+double FSGComManager::CrossfadeStartTime = 0.0;
+double FSGComManager::BargeInRequestTime = 0.0;
+SG_COM_PlayerHandle FSGComManager::PreAnalysedPlayer = nullptr;
+TArray<FSGRetiredPlayers> FSGComManager::FinishedPlayers;
+double FSGComManager::PreAnalysedStartMs = 0.0;
+double FSGComManager::PreAnalysedTimeMs = 0.0;
+TAtomic<uint32> FSGComManager::BindingGeneration{ 0 };
+TArray<float> FSGComManager::ChannelSnapshot[2];
+TArray<int32> FSGComManager::ChannelSnapshotOffsets[2];
+bool FSGComManager::bChannelSnapshotShared[2] = { false, false };
+TAtomic<int32> FSGComManager::ChannelSnapshotIndex{ INDEX_NONE };
+FCriticalSection FSGComManager::FanOutLock;
+FSGFanOutSetPtr FSGComManager::FanOutSet;
+SG_COM_PlayerConfig FSGComManager::FanOutPlayerConfig;
+TArray<FSGRetiredPlayers> FSGComManager::RetiredPlayers;
+SG_COM_EngineHandle FSGComManager::SpareEngineHandle = nullptr;
+SG_COM_PlayerHandle FSGComManager::SparePlayerHandle = nullptr;
+FThreadSafeBool FSGComManager::bSpareReady;
+FSGTickWatchdog FSGComManager::Watchdog;
+FCriticalSection FSGComManager::TickLock;
+FCriticalSection FSGComManager::HistoryLock;
+TArray<uint8> FSGComManager::InputHistory;
+int64 FSGComManager::HistoryStartBytes = 0;
+int32 FSGComManager::InputBytesPerSample = 2;
+SG_AudioSampleType FSGComManager::InputSampleType = SG_AUDIO_INT_16;
 
 // ========================================================
 void LogException(SG_COM_Error err) {
@@ -74,10 +171,14 @@ bool FSGComManager::CreateEngine(SG_COM_EngineConfig EngineConfig)
     SG_COM_PlayerConfig PlayerConfig;
     PlayerConfig.character_file_in_memory = EngineConfig.character_file_in_memory;
     PlayerConfig.character_file_bytes = EngineConfig.character_file_bytes;
-    PlayerConfig.animation_type = SG_AnimationType::SG_NORMAL_ANIMATION;
-    PlayerConfig.buffer_sec = EngineConfig.buffer_sec;
+    PlayerConfig.animation_type = FSGComSettings::Get().AnimationType;
 
-    SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &PlayerHandle);
+    // Sized from the measurements of the previous session, reset below
+    PlayerConfig.buffer_sec = BufferController.GetPlayerBufferSec();
+
+    // Created into locals, the avatars only see the Engine once it is ready
+    SG_COM_PlayerHandle Player = nullptr;
+    SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &Player);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
         UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create local player: %d"), err);
         LogException(err);
@@ -85,137 +186,1763 @@ bool FSGComManager::CreateEngine(SG_COM_EngineConfig EngineConfig)
     }
 
     // Create the engine
-    EngineConfig.local_player = PlayerHandle;
-    err = SG_COM_CreateEngine(&EngineConfig, &EngineHandle);
+    SG_COM_EngineHandle Engine = nullptr;
+    EngineConfig.local_player = Player;
+    err = SG_COM_CreateEngine(&EngineConfig, &Engine);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
         UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create the engine: %d"), err);
         LogException(err);
+        SG_COM_DestroyPlayer(Player);
         return false;
     }
 
+    // Set for the fan-out set and the control queue, IsEngineValid stays false
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        EngineHandle = Engine;
+        PlayerHandle = Player;
+    }
+
+    // Players sharing the analysis of the Engine through its broadcast packets
+    FanOutPlayerConfig = PlayerConfig;
+    CreateFanOutPlayers();
+
+    const double BytesPerSample = EngineConfig.audio_sample_type == SG_AUDIO_INT_16 ? 2.0 : 4.0;
+    InputBytesPerSecond = BytesPerSample * get_audio_sample_rate(EngineConfig.audio_sample_rate);
+    InputBytesPerSample = (int32)BytesPerSample;
+    InputSampleType = EngineConfig.audio_sample_type;
+    BufferController.Reset();
+    LastTickTime = 0.0;
+    LastRemainingFrames = 0;
+
+    // Blocks hold whole samples
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    const int32 BlockSamples = FMath::Max(1, (int32)(Settings.AudioBlockMs * get_audio_sample_rate(EngineConfig.audio_sample_rate) / 1000.0));
+    AudioPool.Configure(BlockSamples * (int32)BytesPerSample, (int64)(Settings.AudioPoolBudgetMB * 1024.0 * 1024.0));
+
+    bVoiceGate = Settings.VadGate != 0;
+    VoiceActivity.Configure(EngineConfig.audio_sample_type, get_audio_sample_rate(EngineConfig.audio_sample_rate), Settings.VadThresholdDb);
+    CaptureVoiceActivity.Configure(EngineConfig.audio_sample_type, get_audio_sample_rate(EngineConfig.audio_sample_rate), Settings.VadThresholdDb);
+    ClassifiedBlock = nullptr;
+    bGapSkipped = false;
+    CaptureSilenceRunMs = 0.0;
+    bCaptureGapSkipped = false;
+
+    EngineBufferSec = EngineConfig.buffer_sec;
+    PlayerBufferSec = PlayerConfig.buffer_sec;
+    CharacterFileBytes = EngineConfig.character_file_bytes;
+    CharacterHash = FMD5::HashBytes(EngineConfig.character_file_in_memory, EngineConfig.character_file_bytes);
+    FSGComControlQueue::Get().SetRampTicks(FMath::RoundToInt(FSGComSettings::Get().ControlRampMs / FSGBufferController::FrameMs));
+    FSGComControlQueue::Get().RegisterAvatar(AvatarId, EngineHandle);
+    AnimationType = PlayerConfig.animation_type;
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Player outputs %s animation"), AnimationType == SG_BAKED_ANIMATION ? TEXT("baked") : TEXT("normal"));
+
+    Watchdog.Configure(Settings.WatchdogDeadlineFactor, Settings.WatchdogMaxMisses);
+
+    // Published last, the anim threads bind against the character, animation
+    // type and fan-out set written above
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        BindingGeneration++;
+        bEngineReady = true;
+    }
+    LogMemoryReport();
+
     return true;
 }
 
 // ========================================================
-// Destroy the Engine
+// Create a spare Engine and Player and warm them up
 // ========================================================
-bool FSGComManager::DestroyEngine()
+bool FSGComManager::CreateSpareEngine(SG_COM_EngineConfig EngineConfig, float InPlayerBufferSec)
 {
-    SG_COM_Error err = SG_COM_DestroyEngine(EngineHandle);
+    if (bSpareReady) {
+        return true;
+    }
+
+    SG_COM_PlayerConfig PlayerConfig;
+    PlayerConfig.character_file_in_memory = EngineConfig.character_file_in_memory;
+    PlayerConfig.character_file_bytes = EngineConfig.character_file_bytes;
+    PlayerConfig.animation_type = FSGComSettings::Get().AnimationType;
+    PlayerConfig.buffer_sec = InPlayerBufferSec;
+
+    SG_COM_PlayerHandle Player = nullptr;
+    SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &Player);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy the engine: %d"), err);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create spare player: %d"), err);
         LogException(err);
         return false;
     }
-    EngineHandle = nullptr;
 
-    err = SG_COM_DestroyPlayer(PlayerHandle);
+    SG_COM_EngineHandle Engine = nullptr;
+    EngineConfig.local_player = Player;
+    err = SG_COM_CreateEngine(&EngineConfig, &Engine);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy the local player: %d"), err);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create spare engine: %d"), err);
         LogException(err);
+        SG_COM_DestroyPlayer(Player);
         return false;
     }
-    PlayerHandle = nullptr;
 
-    return false;
+    // The first tick pays for first use of the character data
+    int ProcessedFrames = 0;
+    int RemainingFrames = 0;
+    SG_COM_ProcessTick(Engine, &ProcessedFrames, &RemainingFrames);
+
+    SpareEngineHandle = Engine;
+    SparePlayerHandle = Player;
+    bSpareReady = true;
+    LogMemoryReport();
+    return true;
 }
 
 // ========================================================
-// Input an array of audio data to the Engine
+// Tick a private Engine and Player once
 // ========================================================
-bool FSGComManager::InputAudio(const TArray<uint8>& AudioData)
+bool FSGComManager::WarmUp(SG_COM_EngineConfig EngineConfig)
 {
-    SG_COM_Error err = SG_COM_InputAudio(EngineHandle, (void*)AudioData.GetData(), AudioData.Num());
+    SG_COM_PlayerConfig PlayerConfig;
+    PlayerConfig.character_file_in_memory = EngineConfig.character_file_in_memory;
+    PlayerConfig.character_file_bytes = EngineConfig.character_file_bytes;
+    PlayerConfig.animation_type = FSGComSettings::Get().AnimationType;
+    PlayerConfig.buffer_sec = 1.f;
+
+    SG_COM_PlayerHandle Player = nullptr;
+    SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &Player);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create warm-up player: %d"), err);
+        LogException(err);
+        return false;
+    }
+
+    SG_COM_EngineHandle Engine = nullptr;
+    EngineConfig.local_player = Player;
+    EngineConfig.engine_broadcast_callback = nullptr;
+    EngineConfig.buffer_sec = 1.f;
+    err = SG_COM_CreateEngine(&EngineConfig, &Engine);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to input audio: %d"), err);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create warm-up engine: %d"), err);
         LogException(err);
+        SG_COM_DestroyPlayer(Player);
         return false;
     }
 
+    // One frame of silence through the analysis, and its animation evaluated
+    const int32 BytesPerSample = EngineConfig.audio_sample_type == SG_AUDIO_INT_16 ? 2 : 4;
+    TArray<uint8> Silence;
+    Silence.SetNumZeroed((int32)get_audio_sample_rate(EngineConfig.audio_sample_rate) / 100 * BytesPerSample);
+    SG_COM_InputAudio(Engine, Silence.GetData(), Silence.Num());
+
+    int ProcessedFrames = 0;
+    int RemainingFrames = 0;
+    SG_COM_ProcessTick(Engine, &ProcessedFrames, &RemainingFrames);
+
+    double MinTimeMs = 0.0;
+    double MaxTimeMs = 0.0;
+    if (SG_COM_GetPlayableRange(Player, &MinTimeMs, &MaxTimeMs) == SG_COM_Error::SG_COM_ERROR_OK) {
+        SG_COM_UpdateAnimation(Player, MaxTimeMs, nullptr);
+    }
+
+    SG_COM_DestroyEngine(Engine);
+    SG_COM_DestroyPlayer(Player);
     return true;
 }
 
 // ========================================================
-// Process any audio in the Engine input buffer
+// Check if a warm spare Engine is ready
 // ========================================================
-bool FSGComManager::ProcessAudio(int* RemainingFrames_out)
+bool FSGComManager::HasSpareEngine()
 {
-    int ProcessedFrames = 0;
-    int RemainingFrames = 1;
-    SG_COM_Error err = SG_COM_Error::SG_COM_ERROR_OK;
-    err = SG_COM_ProcessTick(EngineHandle, &ProcessedFrames, &RemainingFrames);
+    return bSpareReady;
+}
 
-    if (RemainingFrames_out) {
-        *RemainingFrames_out = RemainingFrames;
+// ========================================================
+// Move the session onto the spare Engine and Player
+// ========================================================
+bool FSGComManager::FailOver(SG_COM_EngineHandle& OutFailedEngine, SG_COM_PlayerHandle& OutFailedPlayer)
+{
+    if (!bSpareReady) {
+        return false;
     }
 
-    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Process tick failed: %d"), err);
-        LogException(err);
-        return false;
+    FScopeLock TickScopeLock(&TickLock);
+    SnapshotPose();
+
+    // Back to the local Player
+    FinishPreAnalysed();
+
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        OutFailedEngine = EngineHandle;
+        OutFailedPlayer = PlayerHandle;
+        EngineHandle = SpareEngineHandle;
+        PlayerHandle = SparePlayerHandle;
+
+        // Changed with the handles, before any Player is retired, so the
+        // avatars fetch the nodes of the new Player from their next evaluation
+        BindingGeneration++;
+    }
+    SpareEngineHandle = nullptr;
+    SparePlayerHandle = nullptr;
+    bSpareReady = false;
+
+    // The new Engine is given the controls, mood and role of the failed one
+    FSGComControlQueue::Get().RegisterAvatar(AvatarId, EngineHandle);
+    Watchdog.Reset();
+
+    // The fan-out Players start over on the packets of the new Engine
+    CreateFanOutPlayers();
+    LastRemainingFrames = 0;
+    LastTickTime = 0.0;
+
+    // Animation the failed Player delivered for the current utterance
+    const double DeliveredMs = FMath::Max(0.0, LastMaxTimeMs.Load() - UtteranceAnchorMs.Load());
+
+    double MinTimeMs = 0.0;
+    double MaxTimeMs = 0.0;
+    SG_COM_GetPlayableRange(PlayerHandle, &MinTimeMs, &MaxTimeMs);
+    TotalTime = MaxTimeMs;
+    LastMaxTimeMs = MaxTimeMs;
+
+    // Replay the audio whose animation was not delivered
+    int64 ReplayedBytes = 0;
+    {
+        FScopeLock ScopeLock(&HistoryLock);
+        int64 DeliveredBytes = (int64)(DeliveredMs * InputBytesPerSecond / 1000.0);
+        DeliveredBytes -= DeliveredBytes % InputBytesPerSample;
+
+        // Audio trimmed from the history is skipped, the replay keeps its
+        // position in the utterance so it stays in sync with the playback
+        const int64 ReplayStartBytes = FMath::Clamp<int64>(DeliveredBytes, HistoryStartBytes, HistoryStartBytes + InputHistory.Num());
+        const int64 TailStart = ReplayStartBytes - HistoryStartBytes;
+        ReplayedBytes = InputHistory.Num() - TailStart;
+        if (ReplayStartBytes > DeliveredBytes) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Skipped %.1f ms of audio trimmed from the replay history"),
+                   (ReplayStartBytes - DeliveredBytes) * 1000.0 / InputBytesPerSecond);
+        }
+
+        // The new Player continues the utterance from where the replay starts
+        UtteranceAnchorMs = MaxTimeMs - (InputBytesPerSecond > 0.0 ? ReplayStartBytes * 1000.0 / InputBytesPerSecond : DeliveredMs);
+
+        if (ReplayedBytes > 0) {
+            SG_COM_Error err = SG_COM_InputAudio(EngineHandle, InputHistory.GetData() + TailStart, (sg_size)ReplayedBytes);
+            if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to replay audio on the spare engine: %d"), err);
+                LogException(err);
+            }
+        }
     }
+
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed over to the spare engine, replayed %.1f ms of audio"),
+           InputBytesPerSecond > 0.0 ? ReplayedBytes / InputBytesPerSecond * 1000.0 : 0.0);
     return true;
 }
 
 // ========================================================
-// Update Animation Nodes for the local Player
+// Destroy an Engine and Player returned by FailOver
 // ========================================================
-bool FSGComManager::UpdateAnimation(float DeltaSeconds)
+void FSGComManager::DestroyFailedEngine(SG_COM_EngineHandle Engine, SG_COM_PlayerHandle Player)
 {
-    TotalTime += (DeltaSeconds * 1000.f); // Converts delta seconds to milliseconds
-
-    double MinTimeMs = 0;
-    double MaxTimeMs = 0;
-    SG_COM_Error err = SG_COM_GetPlayableRange(PlayerHandle, &MinTimeMs, &MaxTimeMs);
+    SG_COM_Error err = SG_COM_DestroyEngine(Engine);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get playable range: %d"), err);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy the failed engine: %d"), err);
         LogException(err);
-        return false;
     }
 
-    if (!bAnimationStarted && (MaxTimeMs - MinTimeMs) >= 20)
+    RetirePlayer(Player);
+}
+
+FSGTickWatchdog& FSGComManager::GetWatchdog()
+{
+    return Watchdog;
+}
+
+// ========================================================
+// Create the fan-out Players, each with its offset from
+// FanOutOffsetsMs
+// ========================================================
+bool FSGComManager::CreateFanOutPlayers()
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    if (Settings.FanOutPlayers <= 0) {
+        DestroyFanOutPlayers();
+        return true;
+    }
+
+    TArray<FString> Offsets;
+    Settings.FanOutOffsetsMs.ParseIntoArray(Offsets, TEXT(","));
+
+    FSGFanOutSetPtr NewSet = MakeShared<FSGFanOutSet, ESPMode::ThreadSafe>();
+    NewSet->Engine = EngineHandle;
+    bool bCreated = true;
+    for (int32 i = 0; i < Settings.FanOutPlayers; ++i) {
+        FSGFanOutPlayer FanOutPlayer;
+        SG_COM_Error err = SG_COM_CreatePlayer(&FanOutPlayerConfig, &FanOutPlayer.Player);
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create fan-out player %d: %d"), i + 1, err);
+            LogException(err);
+            bCreated = false;
+            break;
+        }
+
+        FanOutPlayer.OffsetMs = Offsets.IsValidIndex(i) ? FCString::Atod(*Offsets[i].TrimStartAndEnd()) : 0.0;
+        NewSet->Players.Add(FanOutPlayer);
+    }
+
+    // Swapped as a whole, a tick delivering a packet keeps the old set alive
+    FSGFanOutSetPtr OldSet;
     {
-        TotalTime = 0.f;
-        bAnimationStarted = true;
+        FScopeLock ScopeLock(&FanOutLock);
+        OldSet = FanOutSet;
+        FanOutSet = NewSet;
+        BindingGeneration++;
     }
-    
-    if (bAnimationStarted)
+    RetireFanOutSet(OldSet);
+
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Engine fans out to %d players"), NewSet->Players.Num() + 1);
+    return bCreated;
+}
+
+// ========================================================
+// Retire the fan-out Players
+// ========================================================
+void FSGComManager::DestroyFanOutPlayers()
+{
+    FSGFanOutSetPtr OldSet;
     {
-        double CurrentTimeMs;
-        err = SG_COM_UpdateAnimation(PlayerHandle, TotalTime, &CurrentTimeMs); // Attempts to update the animation
-        TotalTime = CurrentTimeMs; // Sets the time total to the clamped value
+        FScopeLock ScopeLock(&FanOutLock);
+        OldSet = FanOutSet;
+        FanOutSet.Reset();
+        BindingGeneration++;
+    }
+    RetireFanOutSet(OldSet);
+}
+
+FSGFanOutSetPtr FSGComManager::GetFanOutSet()
+{
+    FScopeLock ScopeLock(&FanOutLock);
+    return FanOutSet;
+}
+
+// ========================================================
+// Deliver a broadcast packet of the Engine to the fan-out
+// Players
+// ========================================================
+void FSGComManager::ReceiveBroadcast(SG_COM_EngineHandle Engine, const char* Packet, sg_size PacketBytes)
+{
+    // Packets of a spare or failed Engine are not part of the session
+    FSGFanOutSetPtr Set = GetFanOutSet();
+    if (!Set || Set->Engine != Engine) {
+        return;
+    }
 
+    FScopeLock ScopeLock(&Set->Lock);
+    for (const FSGFanOutPlayer& FanOutPlayer : Set->Players) {
+        SG_COM_Error err = SG_COM_ReceivePacket(FanOutPlayer.Player, Packet, PacketBytes);
         if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to update animation: %d"), err);
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to deliver a packet to a fan-out player: %d"), err);
             LogException(err);
-            return false;
         }
     }
+}
 
-    return true;
+// ========================================================
+// Update the fan-out Players to their offset from the
+// local Player
+// ========================================================
+void FSGComManager::UpdateFanOutPlayers()
+{
+    // Skipped for a frame rather than waiting on a tick stuck delivering a packet
+    FSGFanOutSetPtr Set = GetFanOutSet();
+    if (!Set || !Set->Lock.TryLock()) {
+        return;
+    }
+
+    for (FSGFanOutPlayer& FanOutPlayer : Set->Players) {
+        SG_COM_Error err = UpdatePlayer(FanOutPlayer.Player, FMath::Max(0.0, TotalTime - FanOutPlayer.OffsetMs), FanOutPlayer.TimeMs);
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to update a fan-out player: %d"), err);
+            LogException(err);
+        }
+    }
+    Set->Lock.Unlock();
+}
+
+int32 FSGComManager::GetNumPlayers()
+{
+    FSGFanOutSetPtr Set = GetFanOutSet();
+    return Set ? Set->Players.Num() + 1 : 1;
+}
+
+// ========================================================
+// Set how far a fan-out Player is shown behind the local
+// Player
+// ========================================================
+void FSGComManager::SetPlayerOffset(int32 PlayerIndex, double OffsetMs)
+{
+    FSGFanOutSetPtr Set = GetFanOutSet();
+    if (Set && Set->Players.IsValidIndex(PlayerIndex - 1)) {
+        FScopeLock ScopeLock(&Set->Lock);
+        Set->Players[PlayerIndex - 1].OffsetMs = OffsetMs;
+    }
+}
+
+// ========================================================
+// Destroy a Player after the animation of the current
+// frame
+// ========================================================
+void FSGComManager::RetirePlayer(SG_COM_PlayerHandle Player)
+{
+    if (Player) {
+        FSGRetiredPlayers& Retired = RetiredPlayers.AddDefaulted_GetRef();
+        Retired.Player = Player;
+        Retired.Frame = GFrameCounter;
+    }
+}
+
+void FSGComManager::RetireFanOutSet(FSGFanOutSetPtr Set)
+{
+    if (Set) {
+        FSGRetiredPlayers& Retired = RetiredPlayers.AddDefaulted_GetRef();
+        Retired.FanOutSet = Set;
+        Retired.Frame = GFrameCounter;
+    }
+}
+
+// ========================================================
+// Destroy the retired Players no thread can be reading
+// ========================================================
+void FSGComManager::DestroyRetiredPlayers(bool bAll)
+{
+    for (int32 i = RetiredPlayers.Num() - 1; i >= 0; --i) {
+        FSGRetiredPlayers& Retired = RetiredPlayers[i];
+
+        // The avatars evaluated during the frame it was retired in are done
+        // once the next frame started
+        if (!bAll && GFrameCounter <= Retired.Frame + 1) {
+            continue;
+        }
+
+        if (Retired.Player) {
+            SG_COM_Error err = SG_COM_DestroyPlayer(Retired.Player);
+            if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy a retired player: %d"), err);
+                LogException(err);
+            }
+        }
+
+        if (FSGFanOutSet* Set = Retired.FanOutSet.Get()) {
+            // Still delivering a packet from a stalled tick
+            if (!Set->Lock.TryLock()) {
+                if (bAll) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Leaked %d fan-out players of a stalled engine"), Set->Players.Num());
+                    RetiredPlayers.RemoveAtSwap(i);
+                }
+                continue;
+            }
+
+            for (const FSGFanOutPlayer& FanOutPlayer : Set->Players) {
+                SG_COM_Error err = SG_COM_DestroyPlayer(FanOutPlayer.Player);
+                if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy a fan-out player: %d"), err);
+                    LogException(err);
+                }
+            }
+            Set->Players.Reset();
+            Set->Lock.Unlock();
+        }
+
+        RetiredPlayers.RemoveAtSwap(i);
+    }
 }
 
 // ========================================================
-// Get the animation nodes for the local Player
+// Destroy the Engine
 // ========================================================
-bool FSGComManager::GetAnimationNodes(FAvatarInfo& AvatarInfo)
+bool FSGComManager::DestroyEngine()
 {
-    SG_COM_Error err = SG_COM_GetAnimationNodes(PlayerHandle, &AvatarInfo.AnimationNodes, &AvatarInfo.NumAnimationNodes);
+    FlushPendingAudio();
+    FSGComControlQueue::Get().UnregisterAvatar(AvatarId);
+
+    if (bSpareReady) {
+        DestroyFailedEngine(SpareEngineHandle, SparePlayerHandle);
+        SpareEngineHandle = nullptr;
+        SparePlayerHandle = nullptr;
+        bSpareReady = false;
+    }
+
+    SG_COM_Error err = SG_COM_DestroyEngine(EngineHandle);
     if (err != SG_COM_Error::SG_COM_ERROR_OK) {
-        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get animation nodes: %d"), err);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy the engine: %d"), err);
+        LogException(err);
+        return false;
+    }
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        bEngineReady = false;
+        EngineHandle = nullptr;
+    }
+    ChannelSnapshotIndex = INDEX_NONE;
+    DestroyFanOutPlayers();
+    DestroyRetiredPlayers(true);
+
+    err = SG_COM_DestroyPlayer(PlayerHandle);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to destroy the local player: %d"), err);
         LogException(err);
         return false;
     }
+    PlayerHandle = nullptr;
+
+    return false;
+}
+
+// ========================================================
+// Queue an array of audio data for input to the Engine
+// ========================================================
+bool FSGComManager::InputAudio(TArrayView<const uint8> AudioData, bool bNewUtterance, bool bEndOfUtterance)
+{
+    FSGAudioSpanReader Reader(MakeArrayView(&AudioData, 1));
+    return QueueInput(Reader, bNewUtterance, bEndOfUtterance) == AudioData.Num();
+}
+
+// ========================================================
+// Queue audio for many Engines in one call
+// ========================================================
+bool FSGComManager::InputAudioBatch(TArrayView<const FSGAudioInputBatch> Batches, TArray<SG_COM_Error>& OutResults)
+{
+    OutResults.SetNumUninitialized(Batches.Num(), false);
+
+    int32 NumFailed = 0;
+    int32 FirstFailed = INDEX_NONE;
+    for (int32 i = 0; i < Batches.Num(); ++i) {
+        const FSGAudioInputBatch& Batch = Batches[i];
+        FSGAudioSpanReader Reader(Batch.Spans);
+
+        SG_COM_Error err = SG_COM_Error::SG_COM_ERROR_OK;
+        if (Batch.Engine && Batch.Engine == EngineHandle) {
+            if (QueueInput(Reader, Batch.bNewUtterance, Batch.bEndOfUtterance) < Reader.GetTotalBytes()) {
+                err = SG_COM_Error::SG_COM_ERROR_LOW_MEMORY;
+            }
+        }
+        else {
+            // Held while queueing, so the feed is not unregistered and destroyed meanwhile
+            FScopeLock ScopeLock(&EngineFeedLock);
+            FSGEngineFeed* const* Feed = EngineFeeds.FindByPredicate([&Batch](const FSGEngineFeed* Each) {
+                return Each->GetEngine() == Batch.Engine;
+            });
+
+            if (!Feed || !Batch.Engine) {
+                err = SG_COM_Error::SG_COM_ERROR_INVALID_HANDLE;
+            }
+            else if ((*Feed)->Queue(Reader) < Reader.GetTotalBytes()) {
+                err = SG_COM_Error::SG_COM_ERROR_LOW_MEMORY;
+            }
+        }
+
+        OutResults[i] = err;
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            if (NumFailed == 0) {
+                FirstFailed = i;
+            }
+            NumFailed++;
+        }
+    }
+
+    // One log line for the whole batch
+    if (NumFailed > 0) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to queue audio for %d of %d engines, first error %d"), NumFailed, Batches.Num(), OutResults[FirstFailed]);
+        return false;
+    }
 
     return true;
 }
 
 // ========================================================
-// Check if the engine handle is valid
+// Register the feed of an Engine ticked outside the
+// manager
 // ========================================================
-bool FSGComManager::IsEngineValid()
+void FSGComManager::RegisterEngineFeed(FSGEngineFeed* Feed)
+{
+    FScopeLock ScopeLock(&EngineFeedLock);
+    EngineFeeds.AddUnique(Feed);
+}
+
+void FSGComManager::UnregisterEngineFeed(FSGEngineFeed* Feed)
+{
+    FScopeLock ScopeLock(&EngineFeedLock);
+    EngineFeeds.Remove(Feed);
+}
+
+// ========================================================
+// Queue audio for input to the Engine, starting the
+// utterance on bNewUtterance
+// ========================================================
+int32 FSGComManager::QueueInput(FSGAudioSpanReader& Reader, bool bNewUtterance, bool bEndOfUtterance)
+{
+    // An empty last part still ends the utterance being played
+    if (Reader.GetTotalBytes() == 0 && !(bEndOfUtterance && Playback.Load())) {
+        return 0;
+    }
+
+    const int32 Offset = QueueAudio(Reader, bNewUtterance, bEndOfUtterance, false);
+
+    // The new audio is appended after the last analysed frame
+    if (bNewUtterance) {
+        bUtteranceOpen = true;
+        bIdleLooping = false;
+
+        FScopeLock ScopeLock(&HistoryLock);
+        InputHistory.Reset();
+        HistoryStartBytes = 0;
+
+        UtteranceAnchorMs = LastMaxTimeMs.Load();
+        bAudioClockValid = false;
+        bUtteranceStarted = false;
+        if (InputBytesPerSecond > 0.0) {
+            BufferController.OnUtteranceInput(Offset / InputBytesPerSecond * 1000.0);
+        }
+    }
+
+    return Offset;
+}
+
+// ========================================================
+// Queue the audio of an utterance for playback only
+// ========================================================
+bool FSGComManager::PlayAudio(TArrayView<const uint8> AudioData)
+{
+    if (!Playback.Load()) {
+        return false;
+    }
+
+    FSGAudioSpanReader Reader(MakeArrayView(&AudioData, 1));
+    return QueueAudio(Reader, true, true, true) == AudioData.Num();
+}
+
+// ========================================================
+// Copy audio into pooled blocks
+// ========================================================
+int32 FSGComManager::QueueAudio(FSGAudioSpanReader& Reader, bool bNewUtterance, bool bEndOfUtterance, bool bPlaybackOnly)
 {
-    return EngineHandle != nullptr;
+    if (bNewUtterance) {
+        InputUtterance++;
+    }
+
+    // The next block is acquired before queueing one, so the last block
+    // queued is known to end the utterance even when the budget runs out
+    int32 Offset = 0;
+    bool bFirst = true;
+    FSGAudioBlock* Block = AudioPool.Acquire();
+    while (Block) {
+        const int32 NumBytes = Reader.Read(Block->Data, Block->Capacity);
+        Offset += NumBytes;
+
+        FSGAudioBlock* NextBlock = Reader.GetRemainingBytes() > 0 ? AudioPool.Acquire() : nullptr;
+        Block->Utterance = InputUtterance;
+        Block->bUtteranceStart = bNewUtterance && bFirst;
+        Block->bUtteranceEnd = bEndOfUtterance && !NextBlock;
+        bFirst = false;
+
+        if (bPlaybackOnly) {
+            Playback.Load()->Enqueue(Block);
+        }
+        else {
+            PendingBytes.Add(NumBytes);
+            PendingBlocks.Enqueue(Block);
+        }
+        Block = NextBlock;
+    }
+
+    if (Reader.GetRemainingBytes() > 0) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Audio pool budget exceeded, dropped %lld bytes of audio"), Reader.GetRemainingBytes());
+    }
+    return Offset;
+}
+
+// ========================================================
+// Set the playback the fed blocks are handed to
+// ========================================================
+void FSGComManager::SetPlayback(FSGAudioPlayback* InPlayback)
+{
+    if (InPlayback) {
+        InPlayback->Configure(&AudioPool, InputSampleType, (int32)InputBytesPerSecond);
+    }
+    Playback = InPlayback;
+}
+
+// ========================================================
+// Check if the latest utterance finished playing
+// ========================================================
+bool FSGComManager::TakePlaybackFinished()
+{
+    FSGAudioPlayback* Sink = Playback.Load();
+    return Sink && Sink->TakeFinished() == InputUtterance;
+}
+
+// ========================================================
+// Hand a block fed to the Engine to the playback
+// ========================================================
+void FSGComManager::ReleaseFedBlock(FSGAudioBlock* Block)
+{
+    if (FSGAudioPlayback* Sink = Playback.Load()) {
+        Sink->Enqueue(Block);
+    }
+    else {
+        AudioPool.Release(Block);
+    }
+}
+
+// ========================================================
+// Follow the position of the utterance being played
+// ========================================================
+void FSGComManager::UpdatePlaybackClock()
+{
+    FSGAudioPlayback* Sink = Playback.Load();
+    if (!Sink) {
+        return;
+    }
+
+    // Until the latest utterance starts playing, the previous one is still draining
+    uint32 Utterance = 0;
+    double PositionMs = 0.0;
+    double RenderTime = 0.0;
+    if (Sink->GetClock(Utterance, PositionMs, RenderTime) && Utterance == InputUtterance) {
+        FSGLatencyTracer::Get().Mark(ESGLatencyStage::AudioStart);
+        AudioClockMs = PositionMs;
+        AudioClockStamp = RenderTime;
+        bAudioClockValid = true;
+    }
+}
+
+// ========================================================
+// Input queued audio blocks while the Engine input buffer
+// has room
+// ========================================================
+bool FSGComManager::FeedEngine()
+{
+    const double FrameBytes = InputBytesPerSecond * FSGBufferController::FrameMs / 1000.0;
+    const double CapacityBytes = EngineBufferSec * InputBytesPerSecond;
+    double BufferedBytes = LastRemainingFrames * FrameBytes;
+
+    const double HangoverMs = FSGComSettings::Get().VadHangoverMs;
+
+    FSGAudioBlock* Block = nullptr;
+    while (PendingBlocks.Peek(Block) && (BufferedBytes <= 0.0 || BufferedBytes + Block->Data.Num() <= CapacityBytes)) {
+        const bool bSilent = ClassifyBlock(Block);
+        const double BlockMs = Block->Data.Num() * 1000.0 / InputBytesPerSecond;
+
+        // Empty blocks only mark the end of an utterance for the playback
+        bool bSkip = Block->Data.Num() == 0;
+        double RunMs = SilenceRunMs;
+        if (bVoiceGate && !bSkip) {
+            if (bSilent) {
+                RunMs += BlockMs;
+                bSkip = RunMs > HangoverMs;
+            }
+            else if (bGapSkipped && LastMaxTimeMs.Load() < UtteranceAnchorMs.Load() + FedUtteranceBytes * 1000.0 / InputBytesPerSecond) {
+                // Speech after a skipped gap waits until the idle animation reaches its time
+                break;
+            }
+            else {
+                RunMs = 0.0;
+            }
+        }
+
+        if (bSkip) {
+            if (Block->Data.Num() > 0) {
+                bGapSkipped = true;
+                UtteranceSkippedMs += BlockMs;
+
+                // Kept for a fail over, which replays by position in the utterance
+                RecordInput(Block->Data);
+            }
+        }
+        else {
+            SG_COM_Error err = SG_COM_InputAudio(EngineHandle, Block->Data.GetData(), Block->Data.Num());
+            if (err == SG_COM_Error::SG_COM_ERROR_INPUT_OVERRUN) {
+                // Try again once the engine has consumed more of its input
+                break;
+            }
+            if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to input audio: %d"), err);
+                LogException(err);
+            }
+            else {
+                RecordInput(Block->Data);
+            }
+
+            BufferedBytes += Block->Data.Num();
+            if (!bSilent) {
+                bGapSkipped = false;
+            }
+        }
+
+        SilenceRunMs = RunMs;
+        FedUtteranceBytes += Block->Data.Num();
+        if (Block->bUtteranceEnd) {
+            UtteranceEndMs = UtteranceAnchorMs.Load() + FedUtteranceBytes * 1000.0 / InputBytesPerSecond;
+            bUtteranceOpen = false;
+            if (bVoiceGate) {
+                ReportVoiceGate();
+            }
+        }
+
+        // Played even if the Engine rejected or skipped it
+        PendingBytes.Subtract(Block->Data.Num());
+        PendingBlocks.Pop();
+        ClassifiedBlock = nullptr;
+        ReleaseFedBlock(Block);
+    }
+    return BufferedBytes > 0.0;
+}
+
+// ========================================================
+// Check if a block is silent, classified the first time
+// it is peeked. Always false without the gate.
+// ========================================================
+bool FSGComManager::ClassifyBlock(const FSGAudioBlock* Block)
+{
+    if (Block == ClassifiedBlock) {
+        return bClassifiedSilent;
+    }
+
+    // Leading silence is skipped without a hangover
+    if (Block->bUtteranceStart) {
+        VoiceActivity.Reset();
+        FedUtteranceBytes = 0;
+        SilenceRunMs = FSGComSettings::Get().VadHangoverMs;
+        UtteranceSkippedMs = 0.0;
+        bGapSkipped = false;
+    }
+
+    ClassifiedBlock = Block;
+    bClassifiedSilent = bVoiceGate && VoiceActivity.IsSilent(Block->Data);
+    return bClassifiedSilent;
+}
+
+// ========================================================
+// Report the audio the gate skipped for the utterance that
+// ended
+// ========================================================
+void FSGComManager::ReportVoiceGate()
+{
+    const double InputMs = FedUtteranceBytes * 1000.0 / InputBytesPerSecond;
+    const double CpuSavedMs = AddVoiceGateMetrics(InputMs, UtteranceSkippedMs, 1);
+
+    SET_FLOAT_STAT(STAT_SGCom_VadSkipped, UtteranceSkippedMs);
+    SET_FLOAT_STAT(STAT_SGCom_VadCpuSaved, CpuSavedMs);
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Voice activity gate skipped %.0f of %.0f ms of audio, saving %.1f ms of engine time"),
+           UtteranceSkippedMs, InputMs, CpuSavedMs);
+}
+
+// ========================================================
+// Add audio the gate passed or skipped to the metrics
+// ========================================================
+double FSGComManager::AddVoiceGateMetrics(double InputMs, double SkippedMs, int32 NumUtterances)
+{
+    // Each skipped frame costs an idle tick instead of one analysing it
+    double CpuSavedMs = 0.0;
+    if (SkippedMs > 0.0 && NumAnalyseFrames > 0 && NumGatedFrames > 0) {
+        const double SavedPerFrameMs = (AnalyseTickSec / NumAnalyseFrames - GatedTickSec / NumGatedFrames) * 1000.0;
+        CpuSavedMs = FMath::Max(0.0, SavedPerFrameMs) * SkippedMs / FSGBufferController::FrameMs;
+    }
+
+    FScopeLock ScopeLock(&VoiceGateLock);
+    VoiceGateMetrics.NumUtterances += NumUtterances;
+    VoiceGateMetrics.InputMs += InputMs;
+    VoiceGateMetrics.SkippedMs += SkippedMs;
+    VoiceGateMetrics.CpuSavedMs += CpuSavedMs;
+    return CpuSavedMs;
+}
+
+// ========================================================
+// Keep the audio input for the current utterance, up to
+// what the Engine input buffer holds
+// ========================================================
+void FSGComManager::RecordInput(TArrayView<const uint8> Data)
+{
+    FScopeLock ScopeLock(&HistoryLock);
+    InputHistory.Append(Data.GetData(), Data.Num());
+
+    const int32 MaxBytes = (int32)(EngineBufferSec * InputBytesPerSecond);
+    const int32 Excess = InputHistory.Num() - MaxBytes;
+    if (Excess > 0 && Excess >= MaxBytes / 4) {
+        // Trimmed in steps rather than on every block
+        const int32 TrimBytes = Excess - Excess % InputBytesPerSample;
+        InputHistory.RemoveAt(0, TrimBytes, false);
+        HistoryStartBytes += TrimBytes;
+    }
+}
+
+// ========================================================
+// Input all complete blocks of captured audio
+// ========================================================
+bool FSGComManager::DrainCapture()
+{
+    FSGAudioCapture* Capture = CaptureSource.Load();
+    if (!Capture) {
+        return false;
+    }
+
+    const double HangoverMs = FSGComSettings::Get().VadHangoverMs;
+
+    bool bInput = false;
+    while (Capture->ReadBlock(CaptureBlock)) {
+        const double BlockMs = CaptureBlock.Num() * 1000.0 / InputBytesPerSecond;
+
+        // Live silence is skipped like silence in an utterance, the engine
+        // idles through it in real time
+        if (bVoiceGate && CaptureVoiceActivity.IsSilent(CaptureBlock)) {
+            CaptureSilenceRunMs += BlockMs;
+            bCaptureGapSkipped = CaptureSilenceRunMs > HangoverMs;
+            if (bCaptureGapSkipped) {
+                AddVoiceGateMetrics(BlockMs, BlockMs, 0);
+                continue;
+            }
+        }
+        else {
+            CaptureSilenceRunMs = 0.0;
+            bCaptureGapSkipped = false;
+        }
+
+        SG_COM_Error err = SG_COM_InputAudio(EngineHandle, CaptureBlock.GetData(), CaptureBlock.Num());
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to input captured audio: %d"), err);
+            LogException(err);
+            break;
+        }
+        if (bVoiceGate) {
+            AddVoiceGateMetrics(BlockMs, 0.0, 0);
+        }
+        bInput = true;
+    }
+    return bInput;
+}
+
+// ========================================================
+// Stop playing the audio of the current utterance
+// ========================================================
+void FSGComManager::FlushPlayback()
+{
+    if (FSGAudioPlayback* Sink = Playback.Load()) {
+        Sink->Flush(InputUtterance);
+    }
+}
+
+// ========================================================
+// Interrupt the current utterance
+// ========================================================
+bool FSGComManager::Interrupt()
+{
+    SnapshotPose();
+
+    // Back to the local Player
+    FinishPreAnalysed();
+
+    // Drop the audio that was not analysed or played yet
+    FlushPendingAudio();
+    FlushPlayback();
+
+    SG_COM_Error err = SG_COM_Reset(EngineHandle);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to reset the engine: %d"), err);
+        LogException(err);
+        return false;
+    }
+
+    LastRemainingFrames = 0;
+    LastTickTime = 0.0;
+    bAudioClockValid = false;
+
+    // Skip the animation buffered for the interrupted utterance
+    TotalTime = FMath::Max(TotalTime, LastMaxTimeMs.Load());
+    UtteranceAnchorMs = LastMaxTimeMs.Load();
+
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Interrupted the current utterance"));
+    return true;
+}
+
+// ========================================================
+// Snapshot the pose being shown to cross-fade from
+// ========================================================
+void FSGComManager::SnapshotPose()
+{
+    FAvatarInfo AvatarInfo;
+    if (GetAnimationNodes(AvatarInfo)) {
+        FScopeLock ScopeLock(&CrossfadeLock);
+        CrossfadeSnapshot.Reset();
+        for (sg_size i = 0; i < AvatarInfo.NumAnimationNodes; ++i) {
+            CrossfadeSnapshot.Append(AvatarInfo.AnimationNodes[i].channel_values, AvatarInfo.AnimationNodes[i].num_channels);
+        }
+        CrossfadeSerial++;
+        CrossfadeStartTime = FPlatformTime::Seconds();
+    }
+}
+
+// ========================================================
+// Measure the barge-in latency until the animation of the
+// next utterance starts
+// ========================================================
+void FSGComManager::MarkBargeIn(double RequestTime)
+{
+    BargeInRequestTime = RequestTime;
+}
+
+// ========================================================
+// Get the pose to cross-fade from after an interrupt
+// ========================================================
+bool FSGComManager::GetCrossfade(uint32& InOutSerial, TArray<float>& OutSnapshot, float& OutWeight)
+{
+    const double CrossfadeSec = FSGComSettings::Get().InterruptCrossfadeMs / 1000.0;
+
+    FScopeLock ScopeLock(&CrossfadeLock);
+    const double Elapsed = FPlatformTime::Seconds() - CrossfadeStartTime;
+    if (CrossfadeSerial == 0 || CrossfadeSec <= 0.0 || Elapsed >= CrossfadeSec) {
+        OutWeight = 0.f;
+        return false;
+    }
+
+    if (InOutSerial != CrossfadeSerial) {
+        OutSnapshot = CrossfadeSnapshot;
+        InOutSerial = CrossfadeSerial;
+    }
+    OutWeight = (float)(1.0 - Elapsed / CrossfadeSec);
+    return true;
+}
+
+// ========================================================
+// Set the source of live audio
+// ========================================================
+void FSGComManager::SetCaptureSource(FSGAudioCapture* Source)
+{
+    if (Source) {
+        bIdleLooping = false;
+    }
+    CaptureSource = Source;
+}
+
+// ========================================================
+// Set whether the Engine moves as if speaking or listening
+// ========================================================
+bool FSGComManager::SetRole(SG_COM_EngineRole Role)
+{
+    // Queued, the Engine may be ticking on the processing thread
+    FSGComControlQueue::Get().SetRole(AvatarId, Role);
+    return true;
+}
+
+// ========================================================
+// Set the mood of the Engine
+// ========================================================
+bool FSGComManager::SetMood(const FString& Mood)
+{
+    FSGComControlQueue::Get().SetMood(AvatarId, Mood);
+    return true;
+}
+
+// ========================================================
+// Set an Engine control
+// ========================================================
+bool FSGComManager::SetEngineControl(SG_COM_EngineControl Control, float Value)
+{
+    FSGComControlQueue::Get().SetEngineControl(AvatarId, Control, Value);
+    return true;
+}
+
+// ========================================================
+// Apply the controls, mood and role set since the last tick
+// ========================================================
+int32 FSGComManager::ApplyControls()
+{
+    return FSGComControlQueue::Get().Apply(EngineHandle);
+}
+
+// ========================================================
+// Return all queued audio blocks to the pool
+// ========================================================
+void FSGComManager::FlushPendingAudio()
+{
+    FSGAudioBlock* Block = nullptr;
+    while (PendingBlocks.Dequeue(Block)) {
+        PendingBytes.Subtract(Block->Data.Num());
+        AudioPool.Release(Block);
+    }
+    ClassifiedBlock = nullptr;
+    bGapSkipped = false;
+    bUtteranceOpen = false;
+}
+
+// ========================================================
+// Process any audio in the Engine input buffer
+// ========================================================
+bool FSGComManager::ProcessAudio(int* RemainingFrames_out)
+{
+    int ProcessedFrames = 0;
+    int RemainingFrames = 1;
+    SG_COM_Error err = SG_COM_Error::SG_COM_ERROR_OK;
+
+    const bool bCaptured = DrainCapture();
+    const bool bBuffered = FeedEngine() || bCaptured || LastRemainingFrames.Load() > 0;
+    ApplyControls();
+
+    // The avatars play the shared idle loops instead of idle from the Engine
+    if (bIdleLooping) {
+        if (RemainingFrames_out) {
+            *RemainingFrames_out = 0;
+        }
+        return true;
+    }
+
+    const SG_COM_EngineHandle Engine = EngineHandle;
+    const double StartTime = FPlatformTime::Seconds();
+    Watchdog.BeginTick();
+    err = SG_COM_ProcessTick(Engine, &ProcessedFrames, &RemainingFrames);
+    const double BusySeconds = FPlatformTime::Seconds() - StartTime;
+
+    // The session moved onto the spare Engine while this tick stalled
+    FScopeLock TickScopeLock(&TickLock);
+    if (Engine != EngineHandle) {
+        return false;
+    }
+    Watchdog.EndTick(err);
+    LastRemainingFrames = RemainingFrames;
+
+    // Tick time with input to analyse, and while idling through skipped
+    // audio, give the engine time the gate saves
+    if (bVoiceGate && bBuffered) {
+        AnalyseTickSec += BusySeconds;
+        NumAnalyseFrames += FMath::Max(ProcessedFrames, 1);
+    }
+    else if (bVoiceGate && (bGapSkipped || bCaptureGapSkipped)) {
+        GatedTickSec += BusySeconds;
+        NumGatedFrames += FMath::Max(ProcessedFrames, 1);
+    }
+
+    if (LastTickTime > 0.0) {
+        BufferController.OnTick(BusySeconds, StartTime - LastTickTime, ProcessedFrames);
+    }
+    if (ProcessedFrames > 0) {
+        FSGLatencyTracer::Get().Mark(ESGLatencyStage::FirstProcessed);
+    }
+    LastTickTime = StartTime;
+
+    if (RemainingFrames_out) {
+        // Include the audio still waiting to be fed
+        const double FrameBytes = InputBytesPerSecond * FSGBufferController::FrameMs / 1000.0;
+        const int64 Pending = PendingBytes.GetValue();
+        *RemainingFrames_out = RemainingFrames + (Pending > 0 && FrameBytes > 0.0 ? FMath::CeilToInt(Pending / FrameBytes) : 0);
+    }
+
+    // Running out of input before the end of the utterance was fed starves
+    // the Player, an underrun that is recovered from by stretching the
+    // animation. After the end, or through silence the gate skipped, the
+    // engine idles as expected.
+    if (err == SG_COM_Error::SG_COM_ERROR_INPUT_UNDERRUN) {
+        if (HasUnanalysedInput() && !bGapSkipped) {
+            BufferController.OnUnderrun();
+        }
+        return true;
+    }
+
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Process tick failed: %d"), err);
+        LogException(err);
+        return false;
+    }
+    return true;
+}
+
+// ========================================================
+// Check if the current utterance has audio the Engine has
+// not analysed yet
+// ========================================================
+bool FSGComManager::HasUnanalysedInput()
+{
+    return bUtteranceOpen || PendingBytes.GetValue() > 0 || LastRemainingFrames.Load() > 0;
+}
+
+// ========================================================
+// Update Animation Nodes for the local Player
+// ========================================================
+bool FSGComManager::UpdateAnimation(float DeltaSeconds)
+{
+    const bool bUpdated = UpdatePlayers(DeltaSeconds);
+
+    // Published even when paused or failed, the animation threads only read the snapshot
+    PublishChannelSnapshot();
+    return bUpdated;
+}
+
+// ========================================================
+// Update the local, fan-out and pre-analysed Players
+// ========================================================
+bool FSGComManager::UpdatePlayers(float DeltaSeconds)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    const double DeltaMs = (double)DeltaSeconds * 1000.0; // Converts delta seconds to milliseconds
+
+    DestroyRetiredPlayers(false);
+
+    // Nothing to update while the Player is paused
+    UpdateIdleLooping();
+    if (bIdleLooping) {
+        return true;
+    }
+
+    double MinTimeMs = 0;
+    double MaxTimeMs = 0;
+    SG_COM_Error err = SG_COM_GetPlayableRange(PlayerHandle, &MinTimeMs, &MaxTimeMs);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get playable range: %d"), err);
+        LogException(err);
+        return false;
+    }
+    LastMaxTimeMs = MaxTimeMs;
+    UpdatePlaybackClock();
+
+    const double StartThresholdMs = BufferController.GetStartThresholdMs();
+    if (!bAnimationStarted && (MaxTimeMs - MinTimeMs) >= StartThresholdMs)
+    {
+        TotalTime = 0.0;
+        bAnimationStarted = true;
+    }
+
+    if (!bUtteranceStarted && (MaxTimeMs - UtteranceAnchorMs.Load()) >= StartThresholdMs)
+    {
+        bUtteranceStarted = true;
+        BufferController.OnAnimationStarted();
+        FSGLatencyTracer::Get().Mark(ESGLatencyStage::StartThreshold);
+
+        if (BargeInRequestTime > 0.0) {
+            const double BargeInLatencyMs = (FPlatformTime::Seconds() - BargeInRequestTime) * 1000.0;
+            SET_FLOAT_STAT(STAT_SGCom_BargeInLatency, BargeInLatencyMs);
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Barge-in latency %.1f ms"), BargeInLatencyMs);
+            BargeInRequestTime = 0.0;
+        }
+    }
+    
+    if (bAnimationStarted)
+    {
+        // Slow down when the buffered animation runs low rather than freezing,
+        // only while more of the utterance is to be analysed. Its tail plays
+        // at full speed.
+        const bool bMoreInput = HasUnanalysedInput();
+        const double PlaybackRate = bMoreInput ? BufferController.GetPlaybackRate(MaxTimeMs - TotalTime) : 1.0;
+        double TargetTimeMs = TotalTime + DeltaMs * PlaybackRate;
+
+        // The audio clock belongs to the pre-analysed utterance while one plays
+        const bool bAudioPlaying = bAudioClockValid && !PreAnalysedPlayer;
+        const bool bFollowAudio = Settings.ClockSyncMode == ESGClockSyncMode::AudioClock && bAudioPlaying;
+        const double AudioTimeMs = bFollowAudio ? GetAudioClockMs(UtteranceAnchorMs.Load()) : 0.0;
+        if (bFollowAudio) {
+            TargetTimeMs = SlewToAudioClock(TargetTimeMs, AudioTimeMs, DeltaMs);
+        }
+
+        double CurrentTimeMs;
+        err = UpdatePlayer(PlayerHandle, TargetTimeMs, CurrentTimeMs); // Attempts to update the animation
+        TotalTime = CurrentTimeMs; // Sets the time total to the clamped value
+
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to update animation: %d"), err);
+            LogException(err);
+            return false;
+        }
+
+        if (bFollowAudio) {
+            AVOffsetMs = TotalTime - AudioTimeMs;
+            SET_FLOAT_STAT(STAT_SGCom_AVOffset, AVOffsetMs);
+        }
+
+        // Clamped to the playable range while the audio is still playing
+        if (bAudioPlaying && bMoreInput && CurrentTimeMs < TargetTimeMs - 1.0) {
+            BufferController.OnUnderrun();
+        }
+
+        UpdateFanOutPlayers();
+    }
+
+    if (PreAnalysedPlayer && !UpdatePreAnalysed(DeltaMs)) {
+        return false;
+    }
+
+    const FSGBufferMetrics Metrics = BufferController.GetMetrics();
+    SET_FLOAT_STAT(STAT_SGCom_RealtimeFactor, Metrics.RealtimeFactor);
+    SET_FLOAT_STAT(STAT_SGCom_StartThreshold, Metrics.StartThresholdMs);
+    SET_FLOAT_STAT(STAT_SGCom_StartLatency, Metrics.LastStartLatencyMs);
+    SET_DWORD_STAT(STAT_SGCom_Underruns, Metrics.NumUnderruns);
+
+    return true;
+}
+
+// ========================================================
+// Check if the avatars play the shared idle loops
+// ========================================================
+bool FSGComManager::IsIdleLooping()
+{
+    return bIdleLooping;
+}
+
+// ========================================================
+// Pause the Engine on the shared idle loops while there is
+// nothing to animate
+// ========================================================
+void FSGComManager::UpdateIdleLooping()
+{
+    if (FSGComSettings::Get().IdleLoops <= 0) {
+        return;
+    }
+
+    if (!bIdleLoopsReady) {
+        bIdleLoopsReady = FSGIdleLoopCache::Get().Find(CharacterHash, AnimationType).IsValid();
+    }
+
+    // Idle once the animation of the last utterance played and no audio is waiting
+    const bool bIdle = bIdleLoopsReady
+                    && bAnimationStarted
+                    && !bUtteranceOpen
+                    && PendingBytes.GetValue() == 0
+                    && LastRemainingFrames == 0
+                    && !PreAnalysedPlayer
+                    && !CaptureSource.Load()
+                    && TotalTime >= UtteranceEndMs;
+    bIdleLooping = bIdle;
+}
+
+// ========================================================
+// Get the animation nodes for a Player. A pre-analysed
+// utterance is shown on all of them.
+// ========================================================
+bool FSGComManager::GetAnimationNodes(FAvatarInfo& AvatarInfo, int32 PlayerIndex)
+{
+    // Handles read under the lock, a retired Player stays alive until the
+    // frame after the generation changed
+    SG_COM_PlayerHandle Player = nullptr;
+    FSGFanOutSetPtr Set;
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        Player = PreAnalysedPlayer ? PreAnalysedPlayer : PlayerHandle;
+        if (!PreAnalysedPlayer && PlayerIndex > 0) {
+            Set = FanOutSet;
+            Player = nullptr;
+        }
+    }
+
+    SG_COM_Error err = SG_COM_Error::SG_COM_ERROR_OK;
+    if (Set) {
+        if (!Set->Players.IsValidIndex(PlayerIndex - 1)) {
+            return false;
+        }
+        FScopeLock ScopeLock(&Set->Lock);
+        err = SG_COM_GetAnimationNodes(Set->Players[PlayerIndex - 1].Player, &AvatarInfo.AnimationNodes, &AvatarInfo.NumAnimationNodes);
+    }
+    else if (!Player) {
+        return false;
+    }
+    else {
+        err = SG_COM_GetAnimationNodes(Player, &AvatarInfo.AnimationNodes, &AvatarInfo.NumAnimationNodes);
+    }
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get animation nodes: %d"), err);
+        LogException(err);
+        return false;
+    }
+
+    return true;
+}
+
+// ========================================================
+// Copy the channel values of all Players into the
+// snapshot buffer not published, then publish it
+// ========================================================
+void FSGComManager::PublishChannelSnapshot()
+{
+    const int32 Published = ChannelSnapshotIndex.Load();
+    const int32 Back = Published == 0 ? 1 : 0;
+    TArray<float>& Values = ChannelSnapshot[Back];
+    TArray<int32>& Offsets = ChannelSnapshotOffsets[Back];
+    Values.Reset();
+    Offsets.Reset();
+
+    FSGFanOutSetPtr Set;
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        Set = PreAnalysedPlayer ? nullptr : FanOutSet;
+        bChannelSnapshotShared[Back] = PreAnalysedPlayer != nullptr;
+    }
+
+    const int32 NumPlayers = Set ? Set->Players.Num() + 1 : 1;
+    for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers; ++PlayerIndex) {
+        Offsets.Add(Values.Num());
+
+        // A fan-out Player skipped while a tick delivers a packet keeps its last values
+        if (PlayerIndex > 0 && !Set->Lock.TryLock()) {
+            const TArray<int32>* LastOffsets = Published != INDEX_NONE ? &ChannelSnapshotOffsets[Published] : nullptr;
+            if (LastOffsets && LastOffsets->IsValidIndex(PlayerIndex + 1)) {
+                const int32 First = (*LastOffsets)[PlayerIndex];
+                Values.Append(ChannelSnapshot[Published].GetData() + First, (*LastOffsets)[PlayerIndex + 1] - First);
+            }
+            continue;
+        }
+
+        FAvatarInfo AvatarInfo;
+        SG_COM_Error err = SG_COM_Error::SG_COM_ERROR_OK;
+        if (PlayerIndex > 0) {
+            err = SG_COM_GetAnimationNodes(Set->Players[PlayerIndex - 1].Player, &AvatarInfo.AnimationNodes, &AvatarInfo.NumAnimationNodes);
+            Set->Lock.Unlock();
+        }
+        else if (PreAnalysedPlayer || PlayerHandle) {
+            err = SG_COM_GetAnimationNodes(PreAnalysedPlayer ? PreAnalysedPlayer : PlayerHandle, &AvatarInfo.AnimationNodes, &AvatarInfo.NumAnimationNodes);
+        }
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get animation nodes: %d"), err);
+            LogException(err);
+            continue;
+        }
+
+        for (sg_size i = 0; i < AvatarInfo.NumAnimationNodes; ++i) {
+            Values.Append(AvatarInfo.AnimationNodes[i].channel_values, AvatarInfo.AnimationNodes[i].num_channels);
+        }
+    }
+    Offsets.Add(Values.Num());
+
+    ChannelSnapshotIndex = Back;
+}
+
+// ========================================================
+// Channel values of a Player from the published snapshot
+// ========================================================
+const float* FSGComManager::GetChannelSnapshot(int32 PlayerIndex, int32& OutNumChannels)
+{
+    const int32 Index = ChannelSnapshotIndex.Load();
+    if (Index == INDEX_NONE) {
+        return nullptr;
+    }
+
+    // Every Player shows the pre-analysed utterance, snapshotted as the local one
+    const TArray<int32>& Offsets = ChannelSnapshotOffsets[Index];
+    if (bChannelSnapshotShared[Index]) {
+        PlayerIndex = 0;
+    }
+    if (PlayerIndex < 0 || PlayerIndex + 1 >= Offsets.Num()) {
+        return nullptr;
+    }
+
+    OutNumChannels = Offsets[PlayerIndex + 1] - Offsets[PlayerIndex];
+    return ChannelSnapshot[Index].GetData() + Offsets[PlayerIndex];
+}
+
+// ========================================================
+// Content hash of the character file
+// ========================================================
+const FString& FSGComManager::GetCharacterHash()
+{
+    return CharacterHash;
+}
+
+SG_AnimationType FSGComManager::GetAnimationType()
+{
+    return AnimationType;
+}
+
+// ========================================================
+// Update a Player, recording the time it took
+// ========================================================
+SG_COM_Error FSGComManager::UpdatePlayer(SG_COM_PlayerHandle Player, double TargetTimeMs, double& OutCurrentTimeMs)
+{
+    SCOPE_CYCLE_COUNTER(STAT_SGCom_PlayerUpdate);
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    const SG_COM_Error err = SG_COM_UpdateAnimation(Player, TargetTimeMs, &OutCurrentTimeMs);
+
+    NumPlayerUpdates.Increment();
+    PlayerUpdateCycles.Add((int64)(FPlatformTime::Cycles64() - StartCycles));
+    return err;
+}
+
+// ========================================================
+// Record the cycles an avatar took to apply one frame
+// ========================================================
+void FSGComManager::AddAvatarCost(uint64 Cycles)
+{
+    NumAvatarFrames.Increment();
+    AvatarApplyCycles.Add((int64)Cycles);
+}
+
+// ========================================================
+// CPU time spent animating since the session started
+// ========================================================
+FSGAnimationCost FSGComManager::GetAnimationCost()
+{
+    FSGAnimationCost Cost;
+    Cost.NumPlayerUpdates = NumPlayerUpdates.GetValue();
+    Cost.PlayerUpdateSec = FPlatformTime::ToSeconds64(PlayerUpdateCycles.GetValue());
+    Cost.NumAvatarFrames = NumAvatarFrames.GetValue();
+    Cost.AvatarApplySec = FPlatformTime::ToSeconds64(AvatarApplyCycles.GetValue());
+    return Cost;
+}
+
+// ========================================================
+// Changes whenever the Player returned by GetAnimationNodes
+// changes
+// ========================================================
+uint32 FSGComManager::GetBindingGeneration()
+{
+    return BindingGeneration.Load();
+}
+
+// ========================================================
+// Play the animation buffered in a pre-analysed Player
+// ========================================================
+void FSGComManager::PlayPreAnalysed(SG_COM_PlayerHandle Player, double StartTimeMs)
+{
+    bIdleLooping = false;
+
+    FinishPreAnalysed();
+    {
+        FScopeLock ScopeLock(&FanOutLock);
+        PreAnalysedPlayer = Player;
+        BindingGeneration++;
+    }
+    PreAnalysedStartMs = StartTimeMs;
+    PreAnalysedTimeMs = StartTimeMs;
+    bAudioClockValid = false;
+
+    // The animation is already buffered, so it starts right away
+    if (BargeInRequestTime > 0.0) {
+        const double BargeInLatencyMs = (FPlatformTime::Seconds() - BargeInRequestTime) * 1000.0;
+        SET_FLOAT_STAT(STAT_SGCom_BargeInLatency, BargeInLatencyMs);
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Barge-in latency %.1f ms"), BargeInLatencyMs);
+        BargeInRequestTime = 0.0;
+    }
+}
+
+// ========================================================
+// Check if a pre-analysed utterance is being played
+// ========================================================
+bool FSGComManager::IsPlayingPreAnalysed()
+{
+    return PreAnalysedPlayer != nullptr;
+}
+
+// ========================================================
+// Take the Player of a pre-analysed utterance that
+// finished playing
+// ========================================================
+SG_COM_PlayerHandle FSGComManager::TakeFinishedPlayer()
+{
+    // The avatars evaluated during the frame it finished in are done once
+    // the next frame started
+    for (int32 i = 0; i < FinishedPlayers.Num(); ++i) {
+        if (GFrameCounter > FinishedPlayers[i].Frame + 1) {
+            SG_COM_PlayerHandle Player = FinishedPlayers[i].Player;
+            FinishedPlayers.RemoveAt(i);
+            return Player;
+        }
+    }
+
+    return nullptr;
+}
+
+// ========================================================
+// Go back to the local Player
+// ========================================================
+void FSGComManager::FinishPreAnalysed()
+{
+    if (!PreAnalysedPlayer) {
+        return;
+    }
+
+    FScopeLock ScopeLock(&FanOutLock);
+    FSGRetiredPlayers& Finished = FinishedPlayers.AddDefaulted_GetRef();
+    Finished.Player = PreAnalysedPlayer;
+    Finished.Frame = GFrameCounter;
+    PreAnalysedPlayer = nullptr;
+    BindingGeneration++;
+}
+
+// ========================================================
+// Update the animation of the pre-analysed utterance
+// ========================================================
+bool FSGComManager::UpdatePreAnalysed(double DeltaMs)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+
+    double MinTimeMs = 0;
+    double MaxTimeMs = 0;
+    SG_COM_Error err = SG_COM_GetPlayableRange(PreAnalysedPlayer, &MinTimeMs, &MaxTimeMs);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to get pre-analysed playable range: %d"), err);
+        LogException(err);
+        return false;
+    }
+
+    double TargetTimeMs = PreAnalysedTimeMs + DeltaMs;
+    const bool bFollowAudio = Settings.ClockSyncMode == ESGClockSyncMode::AudioClock && bAudioClockValid;
+    const double AudioTimeMs = bFollowAudio ? GetAudioClockMs(PreAnalysedStartMs) : 0.0;
+    if (bFollowAudio) {
+        TargetTimeMs = SlewToAudioClock(TargetTimeMs, AudioTimeMs, DeltaMs);
+    }
+
+    double CurrentTimeMs;
+    err = UpdatePlayer(PreAnalysedPlayer, TargetTimeMs, CurrentTimeMs);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to update pre-analysed animation: %d"), err);
+        LogException(err);
+        return false;
+    }
+    PreAnalysedTimeMs = CurrentTimeMs;
+
+    if (bFollowAudio) {
+        AVOffsetMs = CurrentTimeMs - AudioTimeMs;
+        SET_FLOAT_STAT(STAT_SGCom_AVOffset, AVOffsetMs);
+    }
+
+    // Back to the local Player once all of the analysed animation played
+    if (CurrentTimeMs >= MaxTimeMs) {
+        FinishPreAnalysed();
+    }
+
+    return true;
+}
+
+// ========================================================
+// Check if the engine handle is valid
+// ========================================================
+bool FSGComManager::IsEngineValid()
+{
+    return bEngineReady.Load();
+}
+
+// ========================================================
+// Get the handle of the Engine
+// ========================================================
+SG_COM_EngineHandle FSGComManager::GetEngineHandle()
+{
+    return EngineHandle;
+}
+
+// ========================================================
+// Report the playback position of the audio for the
+// current utterance
+// ========================================================
+void FSGComManager::SetAudioClock(double PlaybackTimeMs)
+{
+    AudioClockMs = PlaybackTimeMs;
+    AudioClockStamp = FPlatformTime::Seconds();
+    bAudioClockValid = true;
+}
+
+// ========================================================
+// Stop following the audio clock
+// ========================================================
+void FSGComManager::ClearAudioClock()
+{
+    bAudioClockValid = false;
+}
+
+// ========================================================
+// Get the last measured offset between animation and audio
+// ========================================================
+double FSGComManager::GetAVOffsetMs()
+{
+    return AVOffsetMs;
+}
+
+// ========================================================
+// Get the controller adapting the startup buffering
+// ========================================================
+FSGBufferController& FSGComManager::GetBufferController()
+{
+    return BufferController;
+}
+
+// ========================================================
+// Get the audio withheld from the Engine by the voice
+// activity gate
+// ========================================================
+FSGVoiceGateMetrics FSGComManager::GetVoiceGateMetrics()
+{
+    FScopeLock ScopeLock(&VoiceGateLock);
+    return VoiceGateMetrics;
+}
+
+// ========================================================
+// Get the memory held for the Engine and the local Player
+// ========================================================
+FSGMemoryReport FSGComManager::GetMemoryReport()
+{
+    FSGMemoryReport Report;
+    if (!IsEngineValid()) {
+        return Report;
+    }
+
+    // The player buffers one value per channel per frame
+    int64 NumChannels = 0;
+    FAvatarInfo AvatarInfo;
+    if (GetAnimationNodes(AvatarInfo)) {
+        for (sg_size i = 0; i < AvatarInfo.NumAnimationNodes; ++i) {
+            NumChannels += AvatarInfo.AnimationNodes[i].num_channels;
+        }
+    }
+    const double FramesPerSecond = 1000.0 / FSGBufferController::FrameMs;
+
+    const int64 PlayerBytes = (int64)(PlayerBufferSec * FramesPerSecond * NumChannels * sizeof(float));
+
+    Report.CharacterFileBytes = CharacterFileBytes;
+    Report.EngineInputBytes = (int64)(EngineBufferSec * InputBytesPerSecond);
+    Report.PlayerOutputBytes = PlayerBytes * GetNumPlayers();
+    Report.AudioPoolAllocatedBytes = AudioPool.GetAllocatedBytes();
+    Report.AudioPoolInUseBytes = AudioPool.GetInUseBytes();
+
+    // The spare holds a second copy of the character data and buffers
+    if (bSpareReady) {
+        Report.SpareEngineBytes = Report.CharacterFileBytes + Report.EngineInputBytes + PlayerBytes;
+    }
+    return Report;
+}
+
+// ========================================================
+// Log the memory held for the Engine and the local Player
+// ========================================================
+void FSGComManager::LogMemoryReport()
+{
+    const FSGMemoryReport Report = GetMemoryReport();
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Memory %.2f MB (character %.2f MB, engine input %.2f MB, player output %.2f MB, audio pool %.2f MB with %.2f MB in use, spare engine %.2f MB)"),
+           Report.GetTotalBytes() / (1024.0 * 1024.0),
+           Report.CharacterFileBytes / (1024.0 * 1024.0),
+           Report.EngineInputBytes / (1024.0 * 1024.0),
+           Report.PlayerOutputBytes / (1024.0 * 1024.0),
+           Report.AudioPoolAllocatedBytes / (1024.0 * 1024.0),
+           Report.AudioPoolInUseBytes / (1024.0 * 1024.0),
+           Report.SpareEngineBytes / (1024.0 * 1024.0));
+}
+
+// ========================================================
+// Get the extrapolated audio clock in player time
+// ========================================================
+double FSGComManager::GetAudioClockMs(double AnchorMs)
+{
+    // Playback positions are only reported once per audio buffer, so
+    // extrapolate with the wall clock in between
+    const double SinceReportMs = (FPlatformTime::Seconds() - AudioClockStamp) * 1000.0;
+    return AnchorMs + AudioClockMs + SinceReportMs - FSGComSettings::Get().AudioLatencyMs;
+}
+
+// ========================================================
+// Slew towards the audio clock instead of jumping, unless
+// the error is large
+// ========================================================
+double FSGComManager::SlewToAudioClock(double TargetTimeMs, double AudioTimeMs, double DeltaMs)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+
+    const double ErrorMs = AudioTimeMs - TargetTimeMs;
+    if (FMath::Abs(ErrorMs) > Settings.ClockSnapThresholdMs) {
+        return AudioTimeMs;
+    }
+
+    const double MaxSlewMs = DeltaMs * Settings.ClockSlewRate;
+    return TargetTimeMs + FMath::Clamp(ErrorMs, -MaxSlewMs, MaxSlewMs);
 }
 
 // ========================================================
@@ -3,10 +3,106 @@
 #pragma once
 
 #include "CommonStructs.h"
+#include "SGAudioBufferPool.h"
+#include "SGAudioCapture.h"
+#include "SGAudioPlayback.h"
+#include "SGBufferController.h"
+#include "SGEngineFeed.h"
+#include "SGTickWatchdog.h"
+#include "SGVoiceActivity.h"
 #include "SG_Com.h"
 
 #include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Stats/Stats.h"
 
+DECLARE_STATS_GROUP(TEXT("SG_Com"), STATGROUP_SGCom, STATCAT_Advanced);
+
+// Log the exception text after SG_COM_ERROR_EXCEPTION
+void LogException(SG_COM_Error err);
+
+// Memory held for an engine and its player
+struct FSGMemoryReport
+{
+    int64 CharacterFileBytes = 0;
+    int64 EngineInputBytes = 0;
+    int64 PlayerOutputBytes = 0;
+    int64 AudioPoolAllocatedBytes = 0;
+    int64 AudioPoolInUseBytes = 0;
+
+    // Character, input and output of the warm spare Engine and its Player
+    int64 SpareEngineBytes = 0;
+
+    int64 GetTotalBytes() const
+    {
+        return CharacterFileBytes + EngineInputBytes + PlayerOutputBytes + AudioPoolAllocatedBytes + SpareEngineBytes;
+    }
+};
+
+// CPU time spent animating since the session started
+struct FSGAnimationCost
+{
+    int64 NumPlayerUpdates = 0;
+    double PlayerUpdateSec = 0.0;
+    int64 NumAvatarFrames = 0;
+    double AvatarApplySec = 0.0;
+};
+
+// Audio withheld from the Engine by the voice activity gate, over the session
+struct FSGVoiceGateMetrics
+{
+    int32 NumUtterances = 0;
+    double InputMs = 0.0;
+    double SkippedMs = 0.0;
+
+    // Engine time saved, from the measured tick time with and without input
+    double CpuSavedMs = 0.0;
+};
+
+// Player fed the broadcast packets of the Engine, shown OffsetMs behind the local Player
+struct FSGFanOutPlayer
+{
+    SG_COM_PlayerHandle Player = nullptr;
+    double OffsetMs = 0.0;
+    double TimeMs = 0.0;
+};
+
+// Players fed the broadcast packets of one Engine. Replaced as a whole when
+// the Engine changes, a set is kept alive by the threads still using it.
+struct FSGFanOutSet
+{
+    SG_COM_EngineHandle Engine = nullptr;
+
+    // Held while a packet is delivered or the Players are updated
+    FCriticalSection Lock;
+    TArray<FSGFanOutPlayer> Players;
+};
+typedef TSharedPtr<FSGFanOutSet, ESPMode::ThreadSafe> FSGFanOutSetPtr;
+
+// A Player, or a set of fan-out Players, whose animation nodes the animation
+// threads may still read, destroyed once the frame it was retired in is done
+struct FSGRetiredPlayers
+{
+    SG_COM_PlayerHandle Player = nullptr;
+    FSGFanOutSetPtr FanOutSet;
+    uint64 Frame = 0;
+};
+
+// Audio for one Engine as a list of buffers, copied in order into pooled
+// blocks without being joined into one contiguous buffer first
+struct FSGAudioInputBatch
+{
+    SG_COM_EngineHandle Engine = nullptr;
+    TArray<TArrayView<const uint8>, TInlineAllocator<4>> Spans;
+
+    // Utterance boundaries, as for InputAudio. Only used for the Engine of
+    // the session, a registered feed has no utterances.
+    bool bNewUtterance = true;
+    bool bEndOfUtterance = true;
+};
 
 class SGCOMUE4FILEEXAMPLE_API FSGComManager
 {
@@ -20,24 +116,194 @@ public:
     // Create the Engine
     static bool CreateEngine(SG_COM_EngineConfig EngineConfig);
 
+    // Tick a private Engine and Player created from EngineConfig and destroy
+    // them, so the first tick of the session does not pay for first use of
+    // the character data. Touches none of the session state, safe to call on
+    // any thread.
+    static bool WarmUp(SG_COM_EngineConfig EngineConfig);
+
+    // Create a spare Engine and Player from EngineConfig and warm them up,
+    // ready to take over when the Engine fails. Safe to call on any thread,
+    // the Player buffer size is read on the game thread by the caller.
+    static bool CreateSpareEngine(SG_COM_EngineConfig EngineConfig, float InPlayerBufferSec);
+
+    // Check if a warm spare Engine is ready
+    static bool HasSpareEngine();
+
+    // Move the session onto the spare Engine and Player, replaying the audio
+    // of the current utterance the failed Engine had not delivered yet. The
+    // failed Engine and Player are returned for the caller to destroy once
+    // no thread is ticking them. Called while the processing thread is not
+    // ticking the Engine, or is stuck in a tick.
+    static bool FailOver(SG_COM_EngineHandle& OutFailedEngine, SG_COM_PlayerHandle& OutFailedPlayer);
+
+    // Destroy an Engine returned by FailOver, the Player is destroyed once the
+    // animation threads stopped reading its animation nodes
+    static void DestroyFailedEngine(SG_COM_EngineHandle Engine, SG_COM_PlayerHandle Player);
+
+    // Watches the ticks of the Engine
+    static FSGTickWatchdog& GetWatchdog();
+
+    // Deliver a broadcast packet of the Engine to the fan-out Players,
+    // called from the Engine broadcast callback
+    static void ReceiveBroadcast(SG_COM_EngineHandle Engine, const char* Packet, sg_size PacketBytes);
+
+    // Number of Players animated by the Engine, the local Player is index 0
+    static int32 GetNumPlayers();
+
+    // Set how far a fan-out Player is shown behind the local Player (ms)
+    static void SetPlayerOffset(int32 PlayerIndex, double OffsetMs);
+
     // Destroy the Engine
     static bool DestroyEngine();
 
-    // Input an array of audio data to the Engine
-    static bool InputAudio(const TArray<uint8>& AudioData);
+    // Queue an array of audio data for input to the Engine. The data is
+    // copied into pooled blocks and fed to the Engine as it has room.
+    // Streamed utterances pass bNewUtterance = false for all but the first
+    // part and bEndOfUtterance = false for all but the last.
+    static bool InputAudio(TArrayView<const uint8> AudioData, bool bNewUtterance = true, bool bEndOfUtterance = true);
+
+    // Queue audio for many Engines in one call, on the thread calling
+    // InputAudio. Audio for the Engine of the session goes through the same
+    // queue as InputAudio, audio for another Engine through its registered
+    // feed. OutResults receives the result for each batch:
+    // SG_COM_ERROR_INVALID_HANDLE for an Engine without a feed, and
+    // SG_COM_ERROR_LOW_MEMORY when the pool budget ran out part way. Returns
+    // false if any batch failed.
+    static bool InputAudioBatch(TArrayView<const FSGAudioInputBatch> Batches, TArray<SG_COM_Error>& OutResults);
+
+    // Register the feed of an Engine ticked outside the manager, so
+    // InputAudioBatch can queue audio for it. Unregister it before it is
+    // destroyed.
+    static void RegisterEngineFeed(FSGEngineFeed* Feed);
+    static void UnregisterEngineFeed(FSGEngineFeed* Feed);
+
+    // Queue the audio of an utterance for playback only, e.g. one analysed ahead
+    static bool PlayAudio(TArrayView<const uint8> AudioData);
+
+    // Set the playback the blocks fed to the Engine are handed to, or
+    // nullptr to return them to the pool. The audio clock follows it.
+    static void SetPlayback(FSGAudioPlayback* InPlayback);
 
-    // Process any audio in the Engine input buffer
+    // Check if the latest utterance finished playing since the last call
+    static bool TakePlaybackFinished();
+
+    // Feed queued audio to the Engine and process any audio in its input buffer
     static bool ProcessAudio(int* RemainingFrames = nullptr);
 
-    // Update Animation Nodes for the local Player
+    // Stop playing the audio of the current utterance, called on the game
+    // thread when an interrupt is requested
+    static void FlushPlayback();
+
+    // Interrupt the current utterance, dropping its queued audio and
+    // buffered animation and cross-fading from the current pose. Must be
+    // called while audio is not being processed.
+    static bool Interrupt();
+
+    // Measure the barge-in latency from RequestTime until the animation of
+    // the next utterance starts
+    static void MarkBargeIn(double RequestTime);
+
+    // Get the pose to cross-fade from after an interrupt, as the channel
+    // values of all animation nodes in order, and its weight. The snapshot
+    // is only copied when InOutSerial differs from the latest interrupt.
+    // Returns false when no cross-fade is active.
+    static bool GetCrossfade(uint32& InOutSerial, TArray<float>& OutSnapshot, float& OutWeight);
+
+    // Set the source of live audio drained into the Engine on every tick, or nullptr
+    static void SetCaptureSource(FSGAudioCapture* Source);
+
+    // Set whether the Engine moves as if speaking or listening. Queued and
+    // applied by the processing thread before its next tick, so it is safe
+    // to call from the game thread while the Engine is ticking.
+    static bool SetRole(SG_COM_EngineRole Role);
+
+    // Set the mood of the Engine, one of the character setup or "auto"
+    static bool SetMood(const FString& Mood);
+
+    // Set an Engine control
+    static bool SetEngineControl(SG_COM_EngineControl Control, float Value);
+
+    // Apply the controls, mood and role set since the last tick. Called
+    // between ticks by the thread ticking the Engine.
+    static int32 ApplyControls();
+
+    // Avatar the Engine is registered as with the control queue
+    static const int32 AvatarId = 0;
+
+    // Update Animation Nodes for the local Player, then publish the channel
+    // values of all Players for the animation threads
     static bool UpdateAnimation(float DeltaSeconds);
 
-    // Get the animation nodes for the local Player
-    static bool GetAnimationNodes(FAvatarInfo& AvatarInfo);
+    // Check if the avatars play the shared idle loops of the character,
+    // while the Engine and the local Player are paused
+    static bool IsIdleLooping();
+
+    // Get the animation nodes for a Player, 0 for the local Player, or the
+    // Player of the pre-analysed utterance being played
+    static bool GetAnimationNodes(FAvatarInfo& AvatarInfo, int32 PlayerIndex = 0);
+
+    // Channel values of the animation nodes of a Player in node order, as
+    // published by the last UpdateAnimation. Read by the animation threads,
+    // the values stay valid until the end of the frame. Returns nullptr
+    // before the first update or for a Player not in the snapshot.
+    static const float* GetChannelSnapshot(int32 PlayerIndex, int32& OutNumChannels);
+
+    // Content hash of the character file the Engine was created from
+    static const FString& GetCharacterHash();
+
+    // Animation output of the Players
+    static SG_AnimationType GetAnimationType();
+
+    // Record the cycles an avatar took to apply one frame, called on the
+    // animation threads
+    static void AddAvatarCost(uint64 Cycles);
 
-    // Check if the engine handle is valid
+    // CPU time spent animating since the session started
+    static FSGAnimationCost GetAnimationCost();
+
+    // Changes whenever the Player returned by GetAnimationNodes changes
+    static uint32 GetBindingGeneration();
+
+    // Play the animation buffered in Player from StartTimeMs instead of the
+    // local Player, until it reaches the end of its playable range
+    static void PlayPreAnalysed(SG_COM_PlayerHandle Player, double StartTimeMs);
+
+    // Check if a pre-analysed utterance is being played
+    static bool IsPlayingPreAnalysed();
+
+    // Take the Player of a pre-analysed utterance that finished playing and
+    // that no avatar reads any more, or nullptr
+    static SG_COM_PlayerHandle TakeFinishedPlayer();
+
+    // Check if the Engine is ready, set once CreateEngine has published the
+    // handles and the character, animation type and fan-out set with them
     static bool IsEngineValid();
 
+    // Get the handle of the Engine, for batching its audio with other Engines
+    static SG_COM_EngineHandle GetEngineHandle();
+
+    // Report the playback position of the audio for the current utterance
+    static void SetAudioClock(double PlaybackTimeMs);
+
+    // Stop following the audio clock, e.g. when the audio finished playing
+    static void ClearAudioClock();
+
+    // Get the last measured offset between animation and audio (ms)
+    static double GetAVOffsetMs();
+
+    // Get the controller adapting the startup buffering
+    static FSGBufferController& GetBufferController();
+
+    // Get the audio withheld from the Engine by the voice activity gate
+    static FSGVoiceGateMetrics GetVoiceGateMetrics();
+
+    // Get the memory held for the Engine and the local Player
+    static FSGMemoryReport GetMemoryReport();
+
+    // Log the memory held for the Engine and the local Player
+    static void LogMemoryReport();
+
 private:
     FSGComManager(){};
     ~FSGComManager(){};
@@ -49,9 +315,256 @@ private:
 
     static SG_COM_EngineHandle EngineHandle;
     static SG_COM_PlayerHandle PlayerHandle;
+    static TAtomic<bool> bEngineReady;
+
+    // Get the extrapolated audio clock in player time (ms), for an
+    // utterance starting at AnchorMs
+    static double GetAudioClockMs(double AnchorMs);
+
+    // Slew TargetTimeMs towards the audio time, or jump if the error is large
+    static double SlewToAudioClock(double TargetTimeMs, double AudioTimeMs, double DeltaMs);
+
+    // Check if the current utterance has audio the Engine has not analysed
+    // yet, because its end was not fed or it is still queued
+    static bool HasUnanalysedInput();
+
+    // Update the local, fan-out and pre-analysed Players
+    static bool UpdatePlayers(float DeltaSeconds);
+
+    // Copy the channel values of all Players into the snapshot buffer the
+    // animation threads are not reading, then publish it
+    static void PublishChannelSnapshot();
+
+    // Update the animation of the pre-analysed utterance
+    static bool UpdatePreAnalysed(double DeltaMs);
+
+    // Go back to the local Player, the pre-analysed one is handed back after
+    // the animation of the current frame
+    static void FinishPreAnalysed();
+
+    // Snapshot the pose being shown to cross-fade from
+    static void SnapshotPose();
+
+    // Keep the audio input for the current utterance
+    static void RecordInput(TArrayView<const uint8> Data);
+
+    // Update a Player, recording the time it took
+    static SG_COM_Error UpdatePlayer(SG_COM_PlayerHandle Player, double TargetTimeMs, double& OutCurrentTimeMs);
+
+    // Queue the audio of Reader for input to the Engine, starting the
+    // utterance on bNewUtterance. Returns the number of bytes queued.
+    static int32 QueueInput(FSGAudioSpanReader& Reader, bool bNewUtterance, bool bEndOfUtterance);
+
+    // Copy audio into pooled blocks, queued for the Engine or only for
+    // playback. Returns the number of bytes queued.
+    static int32 QueueAudio(FSGAudioSpanReader& Reader, bool bNewUtterance, bool bEndOfUtterance, bool bPlaybackOnly);
+
+    // Hand a block fed to the Engine to the playback, or return it to the pool
+    static void ReleaseFedBlock(FSGAudioBlock* Block);
+
+    // Follow the position of the utterance being played
+    static void UpdatePlaybackClock();
+
+    // Input queued audio blocks while the Engine input buffer has room.
+    // Returns true if the Engine input buffer holds audio to analyse.
+    static bool FeedEngine();
+
+    // Check if a block is silent, classified the first time it is peeked.
+    // Starts the gate over on the first block of an utterance.
+    static bool ClassifyBlock(const FSGAudioBlock* Block);
+
+    // Report the audio the gate skipped for the utterance that ended
+    static void ReportVoiceGate();
+
+    // Add audio the gate passed or skipped to the metrics, returning the
+    // Engine time the skipped audio saved
+    static double AddVoiceGateMetrics(double InputMs, double SkippedMs, int32 NumUtterances);
+
+    // Pause the Engine on the shared idle loops while there is nothing to animate
+    static void UpdateIdleLooping();
+
+    // Create the fan-out Players for the Engine, retiring any that exist
+    static bool CreateFanOutPlayers();
+
+    // Retire the fan-out Players
+    static void DestroyFanOutPlayers();
+
+    // Update the fan-out Players to their offset from the local Player
+    static void UpdateFanOutPlayers();
+
+    // The fan-out Players of the Engine, null without any
+    static FSGFanOutSetPtr GetFanOutSet();
+
+    // Destroy a Player, or a set of fan-out Players, after the animation of
+    // the current frame, called on the game thread
+    static void RetirePlayer(SG_COM_PlayerHandle Player);
+    static void RetireFanOutSet(FSGFanOutSetPtr Set);
+
+    // Destroy the retired Players no thread can be reading any more, or all
+    // of them when the session ends
+    static void DestroyRetiredPlayers(bool bAll);
+
+    // Return all queued audio blocks to the pool
+    static void FlushPendingAudio();
+
+    // Input all complete blocks of captured audio, skipping silence when the
+    // gate is enabled. Returns true if any audio was input.
+    static bool DrainCapture();
 
     // Tracks the total tick time
-    static float TotalTime;
+    static double TotalTime;
+
+    // Latest end of the playable range, where newly input audio starts.
+    // Written on the game thread and read by the processing thread.
+    static TAtomic<double> LastMaxTimeMs;
+
+    // Player time at which the current utterance started, read by the
+    // processing thread
+    static TAtomic<double> UtteranceAnchorMs;
+
+    // Last reported audio playback position and when it was reported
+    static double AudioClockMs;
+    static double AudioClockStamp;
+    static bool bAudioClockValid;
+
+    static double AVOffsetMs;
+
+    // Bytes per second and sample type of the audio input to the engine
+    static double InputBytesPerSecond;
+    static SG_AudioSampleType InputSampleType;
+
+    // Adapts the start threshold and buffering to the engine speed
+    static FSGBufferController BufferController;
+
+    // When the previous tick started, for measuring the tick interval
+    static double LastTickTime;
+
+    // Audio blocks waiting for room in the Engine input buffer, queued on
+    // the game thread and fed on the processing thread
+    static FSGAudioBufferPool AudioPool;
+    static TQueue<FSGAudioBlock*, EQueueMode::Spsc> PendingBlocks;
+    static FThreadSafeCounter64 PendingBytes;
+
+    // Feeds of Engines ticked outside the manager
+    static FCriticalSection EngineFeedLock;
+    static TArray<FSGEngineFeed*> EngineFeeds;
+
+    // Plays the fed blocks, and the last utterance queued for it
+    static TAtomic<FSGAudioPlayback*> Playback;
+    static uint32 InputUtterance;
+
+    // Voice activity gate, run by the processing thread. Silence after
+    // the hangover is not input to the Engine, which idles through it.
+    static FSGVoiceActivity VoiceActivity;
+    static bool bVoiceGate;
+    static const FSGAudioBlock* ClassifiedBlock;
+    static bool bClassifiedSilent;
+    static int64 FedUtteranceBytes;
+    static double SilenceRunMs;
+    static double UtteranceSkippedMs;
+    static bool bGapSkipped;
+    static FSGVoiceActivity CaptureVoiceActivity;
+    static double CaptureSilenceRunMs;
+    static bool bCaptureGapSkipped;
+
+    // Tick busy time and frames with input to analyse, and while idling
+    // through audio the gate skipped, run by the processing thread
+    static double AnalyseTickSec;
+    static int64 NumAnalyseFrames;
+    static double GatedTickSec;
+    static int64 NumGatedFrames;
+    static FCriticalSection VoiceGateLock;
+    static FSGVoiceGateMetrics VoiceGateMetrics;
+
+    // Tracks if an utterance is being input, and where its animation ends
+    static FThreadSafeBool bUtteranceOpen;
+    static double UtteranceEndMs;
+
+    // Set while the avatars play the shared idle loops
+    static FThreadSafeBool bIdleLooping;
+    static bool bIdleLoopsReady;
+
+    // Live audio source and the block it is drained through
+    static TAtomic<FSGAudioCapture*> CaptureSource;
+    static TArray<uint8> CaptureBlock;
+
+    // Frames left in the Engine input buffer after the previous tick
+    static TAtomic<int32> LastRemainingFrames;
+
+    // Sizes the memory report is based on
+    static float EngineBufferSec;
+    static float PlayerBufferSec;
+    static int64 CharacterFileBytes;
+    static FString CharacterHash;
+    static SG_AnimationType AnimationType;
+
+    // Animation cost in cycles, added to by the animation threads without a lock
+    static FThreadSafeCounter64 NumPlayerUpdates;
+    static FThreadSafeCounter64 PlayerUpdateCycles;
+    static FThreadSafeCounter64 NumAvatarFrames;
+    static FThreadSafeCounter64 AvatarApplyCycles;
+
+    // Tracks if the animation for the current utterance has started
+    static bool bUtteranceStarted;
 
     static bool bAnimationStarted;
+
+    // Pose at the last interrupt, read by the animation thread
+    static FCriticalSection CrossfadeLock;
+    static TArray<float> CrossfadeSnapshot;
+    static uint32 CrossfadeSerial;
+    static double CrossfadeStartTime;
+
+    // When the pending barge-in was requested, 0 if none
+    static double BargeInRequestTime;
+
+    // Pre-analysed utterance being played and its time. Only changed on the
+    // game thread, under FanOutLock as the animation threads read it.
+    static SG_COM_PlayerHandle PreAnalysedPlayer;
+
+    // Players of pre-analysed utterances that finished playing, handed back
+    // once the animation threads stopped reading them
+    static TArray<FSGRetiredPlayers> FinishedPlayers;
+    static double PreAnalysedStartMs;
+    static double PreAnalysedTimeMs;
+    static TAtomic<uint32> BindingGeneration;
+
+    // Channel values of all Players, double-buffered. Written on the game
+    // thread into the buffer not published, which the animation threads
+    // stopped reading when the previous frame finished. Offsets has the
+    // first channel of every Player index and the end. A shared snapshot
+    // holds the pre-analysed Player, shown on every Player index.
+    static TArray<float> ChannelSnapshot[2];
+    static TArray<int32> ChannelSnapshotOffsets[2];
+    static bool bChannelSnapshotShared[2];
+    static TAtomic<int32> ChannelSnapshotIndex;
+
+    // Players fed the broadcast packets of the Engine, by the processing
+    // thread during ticks and updated on the game thread. FanOutLock guards
+    // the swap of the set, the Engine and Player handles and the pre-analysed
+    // Player, and is never held while calling into SG_Com.
+    static FCriticalSection FanOutLock;
+    static FSGFanOutSetPtr FanOutSet;
+    static SG_COM_PlayerConfig FanOutPlayerConfig;
+
+    // Players waiting for the animation threads to stop reading them, only
+    // used on the game thread
+    static TArray<FSGRetiredPlayers> RetiredPlayers;
+
+    // Warm spare Engine and Player taking over when the Engine fails
+    static SG_COM_EngineHandle SpareEngineHandle;
+    static SG_COM_PlayerHandle SparePlayerHandle;
+    static FThreadSafeBool bSpareReady;
+    static FSGTickWatchdog Watchdog;
+
+    // Held by the processing thread once a tick returns and by FailOver, so a
+    // stalled tick returning during a fail over leaves the new Engine alone
+    static FCriticalSection TickLock;
+
+    // Audio of the current utterance input to the Engine, replayed after a
+    // fail over. HistoryStartBytes is the utterance offset of its first byte.
+    static FCriticalSection HistoryLock;
+    static TArray<uint8> InputHistory;
+    static int64 HistoryStartBytes;
+    static int32 InputBytesPerSample;
 };
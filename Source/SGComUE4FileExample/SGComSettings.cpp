@@ -0,0 +1,167 @@
+#include "SGComSettings.h"
+
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Parse.h"
+
+static const TCHAR* SettingsSection = TEXT("SGCom");
+
+// ========================================================
+// Read a setting from the config, then the command line
+// ========================================================
+static void ReadSetting(const TCHAR* Key, double& Value)
+{
+    GConfig->GetDouble(SettingsSection, Key, Value, GGameIni);
+    FParse::Value(FCommandLine::Get(), *(FString(TEXT("SG")) + Key + TEXT("=")), Value);
+}
+
+static void ReadSetting(const TCHAR* Key, int32& Value)
+{
+    GConfig->GetInt(SettingsSection, Key, Value, GGameIni);
+    FParse::Value(FCommandLine::Get(), *(FString(TEXT("SG")) + Key + TEXT("=")), Value);
+}
+
+static void ReadSetting(const TCHAR* Key, FString& Value)
+{
+    GConfig->GetString(SettingsSection, Key, Value, GGameIni);
+    FParse::Value(FCommandLine::Get(), *(FString(TEXT("SG")) + Key + TEXT("=")), Value);
+}
+
+// ========================================================
+// Get the settings, loaded on first use
+// ========================================================
+const FSGComSettings& FSGComSettings::Get()
+{
+    static const FSGComSettings Settings = Load();
+    return Settings;
+}
+
+// ========================================================
+// Load the settings from the config and command line
+// ========================================================
+FSGComSettings FSGComSettings::Load()
+{
+    FSGComSettings Settings;
+
+    FString ClockSyncMode;
+    ReadSetting(TEXT("ClockSyncMode"), ClockSyncMode);
+    if (ClockSyncMode.Equals(TEXT("DeltaTime"), ESearchCase::IgnoreCase)) {
+        Settings.ClockSyncMode = ESGClockSyncMode::DeltaTime;
+    }
+    else if (ClockSyncMode.Equals(TEXT("AudioClock"), ESearchCase::IgnoreCase)) {
+        Settings.ClockSyncMode = ESGClockSyncMode::AudioClock;
+    }
+    else if (!ClockSyncMode.IsEmpty()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Unknown ClockSyncMode %s"), *ClockSyncMode);
+    }
+
+    ReadSetting(TEXT("AudioLatencyMs"), Settings.AudioLatencyMs);
+    ReadSetting(TEXT("ClockSlewRate"), Settings.ClockSlewRate);
+    ReadSetting(TEXT("ClockSnapThresholdMs"), Settings.ClockSnapThresholdMs);
+    ReadSetting(TEXT("MinStartThresholdMs"), Settings.MinStartThresholdMs);
+    ReadSetting(TEXT("MaxStartThresholdMs"), Settings.MaxStartThresholdMs);
+    ReadSetting(TEXT("MinPlaybackRate"), Settings.MinPlaybackRate);
+    ReadSetting(TEXT("EngineSampleRate"), Settings.EngineSampleRate);
+
+    FString EngineSampleType;
+    ReadSetting(TEXT("EngineSampleType"), EngineSampleType);
+    if (EngineSampleType.Equals(TEXT("Int16"), ESearchCase::IgnoreCase)) {
+        Settings.EngineSampleType = SG_AUDIO_INT_16;
+    }
+    else if (EngineSampleType.Equals(TEXT("Int32"), ESearchCase::IgnoreCase)) {
+        Settings.EngineSampleType = SG_AUDIO_INT_32;
+    }
+    else if (EngineSampleType.Equals(TEXT("Float32"), ESearchCase::IgnoreCase)) {
+        Settings.EngineSampleType = SG_AUDIO_FLOAT_32;
+    }
+    else if (!EngineSampleType.IsEmpty()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Unknown EngineSampleType %s"), *EngineSampleType);
+    }
+
+    ReadSetting(TEXT("EngineBufferSec"), Settings.EngineBufferSec);
+    ReadSetting(TEXT("PlayerBufferSec"), Settings.PlayerBufferSec);
+    ReadSetting(TEXT("AudioPoolBudgetMB"), Settings.AudioPoolBudgetMB);
+    ReadSetting(TEXT("AudioBlockMs"), Settings.AudioBlockMs);
+    ReadSetting(TEXT("VadGate"), Settings.VadGate);
+    ReadSetting(TEXT("VadThresholdDb"), Settings.VadThresholdDb);
+    ReadSetting(TEXT("VadHangoverMs"), Settings.VadHangoverMs);
+
+    FString CaptureSource;
+    ReadSetting(TEXT("CaptureSource"), CaptureSource);
+    if (CaptureSource.Equals(TEXT("Device"), ESearchCase::IgnoreCase)) {
+        Settings.CaptureSource = ESGCaptureSource::Device;
+    }
+    else if (CaptureSource.Equals(TEXT("File"), ESearchCase::IgnoreCase)) {
+        Settings.CaptureSource = ESGCaptureSource::File;
+    }
+
+    ReadSetting(TEXT("CaptureFile"), Settings.CaptureFile);
+    ReadSetting(TEXT("CaptureBlockMs"), Settings.CaptureBlockMs);
+
+    FString CaptureRole;
+    ReadSetting(TEXT("CaptureRole"), CaptureRole);
+    if (CaptureRole.Equals(TEXT("Speak"), ESearchCase::IgnoreCase)) {
+        Settings.CaptureRole = SG_COM_ROLE_SPEAK;
+    }
+
+    ReadSetting(TEXT("ControlRampMs"), Settings.ControlRampMs);
+    ReadSetting(TEXT("IngestPort"), Settings.IngestPort);
+
+    FString QueueOrder;
+    ReadSetting(TEXT("QueueOrder"), QueueOrder);
+    if (QueueOrder.Equals(TEXT("Arrival"), ESearchCase::IgnoreCase)) {
+        Settings.QueueOrder = ESGQueueOrder::Arrival;
+    }
+    else if (QueueOrder.Equals(TEXT("Name"), ESearchCase::IgnoreCase)) {
+        Settings.QueueOrder = ESGQueueOrder::Name;
+    }
+    else if (QueueOrder.Equals(TEXT("ModTime"), ESearchCase::IgnoreCase)) {
+        Settings.QueueOrder = ESGQueueOrder::ModTime;
+    }
+    else if (!QueueOrder.IsEmpty()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Unknown QueueOrder %s"), *QueueOrder);
+    }
+
+    ReadSetting(TEXT("DiscoveryMaxEntries"), Settings.DiscoveryMaxEntries);
+    ReadSetting(TEXT("InterruptPriority"), Settings.InterruptPriority);
+    ReadSetting(TEXT("InterruptCrossfadeMs"), Settings.InterruptCrossfadeMs);
+
+    ReadSetting(TEXT("LookAheadEngines"), Settings.LookAheadEngines);
+    ReadSetting(TEXT("LookAheadMaxClipSec"), Settings.LookAheadMaxClipSec);
+    ReadSetting(TEXT("LookAheadMemoryMB"), Settings.LookAheadMemoryMB);
+    ReadSetting(TEXT("LookAheadCpuBudget"), Settings.LookAheadCpuBudget);
+
+    FString AnimationType;
+    ReadSetting(TEXT("AnimationType"), AnimationType);
+    if (AnimationType.Equals(TEXT("Normal"), ESearchCase::IgnoreCase)) {
+        Settings.AnimationType = SG_NORMAL_ANIMATION;
+    }
+    else if (AnimationType.Equals(TEXT("Baked"), ESearchCase::IgnoreCase)) {
+        Settings.AnimationType = SG_BAKED_ANIMATION;
+    }
+    else if (!AnimationType.IsEmpty()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Unknown AnimationType %s"), *AnimationType);
+    }
+
+    ReadSetting(TEXT("WatchdogDeadlineFactor"), Settings.WatchdogDeadlineFactor);
+    ReadSetting(TEXT("WatchdogMaxMisses"), Settings.WatchdogMaxMisses);
+    ReadSetting(TEXT("WatchdogSpareEngine"), Settings.WatchdogSpareEngine);
+
+    ReadSetting(TEXT("PoseStreamAddress"), Settings.PoseStreamAddress);
+    ReadSetting(TEXT("PoseStreamKeyframeInterval"), Settings.PoseStreamKeyframeInterval);
+    ReadSetting(TEXT("PoseStreamVerify"), Settings.PoseStreamVerify);
+
+    ReadSetting(TEXT("FanOutPlayers"), Settings.FanOutPlayers);
+    ReadSetting(TEXT("FanOutOffsetsMs"), Settings.FanOutOffsetsMs);
+    ReadSetting(TEXT("IdleLoops"), Settings.IdleLoops);
+    ReadSetting(TEXT("IdleLoopSec"), Settings.IdleLoopSec);
+    ReadSetting(TEXT("IdleBlendMs"), Settings.IdleBlendMs);
+    ReadSetting(TEXT("LatencyReportFile"), Settings.LatencyReportFile);
+    ReadSetting(TEXT("SoakReportFile"), Settings.SoakReportFile);
+    ReadSetting(TEXT("SoakReportIntervalSec"), Settings.SoakReportIntervalSec);
+    ReadSetting(TEXT("SoakUtteranceFile"), Settings.SoakUtteranceFile);
+    ReadSetting(TEXT("SoakArrivalIntervalSec"), Settings.SoakArrivalIntervalSec);
+    ReadSetting(TEXT("SoakSeed"), Settings.SoakSeed);
+
+    return Settings;
+}
@@ -0,0 +1,176 @@
+// Runtime settings for the SG_Com integration
+
+#pragma once
+
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+
+// How the SG player time is advanced every tick
+enum class ESGClockSyncMode : uint8
+{
+    DeltaTime,  // Accumulate the frame delta time
+    AudioClock  // Follow the playback position of the audio device
+};
+
+// Where live audio input is captured from
+enum class ESGCaptureSource : uint8
+{
+    None,
+    Device, // The default audio capture device
+    File    // A WAV file played back in realtime
+};
+
+// Order in which files of the same priority found in the watched folders
+// are played. Files with a higher priority tag, e.g. "reply.p5.wav", are
+// always played first.
+enum class ESGQueueOrder : uint8
+{
+    Arrival,  // In the order they were discovered
+    Name,     // By file name
+    ModTime   // Oldest modification time first
+};
+
+// Settings are read from the [SGCom] section of the game ini and can be
+// overridden on the command line with -SG<Key>=<Value>
+struct SGCOMUE4FILEEXAMPLE_API FSGComSettings
+{
+    // How the SG player time is advanced
+    ESGClockSyncMode ClockSyncMode = ESGClockSyncMode::AudioClock;
+
+    // Audio output latency subtracted from the audio clock (ms)
+    double AudioLatencyMs = 0.0;
+
+    // Maximum clock correction per tick, as a fraction of the tick duration
+    double ClockSlewRate = 0.05;
+
+    // Clock errors larger than this are corrected with a jump (ms)
+    double ClockSnapThresholdMs = 250.0;
+
+    // Bounds of the adaptive start threshold (ms)
+    double MinStartThresholdMs = 10.0;
+    double MaxStartThresholdMs = 500.0;
+
+    // Slowest playback rate used to stretch the animation when its buffer runs low
+    double MinPlaybackRate = 0.8;
+
+    // Input format of the engine, every audio source is fed in it. The
+    // sample type is Int16, Int32 or Float32.
+    int32 EngineSampleRate = 16000;
+    SG_AudioSampleType EngineSampleType = SG_AUDIO_INT_16;
+
+    // Memory budget of the engine input buffer (s)
+    double EngineBufferSec = 2.0;
+
+    // Memory budget of the player output buffer (s), 0 to derive it from
+    // the measured start threshold and tick jitter
+    double PlayerBufferSec = 0.0;
+
+    // Memory budget of the pooled audio blocks waiting for input (MB)
+    double AudioPoolBudgetMB = 16.0;
+
+    // Duration of one pooled audio block (ms)
+    double AudioBlockMs = 100.0;
+
+    // Voice activity gate on the engine input. Audio quieter than
+    // VadThresholdDb (dBFS), apart from unvoiced consonants, is silence.
+    // Silence longer than VadHangoverMs is not analysed, the engine idles
+    // through it instead. Applies to utterances and live capture, enabled
+    // when VadGate is 1.
+    int32 VadGate = 0;
+    double VadThresholdDb = -45.0;
+    double VadHangoverMs = 200.0;
+
+    // Live audio input, fed to the engine in blocks of CaptureBlockMs
+    ESGCaptureSource CaptureSource = ESGCaptureSource::None;
+    FString CaptureFile;
+    double CaptureBlockMs = 10.0;
+
+    // Role of the engine while it receives live audio, Listen or Speak
+    SG_COM_EngineRole CaptureRole = SG_COM_ROLE_LISTEN;
+
+    // Engine control changes (scale, speed, expression frequency) are ramped
+    // linearly over ControlRampMs, 0 applies them at once
+    double ControlRampMs = 100.0;
+
+    // Port of the local audio ingest endpoint, 0 to disable it
+    int32 IngestPort = 0;
+
+    // Order of the queued files and the number of files remembered by the
+    // discovery index, processed files beyond it are forgotten
+    ESGQueueOrder QueueOrder = ESGQueueOrder::Arrival;
+    int32 DiscoveryMaxEntries = 4096;
+
+    // Queued files with at least this priority interrupt a playing utterance
+    // of lower priority, 0 to never interrupt
+    int32 InterruptPriority = 1;
+
+    // Duration of the cross-fade from the interrupted pose (ms)
+    double InterruptCrossfadeMs = 200.0;
+
+    // Upcoming queued clips are analysed ahead on up to LookAheadEngines
+    // spare engines, 0 to disable. Clips longer than LookAheadMaxClipSec are
+    // not analysed ahead. The spare engines are bounded by a memory budget
+    // (MB) and their analysis by a CPU budget (cores).
+    int32 LookAheadEngines = 0;
+    double LookAheadMaxClipSec = 15.0;
+    double LookAheadMemoryMB = 64.0;
+    double LookAheadCpuBudget = 0.5;
+
+    // Animation output of the players. Baked animation evaluates the rig
+    // logic stored in the character setup and outputs joints and blendshapes,
+    // normal animation outputs the raw controls for the rig logic in Unreal.
+    SG_AnimationType AnimationType = SG_NORMAL_ANIMATION;
+
+    // A tick misses its deadline when it takes longer than
+    // WatchdogDeadlineFactor times the 10 ms frame it processes. After
+    // WatchdogMaxMisses misses or errors in a row, or a tick stalled for as
+    // long, the session moves onto a warm spare engine when
+    // WatchdogSpareEngine is set. The spare holds a second copy of the
+    // character and buffers, so it is off by default.
+    double WatchdogDeadlineFactor = 4.0;
+    int32 WatchdogMaxMisses = 3;
+    int32 WatchdogSpareEngine = 0;
+
+    // Applied channel values of every avatar are streamed to
+    // PoseStreamAddress (host:port), disabled when empty. A keyframe is sent
+    // every PoseStreamKeyframeInterval frames. PoseStreamVerify decodes every
+    // frame locally to measure the decode cost.
+    FString PoseStreamAddress;
+    int32 PoseStreamKeyframeInterval = 30;
+    int32 PoseStreamVerify = 0;
+
+    // FanOutPlayers extra Players are fed the broadcast packets of the
+    // engine, so their avatars share its analysis. FanOutOffsetsMs lists
+    // how far each is shown behind the local Player, comma separated.
+    int32 FanOutPlayers = 0;
+    FString FanOutOffsetsMs;
+
+    // IdleLoops loops of IdleLoopSec of idle are generated once per
+    // character with a fixed random seed and cached. While there is nothing
+    // to animate the engine is paused and every avatar plays them from its
+    // own phase, blending over IdleBlendMs. Disabled when IdleLoops is 0.
+    int32 IdleLoops = 4;
+    double IdleLoopSec = 8.0;
+    double IdleBlendMs = 300.0;
+
+    // Per-stage utterance latency report, disabled when LatencyReportFile
+    // is empty. The latency of every utterance is logged either way.
+    FString LatencyReportFile;
+
+    // Soak test report, disabled when SoakReportFile is empty
+    FString SoakReportFile;
+    double SoakReportIntervalSec = 10.0;
+
+    // Scripted arrivals copying SoakUtteranceFile into the watched folder
+    FString SoakUtteranceFile;
+    double SoakArrivalIntervalSec = 5.0;
+    int32 SoakSeed = 1;
+
+    // Get the settings, loaded on first use
+    static const FSGComSettings& Get();
+
+private:
+    // Load the settings from the config and command line
+    static FSGComSettings Load();
+};
@@ -7,10 +7,13 @@ public class SGComUE4FileExample : ModuleRules
     public SGComUE4FileExample(ReadOnlyTargetRules Target) : base(Target)
     {
         PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        // The editor module includes the AnimGraph node
+        PublicIncludePaths.Add(ModuleDirectory);
     
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "SG_Com" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "SG_Com", "AudioCaptureCore", "SignalProcessing", "Sockets", "Networking", "Json" });
 
         // Uncomment if you are using Slate UI
         // PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
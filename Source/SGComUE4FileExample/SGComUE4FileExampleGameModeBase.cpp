@@ -2,12 +2,21 @@
 
 #include "HAL/PlatformFilemanager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Components/AudioComponent.h"
 #include "Audio.h"
+#include "SGAnimationBenchmark.h"
+#include "SGComSettings.h"
+#include "SGIdleLoops.h"
+#include "SGLatencyTracer.h"
+#include "SGNodeBinding.h"
+#include "SGPoseStream.h"
 
 
 const FString CharacterFileDirectory = FPaths::ProjectContentDir() + "Resources/Characters/";
 const FString AudioFileDirectory = FPaths::ProjectContentDir() + "Resources/Audio/";
 
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Time To Ready (ms)"), STAT_SGCom_TimeToReady, STATGROUP_SGCom);
+
 // ========================================================
 // Map audio sample rate from Hz to SG_AudioSampleRate
 // ========================================================
@@ -34,45 +43,30 @@ static SG_AudioSampleRate MapSampleRate(int SampleRate)
 }
 
 // ========================================================
-// Map audio sample type to SG_AudioSampleType
+// Constructor
 // ========================================================
-static SG_AudioSampleType MapSampleType(const uint16 AudioFormat, const uint16 BitsPerSample)
+ASGComUE4FileExampleGameModeBase::ASGComUE4FileExampleGameModeBase()
 {
-    switch (AudioFormat) {
-        case 0x0001:
-            switch (BitsPerSample) {
-                case 16:
-                    return SG_AUDIO_INT_16;
-                case 32:
-                    return SG_AUDIO_INT_32;
-                default:
-                    UE_LOG(LogTemp, Warning, TEXT("[APP] : PCM samples must be either 16 or 32 bit"));
-                    checkNoEntry();
-                    return SG_AUDIO_INT_16;
-            };
-        case 0x0003:
-            switch (BitsPerSample) {
-                case 32:
-                    return SG_AUDIO_FLOAT_32;
-                default:
-                    UE_LOG(LogTemp, Warning, TEXT("[APP] : IEEE float samples must be 32 bit"));
-                    checkNoEntry();
-                    return SG_AUDIO_FLOAT_32;
-            };
-        default:
-            UE_LOG(LogTemp, Warning, TEXT("[APP] : Sample type must be either PCM or IEEE float"));
-            checkNoEntry();
-            return SG_AUDIO_INT_16;
-    };
+    PrimaryActorTick.bCanEverTick = true;
+    LastWatchEventCall = FDateTime::Now();
 }
 
 // ========================================================
-// Constructor
+// Called before any actor runs BeginPlay, while the map is
+// loading
 // ========================================================
-ASGComUE4FileExampleGameModeBase::ASGComUE4FileExampleGameModeBase()
+void ASGComUE4FileExampleGameModeBase::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
 {
-    PrimaryActorTick.bCanEverTick = true;
-    LastWatchEventCall = FDateTime::Now();
+    Super::InitGame(MapName, Options, ErrorMessage);
+
+    StartBootstrap();
+
+    // Started before any actor can watch a folder, so the first watched
+    // folder gets the scripted arrivals
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    if (!Settings.SoakReportFile.IsEmpty()) {
+        SoakMonitor.Start(Settings.SoakReportFile, Settings.SoakReportIntervalSec);
+    }
 }
 
 // ========================================================
@@ -82,31 +76,115 @@ void ASGComUE4FileExampleGameModeBase::StartPlay()
 {
     Super::StartPlay();
 
-    // Make sure that the directory exists. Used for logging
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    if (!PlatformFile.DirectoryExists(*FPaths::ProjectPersistentDownloadDir())) {
-        PlatformFile.CreateDirectory(*FPaths::ProjectPersistentDownloadDir());
-    }
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    DiscoveryIndex.Configure(Settings.QueueOrder, Settings.DiscoveryMaxEntries);
+    FSGLatencyTracer::Get().Configure(Settings.LatencyReportFile);
+}
 
-    FString LogFileName = "SG_COM_log_" + FDateTime::Now().ToString();
-    FString SGComLogPath = FPaths::ProjectPersistentDownloadDir() + "/" + LogFileName + ".txt";
-    FSGComManager::Initialize(SGComLogPath);
+// ========================================================
+// Initialize SG_Com, load the character and create the
+// engine on background threads
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartBootstrap()
+{
+    BootstrapStartTime = FPlatformTime::Seconds();
+    EngineSampleType = FSGComSettings::Get().EngineSampleType;
+    EngineSampleRate = (uint32)FSGComSettings::Get().EngineSampleRate;
+
+    // License validation and the character file load are independent
+    TFuture<double> InitializeFuture = Async(EAsyncExecution::Thread, []() {
+        const double StartTime = FPlatformTime::Seconds();
+
+        // Make sure that the directory exists. Used for logging
+        IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        if (!PlatformFile.DirectoryExists(*FPaths::ProjectPersistentDownloadDir())) {
+            PlatformFile.CreateDirectory(*FPaths::ProjectPersistentDownloadDir());
+        }
 
-    SG_COM_EngineConfig EngineConfig;
-    SetupEngineConfig(EngineConfig);
-    bool success = FSGComManager::CreateEngine(EngineConfig);
+        FString LogFileName = "SG_COM_log_" + FDateTime::Now().ToString();
+        FString SGComLogPath = FPaths::ProjectPersistentDownloadDir() + "/" + LogFileName + ".txt";
+        if (!FSGComManager::Initialize(SGComLogPath)) {
+            return -1.0;
+        }
+        return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    });
+
+    TFuture<double> CharacterFuture = Async(EAsyncExecution::Thread, [this]() {
+        const double StartTime = FPlatformTime::Seconds();
+        LoadCharacterFile();
+        return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    });
+
+    BootstrapFuture = Async(EAsyncExecution::Thread, [this, InitializeFuture = MoveTemp(InitializeFuture), CharacterFuture = MoveTemp(CharacterFuture)]() mutable {
+        BootstrapTimings.InitializeMs = InitializeFuture.Get();
+        BootstrapTimings.CharacterLoadMs = CharacterFuture.Get();
+        if (BootstrapTimings.InitializeMs < 0.0 || CharacterFileData.Num() == 0) {
+            return false;
+        }
 
-    if (success) {
-        // Input audio file data        
-        FSGComManager::InputAudio(AudioFileData);
-        bProcessAudio = true;
+        double StartTime = FPlatformTime::Seconds();
+        SG_COM_EngineConfig EngineConfig;
+        SetupEngineConfig(EngineConfig, true);
+        if (!FSGComManager::CreateEngine(EngineConfig)) {
+            return false;
+        }
+        BootstrapTimings.CreateEngineMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
 
-        // Launch the process frame thread
-        FrameFuture = Async(EAsyncExecution::Thread, [&]() { ProcessFrameWorker(); });
+        // The first tick pays for first use of the character data, paid on a
+        // private engine so the session state is only touched by the worker
+        StartTime = FPlatformTime::Seconds();
+        FSGComManager::WarmUp(EngineConfig);
+        BootstrapTimings.WarmUpMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+        return true;
+    });
+}
+
+// ========================================================
+// Start the session once the engine is ready
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartSession()
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+
+    BootstrapTimings.TimeToReadyMs = (FPlatformTime::Seconds() - BootstrapStartTime) * 1000.0;
+    SET_FLOAT_STAT(STAT_SGCom_TimeToReady, BootstrapTimings.TimeToReadyMs);
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Ready in %.1f ms (initialize %.1f ms, character load %.1f ms, engine creation %.1f ms, warm-up %.1f ms)"),
+           BootstrapTimings.TimeToReadyMs,
+           BootstrapTimings.InitializeMs,
+           BootstrapTimings.CharacterLoadMs,
+           BootstrapTimings.CreateEngineMs,
+           BootstrapTimings.WarmUpMs);
+
+    // The avatars are bound from the cached bindings without touching the disk
+    FSGNodeBindingCache::Get().Load(FSGComManager::GetCharacterHash());
+
+    // Played from the blocks as they are fed to the engine
+    StartPlayback();
+
+    // Input audio file data        
+    FSGComManager::InputAudio(AudioSampleData);
+    // Launch the process frame thread
+    StartFrameWorker();
+
+    StartCapture();
+
+    if (Settings.LookAheadEngines > 0) {
+        SG_COM_EngineConfig EngineConfig;
+        SetupEngineConfig(EngineConfig, false);
+        LookAhead.Start(EngineConfig, Settings.LookAheadEngines, Settings.LookAheadMaxClipSec, Settings.LookAheadMemoryMB, Settings.LookAheadCpuBudget);
+    }
 
-        // Play audio
-        UGameplayStatics::PlaySound2D(this, AudioClip);
+    if (Settings.IngestPort > 0) {
+        IngestServer.Start(Settings.IngestPort, EngineSampleType, EngineSampleRate);
     }
+
+    if (!Settings.PoseStreamAddress.IsEmpty()) {
+        FSGPoseStream::Get().Start(Settings.PoseStreamAddress);
+    }
+
+    StartSpareEngine();
+    StartIdleLoops();
 }
 
 // ========================================================
@@ -125,59 +203,154 @@ void ASGComUE4FileExampleGameModeBase::Logout(AController* Exiting)
 void ASGComUE4FileExampleGameModeBase::Tick(float DeltaSeconds)
 {
     Super::Tick(DeltaSeconds);
+
+    SoakMonitor.RecordGameTick(DeltaSeconds);
+
+    // The avatar keeps its idle pose until the engine is ready
+    if (!bSessionStarted) {
+        if (!BootstrapFuture.IsReady()) {
+            return;
+        }
+
+        bSessionStarted = true;
+        if (!BootstrapFuture.Get()) {
+            UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to start SG_Com"));
+            return;
+        }
+        StartSession();
+    }
+
+    SoakMonitor.Update([this]() { return GetSoakCounters(); });
+    FSGLatencyTracer::Get().Update();
+    FSGNodeBindingCache::Get().Flush();
     
+    DrainIngest();
+    DrainDecoder();
+
+    // The Frame Worker applies the controls between its ticks while it runs
+    if (!FrameFuture.IsValid() || FrameFuture.IsReady()) {
+        FSGComManager::ApplyControls();
+    }
+
+    // Swap onto the spare engine when the engine stalls or keeps failing
+    if (FSGComManager::GetWatchdog().ShouldFailOver()) {
+        FailOverEngine();
+    }
+    if (StalledFrameFuture.IsValid() && StalledFrameFuture.IsReady()) {
+        FSGComManager::DestroyFailedEngine(StalledEngine, StalledPlayer);
+        StalledFrameFuture = TFuture<void>();
+        StalledEngine = nullptr;
+        StalledPlayer = nullptr;
+    }
+
     FSGComManager::UpdateAnimation(DeltaSeconds);
+    if (FSGComManager::TakePlaybackFinished()) {
+        OnPlaybackFinished();
+    }
+    if (SG_COM_PlayerHandle FinishedPlayer = FSGComManager::TakeFinishedPlayer()) {
+        LookAhead.Release(FinishedPlayer);
+    }
+
+    // An urgent utterance stops the playing one and starts below once the
+    // Frame Worker returned, without blocking this thread on its tick
+    const bool bPlaying = !FrameFuture.IsReady() || FSGComManager::IsPlayingPreAnalysed();
+    if (!bInterruptPending && bPlaying && ShouldInterrupt()) {
+        InterruptUtterance();
+    }
+    if (bInterruptPending && (!FrameFuture.IsValid() || FrameFuture.IsReady())) {
+        FSGComManager::Interrupt();
+        bInterruptPending = false;
+        bBargeIn = true;
+    }
 
     // When the Frame Worker is finished, it sets the state of the
     // FrameFuture to IsReady to indicate there is a return code
     // we don't exactly care for the return code and instead will
-    // play the next queued track
-    if (FrameFuture.IsReady()) {
+    // play the next queued track. A pre-analysed track is played to the end first.
+    if (FrameFuture.IsReady() && !bInterruptPending && !FSGComManager::IsPlayingPreAnalysed()) {
 
         // Check there is actually a file
-        if (fileQueue_.empty()) {
+        FSGQueuedUtterance Utterance;
+        if (!DiscoveryIndex.PopNext(Utterance)) {
             return;
         }
 
-        currentFile_ = fileQueue_.front();
-        fileQueue_.pop_front();
-        FString cf{ currentFile_.c_str() };
-        LoadAudioFile(cf);
+        FString cf = Utterance.Path;
+        currentFile_ = std::experimental::filesystem::u8path(TCHAR_TO_UTF8(*cf));
+        CurrentPriority = Utterance.Priority;
+        if (bBargeIn) {
+            FSGComManager::MarkBargeIn(Utterance.QueuedTime);
+            bBargeIn = false;
+        }
+        FSGLatencyTracer& LatencyTracer = FSGLatencyTracer::Get();
+        LatencyTracer.Begin(cf, Utterance.QueuedTime);
+
+        // Compressed files are decoded block by block while the engine analyses them
+        const bool bCompressed = FSGCompressedAudioDecoder::IsSupported(cf);
+        if (bCompressed) {
+            if (!Decoder.Start(cf, EngineSampleType, EngineSampleRate, FSGComSettings::Get().AudioBlockMs)) {
+                UE_LOG(LogTemp, Warning, TEXT("[APP] : Skipped %s, it could not be decoded"), *cf);
+                return;
+            }
+            bDecodeActive = true;
+        }
+        else {
+            LoadAudioFile(cf);
+            if (!IsEngineFormat()) {
+                UE_LOG(LogTemp, Warning, TEXT("[APP] : Skipped %s, it is not in the input format of the engine (%d Hz, %d bit, format %d)"),
+                       *cf, SampleRate, BitsPerSample, AudioFormat);
+                return;
+            }
+        }
+        LatencyTracer.Mark(ESGLatencyStage::Loaded);
+
+        // Take the animation if it was analysed ahead, and start on the files after it
+        double PreAnalysedStartMs = 0.0;
+        SG_COM_PlayerHandle PreAnalysedPlayer = LookAhead.Acquire(cf, PreAnalysedStartMs);
+        ScheduleLookAhead();
+
         std::error_code ec;
         std::experimental::filesystem::remove(currentFile_, ec);
 
         UE_LOG(LogTemp, Warning, TEXT("[APP] : master tick"));
-        // Input audio file data        
-        FSGComManager::InputAudio(AudioFileData);
-        bProcessAudio = true;
 
-        // Launch the process frame thread
-        FrameFuture = Async(EAsyncExecution::Thread, [&]() { ProcessFrameWorker(); });
+        // Speak the reply, ignoring live input until it finished
+        if (AudioCapture.IsCapturing()) {
+            AudioCapture.SetMuted(true);
+            FSGComManager::SetRole(SG_COM_ROLE_SPEAK);
+        }
 
-        // Play audio
-        UGameplayStatics::PlaySound2D(this, AudioClip);
+        // Input audio file data, the engine keeps generating idle while a pre-analysed file plays
+        if (bCompressed) {
+            DrainDecoder();
+        }
+        else if (PreAnalysedPlayer) {
+            FSGComManager::PlayPreAnalysed(PreAnalysedPlayer, PreAnalysedStartMs);
+            FSGComManager::PlayAudio(AudioSampleData);
+
+            // Analysed and buffered ahead, the animation is ready on input
+            LatencyTracer.Mark(ESGLatencyStage::Input);
+            LatencyTracer.Mark(ESGLatencyStage::FirstProcessed);
+            LatencyTracer.Mark(ESGLatencyStage::StartThreshold);
+        }
+        else {
+            FSGComManager::InputAudio(AudioSampleData);
+            LatencyTracer.Mark(ESGLatencyStage::Input);
+        }
+        // Launch the process frame thread
+        StartFrameWorker();
     }
 
     // RP: I don't like this method - we should not poll the FS every second
     auto delta = FDateTime::Now() - LastWatchEventCall;
     if (delta.GetTotalSeconds() > 1) {
         LastWatchEventCall = FDateTime::Now();
+        DiscoveryIndex.BeginScan();
         for (auto& p : watchPaths_) {
-            for (auto& f : std::experimental::filesystem::directory_iterator(p)) {
-                const auto& ext = f.path().extension().string();
-                if (ext != ".wav") {
-                    continue;
-                }
-
-                if (std::experimental::filesystem::is_regular_file(f)) {
-                    auto itr = filesDiscovered_.find(f);
-                    if (itr == filesDiscovered_.end()) {
-                        filesDiscovered_.emplace(f, false);
-                        fileQueue_.push_back(f);
-                    }
-                }
-            }
+            ScanWatchedFolder(p, true);
         }
+        DiscoveryIndex.EndScan();
+        ScheduleLookAhead();
     }
 
 }
@@ -187,17 +360,14 @@ void ASGComUE4FileExampleGameModeBase::Tick(float DeltaSeconds)
 // ========================================================
 void ASGComUE4FileExampleGameModeBase::LoadAudioFile(const FString FilePath)
 {   
-    // Creates the USoundWave object used to play the audio
-    AudioClip = NewObject<USoundWave>(USoundWave::StaticClass());
-
     // Resets audio related member variable values
     SampleRate = 0;
     BitsPerSample = 0;
     AudioFormat = 0;
     AudioLength = 0.f;
 
-    // Loads the audio file into an array
-    TArray<uint8> RawAudioData;
+    // Loads the audio file into an array, reusing its allocation between files
+    AudioSampleData = TArrayView<const uint8>();
     auto pcd = FPaths::ProjectContentDir() + FilePath;
     if (!IFileManager::Get().FileExists(*pcd)) {
         pcd = FilePath;
@@ -231,69 +401,320 @@ void ASGComUE4FileExampleGameModeBase::LoadAudioFile(const FString FilePath)
         // Checks the file is mono
         check(NumOfChannels == 1);
         
-        // Sets the duration of the clip
-        uint32 ByteRate = NumOfChannels * (BitsPerSample / 8) * SampleRate;
-        check(ByteRate)
-        AudioClip->Duration = *WaveInfo.pWaveDataSize / ByteRate;
-        
-        // Sets the sample rate, number of channels and data size of the sound wave asset
-        AudioClip->SetSampleRate(SampleRate);
-        AudioClip->NumChannels = NumOfChannels;
-        AudioClip->RawPCMDataSize = AudioDataSize;
-
-        // Copies the audio data to the sound wave asset
-        AudioClip->RawPCMData = static_cast<uint8*>(FMemory::Malloc(AudioDataSize));
-        FMemory::Memcpy(AudioClip->RawPCMData, WaveInfo.SampleDataStart, AudioDataSize);
-
-        // Copies the audio data to the array which is to be input to SG Com
-        AudioFileData = TArray<uint8>(WaveInfo.SampleDataStart, AudioDataSize);
+        // The audio data to be input to SG Com and played, it is copied into pooled blocks on input
+        AudioSampleData = TArrayView<const uint8>(WaveInfo.SampleDataStart, AudioDataSize);
 
         // Gets the length of the audio
         uint32 SizeOfSample = BitsPerSample / 8;
         uint32 NumSamples = AudioDataSize / SizeOfSample;
         AudioLength = (float)NumSamples / (float)SampleRate;
     }
+}
 
-    // Checks the audio clip is valid
-    check(AudioClip);
+// ========================================================
+// Check if the loaded audio file is in the input format of
+// the engine
+// ========================================================
+bool ASGComUE4FileExampleGameModeBase::IsEngineFormat() const
+{
+    const bool bSampleTypeMatches =
+        (EngineSampleType == SG_AUDIO_INT_16 && AudioFormat == 0x0001 && BitsPerSample == 16) ||
+        (EngineSampleType == SG_AUDIO_INT_32 && AudioFormat == 0x0001 && BitsPerSample == 32) ||
+        (EngineSampleType == SG_AUDIO_FLOAT_32 && AudioFormat == 0x0003 && BitsPerSample == 32);
+    return bSampleTypeMatches && SampleRate == EngineSampleRate && AudioSampleData.Num() > 0;
 }
 
 // ========================================================
-// Setup the SG_Com engine configuration
+// Report the wav files in a watched folder to the
+// discovery index
 // ========================================================
-TArray<uint8> CharacterFileData;
-void ASGComUE4FileExampleGameModeBase::SetupEngineConfig(SG_COM_EngineConfig& EngineConfig)
+void ASGComUE4FileExampleGameModeBase::ScanWatchedFolder(const std::experimental::filesystem::path& Folder, bool bQueue)
+{
+    std::error_code ec;
+    for (auto& f : std::experimental::filesystem::directory_iterator(Folder, ec)) {
+        const auto& ext = f.path().extension().string();
+        if (ext != ".wav" && !FSGCompressedAudioDecoder::IsSupported(FString(f.path().c_str()))) {
+            continue;
+        }
+
+        if (!std::experimental::filesystem::is_regular_file(f, ec)) {
+            continue;
+        }
+
+        // There is no portable inode, a file is identified by its path, modification time and size
+        const auto ModTime = std::experimental::filesystem::last_write_time(f, ec);
+        const auto Size = std::experimental::filesystem::file_size(f, ec);
+        if (ec) {
+            continue;
+        }
+
+        DiscoveryIndex.Observe(FString(f.path().c_str()), (int64)ModTime.time_since_epoch().count(), (int64)Size, bQueue);
+    }
+}
+
+// ========================================================
+// Get the counters sampled into the soak report
+// ========================================================
+FSGSoakCounters ASGComUE4FileExampleGameModeBase::GetSoakCounters() const
+{
+    const FSGBufferMetrics Metrics = FSGComManager::GetBufferController().GetMetrics();
+
+    FSGSoakCounters Counters;
+    Counters.NumQueuedFiles = DiscoveryIndex.NumQueued();
+    Counters.NumDiscoveredFiles = DiscoveryIndex.Num();
+    Counters.NumUtterances = Metrics.NumUtterances;
+    Counters.NumUnderruns = Metrics.NumUnderruns;
+    Counters.AudioPoolBytes = FSGComManager::GetMemoryReport().AudioPoolAllocatedBytes;
+
+    // Totals since the start, the soak monitor reports the cost per interval
+    const FSGAnimationCost AnimationCost = FSGComManager::GetAnimationCost();
+    Counters.bBakedAnimation = FSGComManager::GetAnimationType() == SG_BAKED_ANIMATION;
+    Counters.NumPlayerUpdates = AnimationCost.NumPlayerUpdates;
+    Counters.PlayerUpdateSec = AnimationCost.PlayerUpdateSec;
+    Counters.NumAvatarFrames = AnimationCost.NumAvatarFrames;
+    Counters.AvatarApplySec = AnimationCost.AvatarApplySec;
+
+    const FSGVoiceGateMetrics VoiceGate = FSGComManager::GetVoiceGateMetrics();
+    Counters.VadSkippedMs = VoiceGate.SkippedMs;
+    Counters.VadCpuSavedMs = VoiceGate.CpuSavedMs;
+    return Counters;
+}
+
+// ========================================================
+// Time the animation of an avatar with the rig logic
+// running and bypassed
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::BenchmarkAnimation(USkeletalMeshComponent* Mesh, int32 NumFrames)
+{
+    FSGAnimationBenchmarkResult Result;
+    if (!FSGAnimationBenchmark::Run(Mesh, NumFrames, Result)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Animation benchmark needs a skeletal mesh and at least one frame"));
+        return;
+    }
+
+    const bool bBaked = FSGComManager::GetAnimationType() == SG_BAKED_ANIMATION;
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : %s animation takes %.1f us per frame with rig logic, %.1f us with it bypassed"),
+           bBaked ? TEXT("Baked") : TEXT("Normal"), Result.RigLogicUs, Result.BypassedUs);
+    if (SoakMonitor.IsRunning()) {
+        SoakMonitor.RecordAnimationBenchmark(bBaked, Result.NumFrames, Result.RigLogicUs, Result.BypassedUs);
+    }
+}
+
+// ========================================================
+// Queue the audio received by the ingest endpoint
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::DrainIngest()
+{
+    if (!IngestServer.IsRunning()) {
+        return;
+    }
+
+    // The blocks are played as they are fed to the engine
+    FSGIngestFrame Frame;
+    while (IngestServer.PopFrame(Frame)) {
+        const bool bNewUtterance = !bIngestUtteranceActive || Frame.UtteranceId != IngestUtteranceId;
+        const bool bEndOfUtterance = (Frame.Flags & SG_INGEST_FLAG_END_OF_UTTERANCE) != 0;
+        const bool bQueued = FSGComManager::InputAudio(Frame.Data, bNewUtterance, bEndOfUtterance);
+
+        if (bNewUtterance) {
+            IngestUtteranceId = Frame.UtteranceId;
+            bIngestUtteranceActive = true;
+        }
+
+        if (bEndOfUtterance) {
+            bIngestUtteranceActive = false;
+        }
+
+        IngestServer.Acknowledge(Frame, bQueued ? SG_INGEST_STATUS_OK : SG_INGEST_STATUS_DROPPED, bQueued ? Frame.Data.Num() : 0);
+    }
+}
+
+// ========================================================
+// Queue the blocks decoded from a compressed file for the
+// engine and playback
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::DrainDecoder()
+{
+    if (!bDecodeActive) {
+        return;
+    }
+
+    FSGDecodedBlock Block;
+    while (Decoder.PopBlock(Block)) {
+        FSGComManager::InputAudio(Block.Data, Block.bFirst, Block.bLast);
+        if (Block.bFirst) {
+            FSGLatencyTracer::Get().Mark(ESGLatencyStage::Input);
+        }
+
+        // The Frame Worker keeps running until the last block is queued
+        if (Block.bLast) {
+            bDecodeActive = false;
+        }
+    }
+}
+
+// ========================================================
+// Start streaming live audio into the engine
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartCapture()
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    if (Settings.CaptureSource == ESGCaptureSource::None) {
+        return;
+    }
+
+    AudioCapture.Configure(EngineSampleType, EngineSampleRate, Settings.CaptureBlockMs);
+
+    bool bStarted = false;
+    if (Settings.CaptureSource == ESGCaptureSource::Device) {
+        bStarted = AudioCapture.StartDevice();
+    }
+    else {
+        bStarted = AudioCapture.StartFile(Settings.CaptureFile);
+    }
+
+    if (bStarted) {
+        FSGComManager::SetRole(Settings.CaptureRole);
+        FSGComManager::SetCaptureSource(&AudioCapture);
+    }
+}
+
+// ========================================================
+// Analyse the next queued files ahead on the spare engines
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::ScheduleLookAhead()
+{
+    if (!LookAhead.IsRunning()) {
+        return;
+    }
+
+    // Compressed files are decoded while they are analysed instead
+    TArray<FString> NextPaths;
+    DiscoveryIndex.PeekNext(LookAhead.GetNumSlots(), NextPaths);
+    NextPaths.RemoveAll([](const FString& Path) { return FSGCompressedAudioDecoder::IsSupported(Path); });
+    LookAhead.Schedule(NextPaths);
+}
+
+// ========================================================
+// Check if a queued utterance should interrupt the playing
+// one
+// ========================================================
+bool ASGComUE4FileExampleGameModeBase::ShouldInterrupt() const
+{
+    const int32 InterruptPriority = FSGComSettings::Get().InterruptPriority;
+    if (InterruptPriority <= 0 || !PlaybackSoundWave || !PlaybackSoundWave->Playback.IsPlaying()) {
+        return false;
+    }
+
+    int32 NextPriority = 0;
+    return DiscoveryIndex.PeekPriority(NextPriority) && NextPriority >= InterruptPriority && NextPriority > CurrentPriority;
+}
+
+// ========================================================
+// Stop the playing utterance and the processing thread
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::InterruptUtterance()
+{
+    // The processing thread stops after its current tick, the engine is only
+    // reset once it returned. The audio stops at once.
+    bProcessAudio = false;
+    bInterruptPending = true;
+    FSGComManager::FlushPlayback();
+
+    Decoder.Stop();
+    bDecodeActive = false;
+}
+
+// ========================================================
+// Start the sound playing the audio fed to the engine
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartPlayback()
+{
+    // Every utterance is fed in the engine input format, files in another
+    // format are skipped, so one sound wave at the engine rate plays them all.
+    // The playback converts the samples to the 16 bit PCM it renders.
+    PlaybackSoundWave = NewObject<USGPlaybackSoundWave>(this);
+    PlaybackSoundWave->SetSampleRate(EngineSampleRate);
+    PlaybackSoundWave->NumChannels = 1;
+    PlaybackSoundWave->Duration = INDEFINITELY_LOOPING_DURATION;
+    PlaybackSoundWave->SoundGroup = SOUNDGROUP_Voice;
+    FSGComManager::SetPlayback(&PlaybackSoundWave->Playback);
+
+    AudioComponent = UGameplayStatics::SpawnSound2D(this, PlaybackSoundWave, 1.f, 1.f, 0.f, nullptr, false, false);
+}
+
+// ========================================================
+// Called when the latest utterance finished playing
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::OnPlaybackFinished()
+{
+    FSGComManager::ClearAudioClock();
+
+    // Back to the live input
+    if (AudioCapture.IsCapturing()) {
+        FSGComManager::SetRole(FSGComSettings::Get().CaptureRole);
+        AudioCapture.SetMuted(false);
+    }
+}
+
+// ========================================================
+// Load the character file
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::LoadCharacterFile()
 {
-    // Load character file
     FFileHelper::LoadFileToArray(CharacterFileData, *(CharacterFileDirectory + "Avatar.k"));
     UE_LOG(LogTemp, Warning, TEXT("[APP] : Character file size: %d"), CharacterFileData.Num());
+}
 
+// ========================================================
+// Setup the SG_Com engine configuration, bBroadcast for
+// the Engines that may feed the fan-out Players
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::SetupEngineConfig(SG_COM_EngineConfig& EngineConfig, bool bBroadcast)
+{
     EngineConfig.character_file_in_memory = (sg_byte*)CharacterFileData.GetData();
     EngineConfig.character_file_bytes = CharacterFileData.Num();
-    EngineConfig.audio_sample_type = MapSampleType(AudioFormat, BitsPerSample);
-    EngineConfig.audio_sample_rate = MapSampleRate(SampleRate);
-    EngineConfig.engine_broadcast_callback = nullptr;
+    EngineConfig.audio_sample_type = EngineSampleType;
+    EngineConfig.audio_sample_rate = MapSampleRate(EngineSampleRate);
+    EngineConfig.engine_broadcast_callback = bBroadcast && FSGComSettings::Get().FanOutPlayers > 0 ? &ASGComUE4FileExampleGameModeBase::EngineBroadcastCallback : nullptr;
     EngineConfig.engine_status_callback = &ASGComUE4FileExampleGameModeBase::EngineStatusCallback;
-    EngineConfig.buffer_sec = 200;
+    EngineConfig.buffer_sec = (float)FSGComSettings::Get().EngineBufferSec;
     EngineConfig.flag = SG_COM_EngineConfigFlag::SG_COM_ENGINE_CONFIG_ENABLE_IDLE;
     EngineConfig.custom_engine_data = this;
 }
 
 
+// ========================================================
+// Start the ProcessFrameWorker thread
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartFrameWorker()
+{
+    bProcessAudio = true;
+    const uint32 Generation = WorkerGeneration.Load();
+    FrameFuture = Async(EAsyncExecution::Thread, [this, Generation]() { ProcessFrameWorker(Generation); });
+}
+
 // ========================================================
 // Process audio data in the engine
 // ========================================================
-void ASGComUE4FileExampleGameModeBase::ProcessFrameWorker()
+void ASGComUE4FileExampleGameModeBase::ProcessFrameWorker(uint32 Generation)
 {
     double StartTime;
     double TimeTaken;
     float SleepTime;
 
-    while (bProcessAudio) {
+    while (bProcessAudio && Generation == WorkerGeneration.Load()) {
         StartTime = FPlatformTime::Seconds();
         int remaining_frames{ 0 };
         FSGComManager::ProcessAudio(&remaining_frames);
+
+        // Retired while stuck in the tick, the replacement worker owns the state now
+        if (Generation != WorkerGeneration.Load()) {
+            return;
+        }
+
         TimeTaken = FPlatformTime::Seconds() - StartTime;
+        SoakMonitor.RecordProcessTick(TimeTaken);
         
         if (TimeTaken < 0.01)
         {
@@ -301,7 +722,7 @@ void ASGComUE4FileExampleGameModeBase::ProcessFrameWorker()
             FPlatformProcess::Sleep(SleepTime);
         }
 
-        if (remaining_frames == 0 && !fileQueue_.empty()) {
+        if (remaining_frames == 0 && DiscoveryIndex.NumQueued() > 0 && !bDecodeActive) {
             //done = true;
             //LoadAudioFile("Resources\\Audio\\traci1.wav");
             //FSGComManager::InputAudio(AudioFileData);
@@ -313,17 +734,147 @@ void ASGComUE4FileExampleGameModeBase::ProcessFrameWorker()
 
 }
 
+// ========================================================
+// Create a warm spare engine on a background thread
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartSpareEngine()
+{
+    if (!FSGComSettings::Get().WatchdogSpareEngine || (SpareFuture.IsValid() && !SpareFuture.IsReady())) {
+        return;
+    }
+
+    // Read on the game thread, only the creation runs in the background. The
+    // callback cannot be set once the spare takes over, its packets are
+    // ignored until then.
+    SG_COM_EngineConfig EngineConfig;
+    SetupEngineConfig(EngineConfig, true);
+    const float PlayerBufferSec = FSGComManager::GetBufferController().GetPlayerBufferSec();
+    SpareFuture = Async(EAsyncExecution::Thread, [EngineConfig, PlayerBufferSec]() {
+        return FSGComManager::CreateSpareEngine(EngineConfig, PlayerBufferSec);
+    });
+}
+
+// ========================================================
+// Move the session onto the spare engine
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::FailOverEngine()
+{
+    // A previous failed engine is still stuck, or there is no spare yet
+    if (StalledFrameFuture.IsValid() || !FSGComManager::HasSpareEngine()) {
+        return;
+    }
+
+    const bool bStalled = FSGComManager::GetWatchdog().IsStalled();
+    const bool bWasProcessing = FrameFuture.IsValid() && !FrameFuture.IsReady();
+
+    // Retire the worker, one stuck in a tick stops once the tick returns
+    WorkerGeneration++;
+    if (bStalled) {
+        StalledFrameFuture = MoveTemp(FrameFuture);
+    }
+    else if (FrameFuture.IsValid()) {
+        FrameFuture.Wait();
+    }
+
+    SG_COM_EngineHandle FailedEngine = nullptr;
+    SG_COM_PlayerHandle FailedPlayer = nullptr;
+    if (!FSGComManager::FailOver(FailedEngine, FailedPlayer)) {
+        return;
+    }
+
+    if (bStalled) {
+        StalledEngine = FailedEngine;
+        StalledPlayer = FailedPlayer;
+    }
+    else {
+        FSGComManager::DestroyFailedEngine(FailedEngine, FailedPlayer);
+    }
+
+    if (bWasProcessing) {
+        StartFrameWorker();
+    }
+    StartSpareEngine();
+}
+
+// ========================================================
+// Load or generate the shared idle loops on a background
+// thread, the avatars use the engine idle until they exist
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::StartIdleLoops()
+{
+    if (FSGComSettings::Get().IdleLoops <= 0) {
+        return;
+    }
+
+    IdleLoopFuture = Async(EAsyncExecution::Thread, [this]() {
+        SG_COM_EngineConfig EngineConfig;
+        SetupEngineConfig(EngineConfig, false);
+        const FSGComSettings& Settings = FSGComSettings::Get();
+        return FSGIdleLoopCache::Get().Build(EngineConfig,
+                                             FSGComManager::GetCharacterHash(),
+                                             FSGComManager::GetAnimationType(),
+                                             Settings.IdleLoops,
+                                             Settings.IdleLoopSec);
+    });
+}
+
 // ========================================================
 // Release resources
 // ========================================================
 void ASGComUE4FileExampleGameModeBase::EndSession()
 {
+    AudioCapture.Stop();
+    FSGComManager::SetCaptureSource(nullptr);
+    IngestServer.Shutdown();
+    FSGPoseStream::Get().Shutdown();
+    SoakMonitor.Stop(GetSoakCounters());
+    Decoder.Stop();
+    bDecodeActive = false;
+    FSGLatencyTracer::Get().Update();
+
     bProcessAudio = false;
+    WorkerGeneration++;
 
     // Wait for threads to complete
+    if (BootstrapFuture.IsValid()) {
+        BootstrapFuture.Wait();
+    }
     if (FrameFuture.IsValid()) {
         FrameFuture.Get();
     }
+    if (SpareFuture.IsValid()) {
+        SpareFuture.Wait();
+    }
+    if (IdleLoopFuture.IsValid()) {
+        IdleLoopFuture.Wait();
+    }
+
+    // A failed engine still stuck in a tick cannot be destroyed safely
+    if (StalledEngine) {
+        if (StalledFrameFuture.IsReady()) {
+            FSGComManager::DestroyFailedEngine(StalledEngine, StalledPlayer);
+        }
+        else {
+            UE_LOG(LogTemp, Warning, TEXT("[APP] : Leaving the failed engine, its tick never returned"));
+        }
+        StalledEngine = nullptr;
+        StalledPlayer = nullptr;
+    }
+
+    // Stop the playback and return its blocks to the pool
+    FSGComManager::SetPlayback(nullptr);
+    if (AudioComponent) {
+        AudioComponent->Stop();
+        AudioComponent = nullptr;
+    }
+    if (PlaybackSoundWave) {
+        PlaybackSoundWave->Playback.Reset();
+    }
+
+    FSGComManager::GetBufferController().LogMetrics();
+
+    // Release the spare engines
+    LookAhead.Shutdown();
 
     // Destroy the transceiver
     FSGComManager::DestroyEngine();
@@ -346,6 +897,17 @@ void ASGComUE4FileExampleGameModeBase::EngineStatusCallback(SG_COM_EngineHandle
     }
 }
 
+// ========================================================
+// Engine broadcast callback, called by the ticking thread
+// ========================================================
+void ASGComUE4FileExampleGameModeBase::EngineBroadcastCallback(SG_COM_EngineHandle Handle,
+                                                               char* packet,
+                                                               sg_size packet_bytes,
+                                                               void* custom_engine_data)
+{
+    FSGComManager::ReceiveBroadcast(Handle, packet, packet_bytes);
+}
+
 
 void ASGComUE4FileExampleGameModeBase::WatchKernelFolder(const FString& ProjectRelativeFolder) {
     std::string pstr = TCHAR_TO_UTF8(*ProjectRelativeFolder);
@@ -357,22 +919,17 @@ void ASGComUE4FileExampleGameModeBase::WatchKernelFolder(const FString& ProjectR
         return;
     }
 
-    for (auto& f : std::experimental::filesystem::directory_iterator(p)) {
-        const auto& ext = f.path().extension().string();
-        if (ext != ".wav") {
-            continue;
-        }
-
-        if (std::experimental::filesystem::is_regular_file(f)) {
-            auto itr = filesDiscovered_.find(f);
-            if (itr == filesDiscovered_.end()) {
-                filesDiscovered_.emplace(f, false);
-            }
-        }
-    }
+    // Files already in the folder are remembered but not played
+    ScanWatchedFolder(p, false);
 
     watchPaths_.push_back(pstr);
 
+    // Scripted soak arrivals go to the first watched folder
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    if (SoakMonitor.IsRunning() && watchPaths_.size() == 1 && !Settings.SoakUtteranceFile.IsEmpty()) {
+        SoakMonitor.SetArrivalScript(Settings.SoakUtteranceFile, ProjectRelativeFolder, Settings.SoakArrivalIntervalSec, Settings.SoakSeed);
+    }
+
     
     //FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::Get().LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
     //IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
@@ -1,16 +1,19 @@
 #pragma once
 
 #include "CommonStructs.h"
+#include "SGAudioIngestServer.h"
+#include "SGAudioPlayback.h"
+#include "SGCompressedAudioDecoder.h"
 #include "SGComManager.h"
+#include "SGDiscoveryIndex.h"
+#include "SGLookAhead.h"
+#include "SGSoakMonitor.h"
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
 #include "HAL/ThreadSafeBool.h"
-#include "Sound/SoundWave.h"
 #include <vector>
-#include <list>
 #include <string>
-#include <map>
 
 #define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
 #include <Experimental/filesystem>
@@ -20,6 +23,8 @@
 
 #include "SGComUE4FileExampleGameModeBase.generated.h"
 
+class UAudioComponent;
+class USkeletalMeshComponent;
 
 //DECLARE_DELEGATE(FStandardDelegateSignature)
 UCLASS()
@@ -31,6 +36,9 @@ public:
     // Constructor
     ASGComUE4FileExampleGameModeBase();
 
+    // Called before any actor runs BeginPlay, while the map is loading
+    void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
     // Called when play is started
     void StartPlay() override;
 
@@ -45,15 +53,77 @@ private:
     UFUNCTION(BlueprintCallable, Category = "SG")
     void LoadAudioFile(const FString FilePath);
 
+    // Check if the loaded audio file is in the input format of the engine
+    bool IsEngineFormat() const;
+
     /** Start watching kernel file for changes */
     UFUNCTION(BlueprintCallable, Category = "OpenCL Functions")
     void WatchKernelFolder(const FString& ProjectRelativeFolder = TEXT("Kernels"));
 
-    // Setup the SG_Com engine configuration
-    void SetupEngineConfig(SG_COM_EngineConfig& EngineConfig);
+    // Report the wav files in a watched folder to the discovery index, queueing the new ones if bQueue
+    void ScanWatchedFolder(const std::experimental::filesystem::path& Folder, bool bQueue);
+
+    // Start streaming live audio into the engine, if enabled in the settings
+    void StartCapture();
+
+    // Time the whole animation update and evaluation of an avatar with the
+    // rig logic in its post-process blueprint running and bypassed, logged
+    // and added to the soak report
+    UFUNCTION(BlueprintCallable, Category = "SG")
+    void BenchmarkAnimation(USkeletalMeshComponent* Mesh, int32 NumFrames = 300);
+
+    // Get the counters sampled into the soak report
+    FSGSoakCounters GetSoakCounters() const;
+
+    // Queue the audio received by the ingest endpoint for the engine and playback
+    void DrainIngest();
+
+    // Queue the blocks decoded from a compressed file for the engine and playback
+    void DrainDecoder();
+
+    // Analyse the next queued files ahead on the spare engines
+    void ScheduleLookAhead();
+
+    // Check if a queued utterance should interrupt the playing one
+    bool ShouldInterrupt() const;
+
+    // Stop the playing utterance and signal the processing thread to stop,
+    // the interrupt finishes on a later tick once the thread returned
+    void InterruptUtterance();
+
+    // Start the sound playing the audio fed to the engine, for the whole session
+    void StartPlayback();
+
+    // Called when the latest utterance finished playing
+    void OnPlaybackFinished();
+
+    // Initialize SG_Com, load the character and create the engine on background threads
+    void StartBootstrap();
+
+    // Start the session once the engine is ready
+    void StartSession();
+
+    // Load the character file
+    void LoadCharacterFile();
+
+    // Setup the SG_Com engine configuration, with the broadcast callback only
+    // for the Engines that may feed the fan-out Players
+    void SetupEngineConfig(SG_COM_EngineConfig& EngineConfig, bool bBroadcast);
+
+    // Process audio data in the engine, until stopped or a newer worker started
+    void ProcessFrameWorker(uint32 Generation);
+
+    // Start the ProcessFrameWorker thread
+    void StartFrameWorker();
 
-    // Process audio data in the engine
-    void ProcessFrameWorker();
+    // Create a warm spare engine on a background thread
+    void StartSpareEngine();
+
+    // Move the session onto the spare engine when the engine fails
+    void FailOverEngine();
+
+    // Load or generate the shared idle loops on a background thread
+    void StartIdleLoops();
 
     // Release resources
     void EndSession();
@@ -64,35 +134,107 @@ private:
                                      const char* Message,
                                      void* CustomEngineData);
 
+    // Engine broadcast callback, feeding the fan-out players
     static void EngineBroadcastCallback(SG_COM_EngineHandle Handle,
                                         char* packet,
                                         sg_size packet_bytes,
                                         void* custom_engine_data);
 
-    // Audio asset pointer
-    USoundWave* AudioClip;
+    // Plays the audio fed to the engine, created once per session
+    UPROPERTY()
+    USGPlaybackSoundWave* PlaybackSoundWave = nullptr;
+
+    UPROPERTY()
+    UAudioComponent* AudioComponent = nullptr;
+
+    // Time taken by each bootstrap stage (ms)
+    struct FBootstrapTimings
+    {
+        double InitializeMs = 0.0;
+        double CharacterLoadMs = 0.0;
+        double CreateEngineMs = 0.0;
+        double WarmUpMs = 0.0;
+        double TimeToReadyMs = 0.0;
+    };
+
+    // Holds the future of the bootstrap, true once the engine is ready
+    TFuture<bool> BootstrapFuture;
+    FBootstrapTimings BootstrapTimings;
+    double BootstrapStartTime = 0.0;
+    bool bSessionStarted = false;
+
+    // Contents of the character file, referenced by the engines
+    TArray<uint8> CharacterFileData;
 
     // Tracks if the ProcessFrameWorker thread should be processing audio
     FThreadSafeBool bProcessAudio = false;
 
+    // Live audio input
+    FSGAudioCapture AudioCapture;
+
+    // Spare engines analysing the next queued files
+    FSGLookAhead LookAhead;
+
+    // Soak test metrics and scripted arrivals
+    FSGSoakMonitor SoakMonitor;
+
+    // Local endpoint receiving audio from the TTS service
+    FSGAudioIngestServer IngestServer;
+
+    uint64 IngestUtteranceId = 0;
+    bool bIngestUtteranceActive = false;
+
+    // Decodes compressed files while the engine analyses them, active until
+    // the last block of the file is queued
+    FSGCompressedAudioDecoder Decoder;
+    FThreadSafeBool bDecodeActive;
+
     // Holds the future of the ProcessFrameWorker thread
     TFuture<void> FrameFuture;
 
+    // Incremented to retire a ProcessFrameWorker stuck in a tick
+    TAtomic<uint32> WorkerGeneration{ 0 };
+
+    // Spare engine creation, and a failed engine waiting for its stuck
+    // worker to return before it is destroyed
+    TFuture<bool> SpareFuture;
+    TFuture<void> StalledFrameFuture;
+    SG_COM_EngineHandle StalledEngine = nullptr;
+    SG_COM_PlayerHandle StalledPlayer = nullptr;
+
+    // Idle loops being loaded or generated
+    TFuture<bool> IdleLoopFuture;
+
     //IDirectoryWatcher::FDirectoryChanged Changed;
     //FStandardDelegateSignature DelegateHandle;
     //TArray<FString> WatchedFolders;
     FDateTime LastWatchEventCall;
 
-    // For passing the audio data to SG Com for processing
-    TArray<uint8> AudioFileData;
+    // Contents of the last loaded audio file
+    TArray<uint8> RawAudioData;
+
+    // For passing the audio data to SG Com for processing, points into RawAudioData
+    TArrayView<const uint8> AudioSampleData;
 
     std::vector<std::experimental::filesystem::path> watchPaths_;
-    std::list<std::experimental::filesystem::path> fileQueue_;
-    std::map< std::experimental::filesystem::path, bool> filesDiscovered_;
+    FSGDiscoveryIndex DiscoveryIndex;
     std::experimental::filesystem::path currentFile_;
 
-    uint32 SampleRate;
-    uint32 BitsPerSample;
-    uint32 AudioFormat;
-    float AudioLength;
+    // Priority of the utterance being played
+    int32 CurrentPriority = 0;
+
+    // An interrupt waits for the processing thread to return before the
+    // engine is reset and the utterance that barged in starts
+    bool bInterruptPending = false;
+    bool bBargeIn = false;
+
+    // Input format of the engine, from the settings when it is created
+    SG_AudioSampleType EngineSampleType = SG_AUDIO_INT_16;
+    uint32 EngineSampleRate = 16000;
+
+    // Format of the audio file loaded last
+    uint32 SampleRate = 16000;
+    uint32 BitsPerSample = 16;
+    uint32 AudioFormat = 0x0001;
+    float AudioLength = 0.f;
 };
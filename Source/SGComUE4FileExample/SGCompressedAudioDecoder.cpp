@@ -0,0 +1,173 @@
+#include "SGCompressedAudioDecoder.h"
+
+#include "SGComManager.h"
+
+#include "Async/Async.h"
+#include "Audio.h"
+#include "AudioDecompress.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Stats/Stats.h"
+
+#if WITH_OGGVORBIS
+#include "VorbisAudioInfo.h"
+#endif
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Decode Cost (ms per audio s)"), STAT_SGCom_DecodeCost, STATGROUP_SGCom);
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGCompressedAudioDecoder::~FSGCompressedAudioDecoder()
+{
+    Stop();
+}
+
+// ========================================================
+// Check if a file is in a format that can be decoded
+// ========================================================
+bool FSGCompressedAudioDecoder::IsSupported(const FString& Path)
+{
+#if WITH_OGGVORBIS
+    return FPaths::GetExtension(Path).Equals(TEXT("ogg"), ESearchCase::IgnoreCase);
+#else
+    return false;
+#endif
+}
+
+// ========================================================
+// Start decoding a file on a background thread
+// ========================================================
+bool FSGCompressedAudioDecoder::Start(const FString& Path, SG_AudioSampleType InSampleType, int32 InSampleRate, double BlockMs)
+{
+    Stop();
+
+#if WITH_OGGVORBIS
+    if (!FFileHelper::LoadFileToArray(CompressedData, *Path)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to read %s"), *Path);
+        return false;
+    }
+
+    LoadVorbisLibraries();
+    TSharedPtr<ICompressedAudioInfo> Info = MakeShared<FVorbisAudioInfo>();
+    FSoundQualityInfo QualityInfo;
+    if (!Info->ReadCompressedInfo(CompressedData.GetData(), CompressedData.Num(), &QualityInfo)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to read the Vorbis header of %s"), *Path);
+        return false;
+    }
+
+    // The engine does not resample
+    if ((int32)QualityInfo.SampleRate != InSampleRate || QualityInfo.NumChannels == 0) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : %s has %u Hz audio, the engine takes %d Hz"), *Path, QualityInfo.SampleRate, InSampleRate);
+        return false;
+    }
+
+    SampleType = InSampleType;
+    SampleRate = InSampleRate;
+    const int32 BlockFrames = FMath::Max(1, (int32)(BlockMs * SampleRate / 1000.0));
+    const uint32 NumChannels = QualityInfo.NumChannels;
+    const int64 TotalFrames = QualityInfo.SampleDataSize / (NumChannels * sizeof(int16));
+
+    bStop = false;
+    DecodeFuture = Async(EAsyncExecution::Thread, [this, Info, NumChannels, BlockFrames, TotalFrames]() {
+        Decode(Info, NumChannels, BlockFrames, TotalFrames);
+    });
+    return true;
+#else
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : No decoder for %s"), *Path);
+    return false;
+#endif
+}
+
+// ========================================================
+// Decode the whole file, one block at a time
+// ========================================================
+void FSGCompressedAudioDecoder::Decode(TSharedPtr<ICompressedAudioInfo> Info, uint32 NumChannels, int32 BlockFrames, int64 TotalFrames)
+{
+    TArray<int16> Frames;
+    Frames.SetNumUninitialized(BlockFrames * NumChannels);
+
+    double DecodeSec = 0.0;
+    int64 NumDecodedFrames = 0;
+    bool bFinished = false;
+    while (!bFinished && !bStop) {
+        const double StartTime = FPlatformTime::Seconds();
+        bFinished = Info->ReadCompressedData((uint8*)Frames.GetData(), false, Frames.Num() * sizeof(int16));
+
+        // The last block is padded with silence past the end of the stream
+        const int32 NumFrames = (int32)FMath::Min<int64>(BlockFrames, FMath::Max<int64>(0, TotalFrames - NumDecodedFrames));
+        bFinished = bFinished || NumDecodedFrames + NumFrames >= TotalFrames;
+
+        FSGDecodedBlock Block;
+        ConvertBlock(Frames.GetData(), NumFrames, NumChannels, Block.Data);
+        DecodeSec += FPlatformTime::Seconds() - StartTime;
+
+        Block.bFirst = NumDecodedFrames == 0;
+        Block.bLast = bFinished;
+        NumDecodedFrames += NumFrames;
+        Blocks.Enqueue(MoveTemp(Block));
+    }
+
+    // Benchmarked against the duration of the decoded audio
+    const double AudioSec = (double)NumDecodedFrames / SampleRate;
+    if (AudioSec > 0.0) {
+        const double CostMs = DecodeSec * 1000.0 / AudioSec;
+        SET_FLOAT_STAT(STAT_SGCom_DecodeCost, CostMs);
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Decoded %.2f s of Vorbis audio in %.2f ms, %.3f ms per audio second"),
+               AudioSec, DecodeSec * 1000.0, CostMs);
+    }
+}
+
+// ========================================================
+// Convert interleaved 16 bit frames to mono in the engine
+// input format
+// ========================================================
+void FSGCompressedAudioDecoder::ConvertBlock(const int16* Frames, int32 NumFrames, uint32 NumChannels, TArray<uint8>& OutData) const
+{
+    const int32 BytesPerSample = SampleType == SG_AUDIO_INT_16 ? 2 : 4;
+    OutData.SetNumUninitialized(NumFrames * BytesPerSample);
+
+    // Channels are averaged down to mono
+    const float Scale = 1.f / NumChannels;
+    for (int32 i = 0; i < NumFrames; ++i) {
+        const int16* Frame = Frames + i * NumChannels;
+        float Sum = 0.f;
+        for (uint32 c = 0; c < NumChannels; ++c) {
+            Sum += Frame[c];
+        }
+        const float Sample = Sum * Scale;
+
+        switch (SampleType) {
+            case SG_AUDIO_INT_16:
+                ((int16*)OutData.GetData())[i] = (int16)FMath::Clamp(FMath::RoundToInt(Sample), -32768, 32767);
+                break;
+            case SG_AUDIO_INT_32:
+                ((int32*)OutData.GetData())[i] = FMath::Clamp(FMath::RoundToInt(Sample), -32768, 32767) * 65536;
+                break;
+            default:
+                ((float*)OutData.GetData())[i] = Sample * (1.f / 32768.f);
+                break;
+        }
+    }
+}
+
+// ========================================================
+// Take the next decoded block
+// ========================================================
+bool FSGCompressedAudioDecoder::PopBlock(FSGDecodedBlock& OutBlock)
+{
+    return Blocks.Dequeue(OutBlock);
+}
+
+// ========================================================
+// Stop decoding and drop the blocks not taken
+// ========================================================
+void FSGCompressedAudioDecoder::Stop()
+{
+    bStop = true;
+    if (DecodeFuture.IsValid()) {
+        DecodeFuture.Wait();
+        DecodeFuture = TFuture<void>();
+    }
+    Blocks.Empty();
+}
@@ -0,0 +1,58 @@
+// Decodes a compressed audio file block by block on a background thread, so
+// the engine analyses the first blocks while the rest are still decoded
+
+#pragma once
+
+#include "SG.h"
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeBool.h"
+
+class ICompressedAudioInfo;
+
+// A block of decoded audio in the engine input format
+struct FSGDecodedBlock
+{
+    TArray<uint8> Data;
+    bool bFirst = false;
+    bool bLast = false;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGCompressedAudioDecoder
+{
+public:
+    ~FSGCompressedAudioDecoder();
+
+    // Check if a file is in a format that can be decoded. Only Ogg Vorbis
+    // has a decoder in this engine, Opus and FLAC files are not picked up.
+    static bool IsSupported(const FString& Path);
+
+    // Start decoding a file into mono blocks of BlockMs in the engine input
+    // format. The file must have the engine input sample rate.
+    bool Start(const FString& Path, SG_AudioSampleType InSampleType, int32 InSampleRate, double BlockMs);
+
+    // Take the next decoded block
+    bool PopBlock(FSGDecodedBlock& OutBlock);
+
+    // Stop decoding and drop the blocks not taken
+    void Stop();
+
+private:
+    // Decode the TotalFrames frames of the file, called on the decoding thread
+    void Decode(TSharedPtr<ICompressedAudioInfo> Info, uint32 NumChannels, int32 BlockFrames, int64 TotalFrames);
+
+    // Convert interleaved 16 bit frames to mono in the engine input format
+    void ConvertBlock(const int16* Frames, int32 NumFrames, uint32 NumChannels, TArray<uint8>& OutData) const;
+
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 SampleRate = 0;
+
+    // Read by the decoder until decoding finished
+    TArray<uint8> CompressedData;
+
+    TFuture<void> DecodeFuture;
+    TQueue<FSGDecodedBlock, EQueueMode::Spsc> Blocks;
+    FThreadSafeBool bStop;
+};
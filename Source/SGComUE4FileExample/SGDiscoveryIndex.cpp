@@ -0,0 +1,267 @@
+#include "SGDiscoveryIndex.h"
+
+#include "Hash/CityHash.h"
+#include "Misc/Paths.h"
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGDiscoveryIndex::FSGDiscoveryIndex()
+{
+}
+
+// ========================================================
+// Set the queue order and the maximum number of files
+// ========================================================
+void FSGDiscoveryIndex::Configure(ESGQueueOrder InOrder, int32 InMaxEntries)
+{
+    Order = InOrder;
+    if (MaxEntries != FMath::Max(1, InMaxEntries)) {
+        MaxEntries = FMath::Max(1, InMaxEntries);
+        Evicted.Reset();
+        EvictedRing.Reset();
+        EvictedHead = 0;
+    }
+
+    Queue.Heapify([this](const FQueuedFile& A, const FQueuedFile& B) { return PlaysBefore(A, B); });
+}
+
+// ========================================================
+// Start a scan of the watched folders
+// ========================================================
+void FSGDiscoveryIndex::BeginScan()
+{
+    CurrentScan++;
+}
+
+// ========================================================
+// Report a file found by the scan
+// ========================================================
+bool FSGDiscoveryIndex::Observe(const FString& Path, int64 ModTicks, int64 Size, bool bQueue)
+{
+    FEntry* Entry = Entries.Find(Path);
+    if (Entry && Entry->ModTicks == ModTicks && Entry->Size == Size) {
+        Entry->LastSeenScan = CurrentScan;
+        return false;
+    }
+
+    if (!Entry) {
+        Entry = &Entries.Add(Path);
+    }
+    else if (Entry->State == EState::Queued) {
+        // Rewritten while waiting, it keeps its place in the queue
+        Entry->ModTicks = ModTicks;
+        Entry->Size = Size;
+        Entry->LastSeenScan = CurrentScan;
+        return false;
+    }
+
+    Entry->ModTicks = ModTicks;
+    Entry->Size = Size;
+    Entry->LastSeenScan = CurrentScan;
+
+    if (!bQueue || Evicted.Contains(EvictedKey(Path, ModTicks))) {
+        Entry->State = EState::Processed;
+        return false;
+    }
+
+    Entry->State = EState::Queued;
+
+    FQueuedFile File;
+    File.Path = Path;
+    File.ModTicks = ModTicks;
+    File.Priority = ParsePriority(Path);
+    File.Sequence = NextSequence++;
+    File.QueuedTime = FPlatformTime::Seconds();
+    Queue.HeapPush(MoveTemp(File), [this](const FQueuedFile& A, const FQueuedFile& B) { return PlaysBefore(A, B); });
+    QueuedCount.Set(Queue.Num());
+
+    return true;
+}
+
+// ========================================================
+// Finish a scan, forgetting files that were processed and
+// are now gone
+// ========================================================
+void FSGDiscoveryIndex::EndScan()
+{
+    bool bPruneQueue = false;
+    for (auto It = Entries.CreateIterator(); It; ++It) {
+        if (It.Value().LastSeenScan != CurrentScan) {
+            bPruneQueue |= It.Value().State == EState::Queued;
+            It.RemoveCurrent();
+        }
+    }
+
+    // Forget the least recently seen processed files beyond the bound
+    if (Entries.Num() > MaxEntries) {
+        TArray<TPair<uint32, FString>> Processed;
+        for (const auto& Pair : Entries) {
+            if (Pair.Value.State == EState::Processed) {
+                Processed.Emplace(Pair.Value.LastSeenScan, Pair.Key);
+            }
+        }
+        Processed.Sort([](const TPair<uint32, FString>& A, const TPair<uint32, FString>& B) { return A.Key < B.Key; });
+
+        for (int32 i = 0; i < Processed.Num() && Entries.Num() > MaxEntries; ++i) {
+            const FEntry& Entry = Entries.FindChecked(Processed[i].Value);
+            AddEvicted(EvictedKey(Processed[i].Value, Entry.ModTicks));
+            Entries.Remove(Processed[i].Value);
+        }
+    }
+
+    if (bPruneQueue) {
+        PruneQueue();
+    }
+    Entries.Compact();
+}
+
+// ========================================================
+// Pop the next file to play
+// ========================================================
+bool FSGDiscoveryIndex::PopNext(FSGQueuedUtterance& OutUtterance)
+{
+    while (Queue.Num() > 0) {
+        FQueuedFile File;
+        Queue.HeapPop(File, [this](const FQueuedFile& A, const FQueuedFile& B) { return PlaysBefore(A, B); }, false);
+        QueuedCount.Set(Queue.Num());
+
+        FEntry* Entry = Entries.Find(File.Path);
+        if (Entry && Entry->State == EState::Queued) {
+            Entry->State = EState::Processed;
+            OutUtterance.Path = MoveTemp(File.Path);
+            OutUtterance.Priority = File.Priority;
+            OutUtterance.QueuedTime = File.QueuedTime;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ========================================================
+// Get the priority of the next file to play
+// ========================================================
+bool FSGDiscoveryIndex::PeekPriority(int32& OutPriority) const
+{
+    if (Queue.Num() == 0) {
+        return false;
+    }
+
+    OutPriority = Queue.HeapTop().Priority;
+    return true;
+}
+
+// ========================================================
+// Get the paths of the files to play next
+// ========================================================
+void FSGDiscoveryIndex::PeekNext(int32 Count, TArray<FString>& OutPaths) const
+{
+    OutPaths.Reset();
+    if (Count <= 0 || Queue.Num() == 0) {
+        return;
+    }
+
+    // Pop from a copy of the heap, files that are no longer queued are skipped
+    TArray<FQueuedFile> Heap = Queue;
+    while (Heap.Num() > 0 && OutPaths.Num() < Count) {
+        FQueuedFile File;
+        Heap.HeapPop(File, [this](const FQueuedFile& A, const FQueuedFile& B) { return PlaysBefore(A, B); }, false);
+
+        const FEntry* Entry = Entries.Find(File.Path);
+        if (Entry && Entry->State == EState::Queued) {
+            OutPaths.Add(MoveTemp(File.Path));
+        }
+    }
+}
+
+int32 FSGDiscoveryIndex::NumQueued() const
+{
+    return QueuedCount.GetValue();
+}
+
+int32 FSGDiscoveryIndex::Num() const
+{
+    return Entries.Num();
+}
+
+// ========================================================
+// Priority tag embedded in a file name
+// ========================================================
+int32 FSGDiscoveryIndex::ParsePriority(const FString& Path)
+{
+    // "reply.p5.wav" has the base name "reply.p5" and the tag extension "p5"
+    const FString Tag = FPaths::GetExtension(FPaths::GetBaseFilename(Path));
+    if (Tag.Len() < 2 || (Tag[0] != TEXT('p') && Tag[0] != TEXT('P'))) {
+        return 0;
+    }
+
+    const FString Number = Tag.RightChop(1);
+    return Number.IsNumeric() ? FCString::Atoi(*Number) : 0;
+}
+
+// ========================================================
+// Heap predicate, true if A is played before B
+// ========================================================
+bool FSGDiscoveryIndex::PlaysBefore(const FQueuedFile& A, const FQueuedFile& B) const
+{
+    if (A.Priority != B.Priority) {
+        return A.Priority > B.Priority;
+    }
+
+    switch (Order) {
+        case ESGQueueOrder::Name:
+            if (A.Path != B.Path) {
+                return A.Path < B.Path;
+            }
+            break;
+        case ESGQueueOrder::ModTime:
+            if (A.ModTicks != B.ModTicks) {
+                return A.ModTicks < B.ModTicks;
+            }
+            break;
+        case ESGQueueOrder::Arrival:
+        default:
+            break;
+    };
+
+    return A.Sequence < B.Sequence;
+}
+
+// ========================================================
+// Remove queued files that no longer have an entry
+// ========================================================
+void FSGDiscoveryIndex::PruneQueue()
+{
+    Queue.RemoveAll([this](const FQueuedFile& File) { return !Entries.Contains(File.Path); });
+    Queue.Heapify([this](const FQueuedFile& A, const FQueuedFile& B) { return PlaysBefore(A, B); });
+    QueuedCount.Set(Queue.Num());
+}
+
+// ========================================================
+// Key of a file version in the evicted set
+// ========================================================
+uint64 FSGDiscoveryIndex::EvictedKey(const FString& Path, int64 ModTicks)
+{
+    return CityHash64WithSeed((const char*)*Path, Path.Len() * sizeof(TCHAR), (uint64)ModTicks);
+}
+
+// ========================================================
+// Remember an evicted file version
+// ========================================================
+void FSGDiscoveryIndex::AddEvicted(uint64 Key)
+{
+    if (Evicted.Contains(Key)) {
+        return;
+    }
+
+    if (EvictedRing.Num() < MaxEntries) {
+        EvictedRing.Add(Key);
+    }
+    else {
+        Evicted.Remove(EvictedRing[EvictedHead]);
+        EvictedRing[EvictedHead] = Key;
+        EvictedHead = (EvictedHead + 1) % EvictedRing.Num();
+    }
+    Evicted.Add(Key);
+}
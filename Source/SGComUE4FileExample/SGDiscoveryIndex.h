@@ -0,0 +1,113 @@
+// Tracks the audio files found in the watched folders and the order to play them
+
+#pragma once
+
+#include "SGComSettings.h"
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+// A queued file popped from the index
+struct FSGQueuedUtterance
+{
+    FString Path;
+    int32 Priority = 0;
+
+    // When the file was discovered
+    double QueuedTime = 0.0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGDiscoveryIndex
+{
+public:
+    FSGDiscoveryIndex();
+
+    // Set the queue order and the maximum number of files remembered
+    void Configure(ESGQueueOrder InOrder, int32 InMaxEntries);
+
+    // Start a scan of the watched folders
+    void BeginScan();
+
+    // Report a file found by the scan. Returns true if the file is new, or
+    // changed since it was last seen, and it was queued.
+    bool Observe(const FString& Path, int64 ModTicks, int64 Size, bool bQueue = true);
+
+    // Finish a scan, forgetting files that were processed and are now gone
+    void EndScan();
+
+    // Pop the next file to play
+    bool PopNext(FSGQueuedUtterance& OutUtterance);
+
+    // Get the priority of the next file to play, false if none is queued
+    bool PeekPriority(int32& OutPriority) const;
+
+    // Get the paths of up to Count files to play next, in play order
+    void PeekNext(int32 Count, TArray<FString>& OutPaths) const;
+
+    // Number of queued files, safe to call from any thread
+    int32 NumQueued() const;
+
+    // Number of files remembered
+    int32 Num() const;
+
+    // Priority tag embedded in a file name as a ".p<N>" suffix before the
+    // extension, e.g. "reply.p5.wav". Files without a tag have priority 0.
+    // Higher priorities are always played first, the queue order applies
+    // between files of the same priority.
+    static int32 ParsePriority(const FString& Path);
+
+private:
+    enum class EState : uint8
+    {
+        Queued,
+        Processed
+    };
+
+    // What is remembered about a file, a file with a different modification
+    // time or size is treated as a new file
+    struct FEntry
+    {
+        int64 ModTicks = 0;
+        int64 Size = 0;
+        uint32 LastSeenScan = 0;
+        EState State = EState::Queued;
+    };
+
+    struct FQueuedFile
+    {
+        FString Path;
+        int64 ModTicks = 0;
+        int32 Priority = 0;
+        uint64 Sequence = 0;
+        double QueuedTime = 0.0;
+    };
+
+    // Heap predicate, true if A is played before B
+    bool PlaysBefore(const FQueuedFile& A, const FQueuedFile& B) const;
+
+    // Remove queued files that no longer have an entry
+    void PruneQueue();
+
+    // Key of a file version in the evicted set
+    static uint64 EvictedKey(const FString& Path, int64 ModTicks);
+
+    // Remember an evicted file version, forgetting the oldest beyond MaxEntries
+    void AddEvicted(uint64 Key);
+
+    ESGQueueOrder Order = ESGQueueOrder::Arrival;
+    int32 MaxEntries = 4096;
+
+    TMap<FString, FEntry> Entries;
+    TArray<FQueuedFile> Queue;
+    FThreadSafeCounter QueuedCount;
+
+    uint32 CurrentScan = 0;
+    uint64 NextSequence = 0;
+
+    // Files evicted to stay within MaxEntries, by path and modification time,
+    // are not queued again when found unchanged. Bounded to MaxEntries, the
+    // ring holds the keys oldest first from EvictedHead.
+    TSet<uint64> Evicted;
+    TArray<uint64> EvictedRing;
+    int32 EvictedHead = 0;
+};
@@ -0,0 +1,84 @@
+#include "SGEngineFeed.h"
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGEngineFeed::FSGEngineFeed(SG_COM_EngineHandle InEngine, FSGAudioBufferPool& InPool, int32 InCapacityBytes)
+    : Engine(InEngine)
+    , Pool(InPool)
+    , CapacityBytes(InCapacityBytes)
+{
+}
+
+FSGEngineFeed::~FSGEngineFeed()
+{
+    Flush();
+}
+
+// ========================================================
+// Copy audio into pooled blocks
+// ========================================================
+int32 FSGEngineFeed::Queue(FSGAudioSpanReader& Reader)
+{
+    int32 NumQueued = 0;
+    while (Reader.GetRemainingBytes() > 0) {
+        FSGAudioBlock* Block = Pool.Acquire();
+        if (!Block) {
+            break;
+        }
+
+        const int32 NumBytes = Reader.Read(Block->Data, Block->Capacity);
+        NumQueued += NumBytes;
+        PendingBytes.Add(NumBytes);
+        Blocks.Enqueue(Block);
+    }
+    return NumQueued;
+}
+
+// ========================================================
+// Input queued blocks while the engine input buffer has
+// room
+// ========================================================
+SG_COM_Error FSGEngineFeed::Feed(int32 BufferedBytes)
+{
+    FSGAudioBlock* Block = nullptr;
+    while (Blocks.Peek(Block) && (BufferedBytes <= 0 || BufferedBytes + Block->Data.Num() <= CapacityBytes)) {
+        const SG_COM_Error err = SG_COM_InputAudio(Engine, Block->Data.GetData(), Block->Data.Num());
+        if (err == SG_COM_Error::SG_COM_ERROR_INPUT_OVERRUN) {
+            // Try again once the engine has consumed more of its input
+            return SG_COM_Error::SG_COM_ERROR_OK;
+        }
+
+        BufferedBytes += Block->Data.Num();
+        Pool.Release(Dequeue());
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            return err;
+        }
+    }
+    return SG_COM_Error::SG_COM_ERROR_OK;
+}
+
+FSGAudioBlock* FSGEngineFeed::Dequeue()
+{
+    FSGAudioBlock* Block = nullptr;
+    if (!Blocks.Dequeue(Block)) {
+        return nullptr;
+    }
+    PendingBytes.Subtract(Block->Data.Num());
+    return Block;
+}
+
+int64 FSGEngineFeed::GetPendingBytes() const
+{
+    return PendingBytes.GetValue();
+}
+
+// ========================================================
+// Return all queued blocks to the pool
+// ========================================================
+void FSGEngineFeed::Flush()
+{
+    while (FSGAudioBlock* Block = Dequeue()) {
+        Pool.Release(Block);
+    }
+}
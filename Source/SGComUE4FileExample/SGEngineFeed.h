@@ -0,0 +1,50 @@
+// Pooled audio waiting for room in the input buffer of one SG_Com engine,
+// queued by FSGComManager::InputAudioBatch and fed by the thread that ticks
+// the engine
+
+#pragma once
+
+#include "SGAudioBufferPool.h"
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGEngineFeed
+{
+public:
+    // Feed Engine from blocks of Pool, keeping at most CapacityBytes in its
+    // input buffer
+    FSGEngineFeed(SG_COM_EngineHandle InEngine, FSGAudioBufferPool& InPool, int32 InCapacityBytes);
+    ~FSGEngineFeed();
+
+    SG_COM_EngineHandle GetEngine() const { return Engine; }
+
+    // Copy the audio of Reader into pooled blocks. Called from a single
+    // producer thread. Returns the number of bytes queued, fewer than the
+    // reader holds when the pool budget is used up.
+    int32 Queue(FSGAudioSpanReader& Reader);
+
+    // Input queued blocks while the engine input buffer, holding
+    // BufferedBytes, has room. Called on the thread that ticks the engine,
+    // between its ticks.
+    SG_COM_Error Feed(int32 BufferedBytes);
+
+    // Take the next queued block without feeding it, returned to the pool
+    // by the caller. Called on the feeding thread.
+    FSGAudioBlock* Dequeue();
+
+    int64 GetPendingBytes() const;
+
+    // Return all queued blocks to the pool, called on the feeding thread
+    void Flush();
+
+private:
+    SG_COM_EngineHandle Engine = nullptr;
+    FSGAudioBufferPool& Pool;
+    int32 CapacityBytes = 0;
+
+    TQueue<FSGAudioBlock*, EQueueMode::Spsc> Blocks;
+    FThreadSafeCounter64 PendingBytes;
+};
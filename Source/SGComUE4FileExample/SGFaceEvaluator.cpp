@@ -0,0 +1,273 @@
+#include "SGFaceEvaluator.h"
+
+#include "SGComManager.h"
+#include "SGComSettings.h"
+#include "SGLatencyTracer.h"
+#include "SGNodeKernels.h"
+#include "SGPoseStream.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Math/RandomStream.h"
+
+DECLARE_CYCLE_STAT(TEXT("Apply Animation"), STAT_SGCom_ApplyAnimation, STATGROUP_SGCom);
+DECLARE_CYCLE_STAT(TEXT("Pose Encode"), STAT_SGCom_PoseEncode, STATGROUP_SGCom);
+DECLARE_CYCLE_STAT(TEXT("Pose Decode"), STAT_SGCom_PoseDecode, STATGROUP_SGCom);
+
+// ========================================================
+// Class of every channel, setting its quantization on the
+// pose stream
+// ========================================================
+static TArray<ESGPoseChannelClass> GetPoseChannelClasses(const FSGNodeBinding& Binding)
+{
+    TArray<ESGPoseChannelClass> Classes;
+    Classes.Reserve(Binding.GetNumChannels());
+    for (const FSGBoundNode& Node : Binding.GetNodes()) {
+        for (int32 j = 0; j < Node.NumChannels; ++j) {
+            if (Node.Type != SG_JOINT) {
+                Classes.Add(ESGPoseChannelClass::Weight);
+            }
+            else if (j < 3) {
+                Classes.Add(ESGPoseChannelClass::Translation);
+            }
+            else if (j < 6) {
+                Classes.Add(ESGPoseChannelClass::Rotation);
+            }
+            else {
+                Classes.Add(ESGPoseChannelClass::Scale);
+            }
+        }
+    }
+    return Classes;
+}
+
+// ========================================================
+// Fetch the animation nodes of a Player and bind them,
+// when the Player or its nodes changed
+// ========================================================
+bool FSGFaceEvaluator::UpdateBinding(int32 PlayerIndex, const USkeleton* Skeleton, const USkeletalMeshComponent* Mesh)
+{
+    bool bNodesChanged = false;
+    if (FSGComManager::IsEngineValid())
+    {
+        // Fetched again when a pre-analysed utterance starts or finishes playing
+        const uint32 Generation = FSGComManager::GetBindingGeneration();
+        if ((AnimationNodes.Nodes == nullptr && AnimationNodes.NumNodes == 0) || Generation != BindingGeneration || PlayerIndex != BoundPlayerIndex)
+        {
+            FAvatarInfo AvatarInfo;
+            FSGComManager::GetAnimationNodes(AvatarInfo, PlayerIndex);
+
+            AnimationNodes.Nodes = AvatarInfo.AnimationNodes;
+            AnimationNodes.NumNodes = AvatarInfo.NumAnimationNodes;
+            BindingGeneration = Generation;
+            BoundPlayerIndex = PlayerIndex;
+            bNodesChanged = true;
+        }
+    }     
+    else
+    {
+        AnimationNodes.Nodes = nullptr;
+        AnimationNodes.NumNodes = 0;
+    }
+
+    if (AnimationNodes.NumNodes == 0 || !Skeleton || !Mesh) {
+        return false;
+    }
+
+    // Names are resolved once per character and skeleton, or loaded from the cache
+    const SG_AnimationType AnimationType = FSGComManager::GetAnimationType();
+    const bool bCheckBinding = bNodesChanged || NodeBinding.GetNodes().Num() != (int32)AnimationNodes.NumNodes;
+    if (bCheckBinding) {
+        if (!NodeBinding.IsBoundTo(AnimationNodes.Nodes, AnimationNodes.NumNodes, AnimationType)) {
+            NodeBinding.Bind(AnimationNodes.Nodes,
+                             AnimationNodes.NumNodes,
+                             AnimationType,
+                             FSGComManager::GetCharacterHash(),
+                             Skeleton,
+                             Mesh->SkeletalMesh);
+        }
+        ApplyNodeBatches = SelectSGNodeBatches(NodeBinding);
+
+        // Channels that were not bound are streamed as 0
+        StreamValues.Init(0.f, NodeBinding.GetNumChannels());
+        StreamEncoder.Configure(GetPoseChannelClasses(NodeBinding), FSGComSettings::Get().PoseStreamKeyframeInterval);
+    }
+    return IsBound();
+}
+
+bool FSGFaceEvaluator::IsBound() const
+{
+    return AnimationNodes.NumNodes > 0 && NodeBinding.GetNodes().Num() == (int32)AnimationNodes.NumNodes && ApplyNodeBatches;
+}
+
+// ========================================================
+// Drop the animation nodes and the binding
+// ========================================================
+void FSGFaceEvaluator::Reset()
+{
+    AnimationNodes = SGAnimationNodes();
+    BindingGeneration = 0;
+    NodeBinding.Reset();
+    ApplyNodeBatches = nullptr;
+    MorphValues.Reset();
+}
+
+// ========================================================
+// Apply the animation nodes to a pose
+// ========================================================
+bool FSGFaceEvaluator::Apply(FPoseContext& Output, USkeletalMeshComponent* MySkeletalMeshComponent, float DeltaSeconds, float MorphTargetWeight)
+{
+    if (!IsBound()) {
+        return false;
+    }
+
+    // The live channel values are rewritten by the game thread, only its snapshot is read
+    int32 NumSnapshotChannels = 0;
+    const float* SnapshotValues = FSGComManager::GetChannelSnapshot(BoundPlayerIndex, NumSnapshotChannels);
+    if (!SnapshotValues || NumSnapshotChannels != NodeBinding.GetNumChannels()) {
+        return false;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_SGCom_ApplyAnimation);
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    const TArray<FSGBoundNode>& BoundNodes = NodeBinding.GetNodes();
+    FSGKernelContext Context;
+    Context.Values = SnapshotValues;
+    Context.Binding = &NodeBinding;
+    Context.Output = &Output;
+    Context.MorphTargetWeight = MorphTargetWeight;
+
+    MorphValues.SetNumUninitialized(NodeBinding.GetMorphBatch().Num(), false);
+    Context.MorphValues = MorphValues.GetData();
+
+    // Blend from the pose shown when the last utterance was interrupted
+    float CrossfadeWeight = 0.f;
+    FSGComManager::GetCrossfade(CrossfadeSerial, CrossfadeSnapshot, CrossfadeWeight);
+    if (CrossfadeWeight > 0.f && CrossfadeSnapshot.Num() == NodeBinding.GetNumChannels()) {
+        CrossfadeValues.SetNumUninitialized(CrossfadeSnapshot.Num(), false);
+        for (int32 i = 0; i < BoundNodes.Num(); ++i) {
+            const int32 ChannelOffset = BoundNodes[i].ChannelOffset;
+            const float* AnimationData = SnapshotValues + ChannelOffset;
+            for (int32 j = 0; j < BoundNodes[i].NumChannels; ++j) {
+                CrossfadeValues[ChannelOffset + j] = FMath::Lerp(AnimationData[j], CrossfadeSnapshot[ChannelOffset + j], CrossfadeWeight);
+            }
+        }
+        Context.BlendedValues = CrossfadeValues.GetData();
+    }
+
+    BlendIdleLoops(Context, MySkeletalMeshComponent, DeltaSeconds);
+
+    const bool bStreaming = FSGPoseStream::Get().IsRunning() && StreamValues.Num() == NodeBinding.GetNumChannels();
+    if (bStreaming) {
+        Context.StreamValues = StreamValues.GetData();
+    }
+
+    ApplyNodeBatches(Context);
+    FSGLatencyTracer::Get().Mark(ESGLatencyStage::FirstEvaluate);
+
+    if (bStreaming) {
+        SendPose();
+    }
+
+    // Compared between normal and baked animation in the soak report
+    FSGComManager::AddAvatarCost(FPlatformTime::Cycles64() - StartCycles);
+
+    return true;
+}
+
+// ========================================================
+// Set the morph targets without a curve on the mesh
+// ========================================================
+void FSGFaceEvaluator::ApplyMorphTargets(USkeletalMeshComponent* Mesh) const
+{
+    const TArray<FSGMorphTarget>& MorphBatch = NodeBinding.GetMorphBatch();
+    if (!Mesh || MorphValues.Num() != MorphBatch.Num()) {
+        return;
+    }
+
+    for (int32 i = 0; i < MorphBatch.Num(); ++i) {
+        Mesh->SetMorphTarget(MorphBatch[i].Name, MorphValues[i], false);
+    }
+}
+
+// ========================================================
+// Blend the shared idle loops over the live animation,
+// each avatar plays its own loop from its own phase
+// ========================================================
+void FSGFaceEvaluator::BlendIdleLoops(FSGKernelContext& Context, const USkeletalMeshComponent* MySkeletalMeshComponent, float DeltaSeconds)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+    const bool bIdleLooping = FSGComManager::IsIdleLooping();
+    if (!IdleLoops.IsValid() && bIdleLooping) {
+        IdleLoops = FSGIdleLoopCache::Get().Find(FSGComManager::GetCharacterHash(), FSGComManager::GetAnimationType());
+        if (IdleLoops.IsValid()) {
+            FRandomStream Stream(GetTypeHash(MySkeletalMeshComponent->GetPathName()));
+            IdleLoop = Stream.RandRange(0, IdleLoops->Loops.Num() - 1);
+            IdlePhaseMs = Stream.FRandRange(0.f, (float)IdleLoops->GetDurationMs());
+        }
+    }
+
+    const int32 NumChannels = NodeBinding.GetNumChannels();
+    if (!IdleLoops.IsValid() || IdleLoops->NumChannels != NumChannels) {
+        IdleWeight = 0.f;
+        return;
+    }
+
+    const float BlendSec = FMath::Max(0.001f, (float)(Settings.IdleBlendMs / 1000.0));
+    const float Step = DeltaSeconds / BlendSec;
+    IdleWeight = FMath::Clamp(IdleWeight + (bIdleLooping ? Step : -Step), 0.f, 1.f);
+    if (IdleWeight <= 0.f) {
+        return;
+    }
+
+    IdleLoops->Sample(IdleLoop, FPlatformTime::Seconds() * 1000.0 + IdlePhaseMs, IdleValues);
+    if (IdleWeight >= 1.f) {
+        Context.BlendedValues = IdleValues.GetData();
+        return;
+    }
+
+    // Blend from the live values, which may already be cross-faded
+    const TArray<FSGBoundNode>& BoundNodes = NodeBinding.GetNodes();
+    const float* LiveValues = Context.BlendedValues ? Context.BlendedValues : Context.Values;
+    CrossfadeValues.SetNumUninitialized(NumChannels, false);
+    for (int32 i = 0; i < BoundNodes.Num(); ++i) {
+        const int32 ChannelOffset = BoundNodes[i].ChannelOffset;
+        const float* AnimationData = LiveValues + ChannelOffset;
+        for (int32 j = 0; j < BoundNodes[i].NumChannels; ++j) {
+            CrossfadeValues[ChannelOffset + j] = FMath::Lerp(AnimationData[j], IdleValues[ChannelOffset + j], IdleWeight);
+        }
+    }
+    Context.BlendedValues = CrossfadeValues.GetData();
+}
+
+// ========================================================
+// Encode the applied channel values and send them on the
+// pose stream
+// ========================================================
+void FSGFaceEvaluator::SendPose()
+{
+    if (StreamAvatar == INDEX_NONE) {
+        StreamAvatar = FSGPoseStream::Get().AllocateAvatar();
+    }
+
+    {
+        SCOPE_CYCLE_COUNTER(STAT_SGCom_PoseEncode);
+        StreamEncoder.Encode((uint16)StreamAvatar, StreamValues, StreamDatagrams);
+    }
+    for (const TArray<uint8>& Datagram : StreamDatagrams) {
+        FSGPoseStream::Get().Send(Datagram);
+    }
+
+    // Decoded as a viewer would, to measure the decode cost. Only the last
+    // part of a keyframe completes the frame.
+    if (FSGComSettings::Get().PoseStreamVerify) {
+        SCOPE_CYCLE_COUNTER(STAT_SGCom_PoseDecode);
+        bool bDecoded = false;
+        for (const TArray<uint8>& Datagram : StreamDatagrams) {
+            bDecoded = StreamDecoder.Decode(Datagram, StreamDecoded);
+        }
+        if (!bDecoded) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to decode pose frame"));
+        }
+    }
+}
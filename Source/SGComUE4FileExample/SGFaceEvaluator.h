@@ -0,0 +1,85 @@
+// Binds the SG animation nodes of a Player to a skeleton and applies them to a
+// pose. Shared by the anim instance proxy and the SG Face AnimGraph node.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "CommonStructs.h"
+#include "SGIdleLoops.h"
+#include "SGNodeKernels.h"
+#include "SGPoseCodec.h"
+
+struct SGAnimationNodes {
+    SG_AnimationNode* Nodes = nullptr;
+    sg_size NumNodes = 0;
+};
+
+struct SGCOMUE4FILEEXAMPLE_API FSGFaceEvaluator
+{
+    // Fetch the animation nodes of a Player and bind them to the skeleton
+    // when the Player or its nodes changed. Returns true once bound.
+    bool UpdateBinding(int32 PlayerIndex, const USkeleton* Skeleton, const USkeletalMeshComponent* Mesh);
+
+    // Check if the animation nodes are bound and can be applied
+    bool IsBound() const;
+
+    // Apply the animation nodes on top of a pose. The values of the morph
+    // targets without a curve are kept for ApplyMorphTargets, scaled by
+    // MorphTargetWeight, the weight the pose is blended with.
+    bool Apply(FPoseContext& Output, USkeletalMeshComponent* MySkeletalMeshComponent, float DeltaSeconds, float MorphTargetWeight = 1.f);
+
+    // Set the morph targets without a curve on the mesh, from the values of
+    // the last Apply. Called on the game thread before the next update, as
+    // the mesh must not be changed from the animation threads.
+    void ApplyMorphTargets(USkeletalMeshComponent* Mesh) const;
+
+    // Drop the animation nodes and the binding, they are fetched and bound again
+    void Reset();
+
+private:
+    // Animation nodes the binding is made from. Their channel values are
+    // rewritten on the game thread, Apply reads the published snapshot.
+    SGAnimationNodes AnimationNodes;
+
+    // Binding generation and Player the animation nodes were fetched for
+    uint32 BindingGeneration = 0;
+    int32 BoundPlayerIndex = 0;
+
+    // Bones, morph targets and curves the animation nodes are applied to
+    FSGNodeBinding NodeBinding;
+
+    // Applies the node batches present in the binding
+    FSGApplyBatchesFunc ApplyNodeBatches = nullptr;
+
+    // Values of the morph batch written by the last Apply. The game thread
+    // reads them between evaluations, so they need no lock.
+    TArray<float> MorphValues;
+
+    // Pose cross-faded from after an interrupt
+    uint32 CrossfadeSerial = 0;
+    TArray<float> CrossfadeSnapshot;
+    TArray<float> CrossfadeValues;
+
+    // Shared idle loops of the character, the loop and phase of this avatar
+    // and the weight of the loops over the live animation
+    FSGIdleLoopsPtr IdleLoops;
+    int32 IdleLoop = 0;
+    double IdlePhaseMs = 0.0;
+    float IdleWeight = 0.f;
+    TArray<float> IdleValues;
+
+    // Blend the shared idle loops over the live animation
+    void BlendIdleLoops(FSGKernelContext& Context, const USkeletalMeshComponent* MySkeletalMeshComponent, float DeltaSeconds);
+
+    // Applied channel values sent on the pose stream
+    int32 StreamAvatar = INDEX_NONE;
+    TArray<float> StreamValues;
+    TArray<TArray<uint8>> StreamDatagrams;
+    FSGPoseEncoder StreamEncoder;
+    FSGPoseDecoder StreamDecoder;
+    TArray<float> StreamDecoded;
+
+    // Encode the applied channel values and send them on the pose stream
+    void SendPose();
+};
@@ -0,0 +1,251 @@
+#include "SGIdleLoops.h"
+
+#include "SGBufferController.h"
+#include "SGComManager.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+
+// Bumped whenever the cache file layout changes
+static const int32 IdleLoopCacheVersion = 1;
+
+// Idle generated before recording, while the engine settles from the neutral pose
+static const int32 WarmUpFrames = 100;
+
+// Duration over which the end of a loop is blended into its start (ms)
+static const double SeamMs = 500.0;
+
+double FSGIdleLoops::GetDurationMs() const
+{
+    return NumFrames * FSGBufferController::FrameMs;
+}
+
+// ========================================================
+// Interpolate the channel values of a loop
+// ========================================================
+void FSGIdleLoops::Sample(int32 Loop, double TimeMs, TArray<float>& OutValues) const
+{
+    OutValues.SetNumUninitialized(NumChannels, false);
+    if (Loops.Num() == 0 || NumFrames == 0) {
+        return;
+    }
+
+    const double Position = FMath::Fmod(FMath::Abs(TimeMs) / FSGBufferController::FrameMs, (double)NumFrames);
+    const int32 Frame = FMath::Min((int32)Position, NumFrames - 1);
+    const int32 NextFrame = (Frame + 1) % NumFrames;
+    const float Alpha = (float)(Position - Frame);
+
+    const TArray<float>& Frames = Loops[Loop % Loops.Num()];
+    const float* Current = Frames.GetData() + Frame * NumChannels;
+    const float* Next = Frames.GetData() + NextFrame * NumChannels;
+    for (int32 i = 0; i < NumChannels; ++i) {
+        OutValues[i] = FMath::Lerp(Current[i], Next[i], Alpha);
+    }
+}
+
+// ========================================================
+// Read or write the loops in the cache file layout
+// ========================================================
+bool FSGIdleLoops::Serialize(FArchive& Ar)
+{
+    int32 Version = IdleLoopCacheVersion;
+    Ar << Version;
+    Ar << NumChannels;
+    Ar << NumFrames;
+    if (Version != IdleLoopCacheVersion || NumChannels <= 0 || NumFrames <= 0) {
+        return false;
+    }
+
+    Ar << Loops;
+    for (const TArray<float>& Loop : Loops) {
+        if (Loop.Num() != NumChannels * NumFrames) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ========================================================
+// The cache shared by all avatars
+// ========================================================
+FSGIdleLoopCache& FSGIdleLoopCache::Get()
+{
+    static FSGIdleLoopCache Cache;
+    return Cache;
+}
+
+// ========================================================
+// Get the loops of a character
+// ========================================================
+FSGIdleLoopsPtr FSGIdleLoopCache::Find(const FString& CharacterHash, SG_AnimationType AnimationType) const
+{
+    FScopeLock ScopeLock(&Lock);
+    const FSGIdleLoopsPtr* Loops = Characters.Find(GetKey(CharacterHash, AnimationType));
+    return Loops ? *Loops : FSGIdleLoopsPtr();
+}
+
+// ========================================================
+// Load or generate the loops of a character
+// ========================================================
+bool FSGIdleLoopCache::Build(SG_COM_EngineConfig EngineConfig, const FString& CharacterHash, SG_AnimationType AnimationType, int32 NumLoops, double LoopSec)
+{
+    if (Find(CharacterHash, AnimationType).IsValid()) {
+        return true;
+    }
+
+    const int32 LoopFrames = FMath::Max(1, (int32)(LoopSec * 1000.0 / FSGBufferController::FrameMs));
+    const int32 SeamFrames = FMath::Min(LoopFrames / 4, (int32)(SeamMs / FSGBufferController::FrameMs));
+
+    // The cache is invalidated by a change to the character through its name
+    const FString Key = GetKey(CharacterHash, AnimationType);
+    const FString CachePath = FPaths::ProjectSavedDir() / TEXT("SGIdleLoops") / FString::Printf(TEXT("%s_%dx%d.bin"), *Key, NumLoops, LoopFrames);
+
+    TSharedRef<FSGIdleLoops, ESPMode::ThreadSafe> Loops = MakeShared<FSGIdleLoops, ESPMode::ThreadSafe>();
+    TArray<uint8> Data;
+    bool bLoaded = false;
+    if (!CharacterHash.IsEmpty() && FFileHelper::LoadFileToArray(Data, *CachePath, FILEREAD_Silent)) {
+        FMemoryReader Reader(Data);
+        bLoaded = Loops->Serialize(Reader) && !Reader.IsError() && Loops->Loops.Num() == NumLoops && Loops->NumFrames == LoopFrames;
+    }
+
+    if (bLoaded) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Loaded idle loops from %s"), *CachePath);
+    }
+    else {
+        const double StartTime = FPlatformTime::Seconds();
+        if (!Generate(EngineConfig, AnimationType, NumLoops, LoopFrames, SeamFrames, *Loops)) {
+            return false;
+        }
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Generated %d idle loops of %.1f s in %.1f ms"),
+               NumLoops, Loops->GetDurationMs() / 1000.0, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+        if (!CharacterHash.IsEmpty()) {
+            FBufferArchive Writer;
+            Loops->Serialize(Writer);
+            if (!FFileHelper::SaveArrayToFile(Writer, *CachePath)) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to save idle loops to %s"), *CachePath);
+            }
+        }
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    Characters.Add(Key, Loops);
+    return true;
+}
+
+// ========================================================
+// Generate the idle loops on a dedicated engine
+// ========================================================
+bool FSGIdleLoopCache::Generate(SG_COM_EngineConfig EngineConfig, SG_AnimationType AnimationType, int32 NumLoops, int32 LoopFrames, int32 SeamFrames, FSGIdleLoops& OutLoops)
+{
+    SG_COM_PlayerConfig PlayerConfig;
+    PlayerConfig.character_file_in_memory = EngineConfig.character_file_in_memory;
+    PlayerConfig.character_file_bytes = EngineConfig.character_file_bytes;
+    PlayerConfig.animation_type = AnimationType;
+    PlayerConfig.buffer_sec = 1.f;
+
+    SG_COM_PlayerHandle Player = nullptr;
+    SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &Player);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create idle loop player: %d"), err);
+        LogException(err);
+        return false;
+    }
+
+    // The same loops are generated on every run
+    SG_COM_EngineHandle Engine = nullptr;
+    EngineConfig.local_player = Player;
+    EngineConfig.engine_broadcast_callback = nullptr;
+    EngineConfig.engine_status_callback = nullptr;
+    EngineConfig.custom_engine_data = nullptr;
+    EngineConfig.flag = (SG_COM_EngineConfigFlag)(SG_COM_ENGINE_CONFIG_ENABLE_IDLE | SG_COM_ENGINE_CONFIG_FIXED_RANDOM_SEED);
+    err = SG_COM_CreateEngine(&EngineConfig, &Engine);
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create idle loop engine: %d"), err);
+        LogException(err);
+        SG_COM_DestroyPlayer(Player);
+        return false;
+    }
+
+    // Every tick without input generates one frame of idle
+    const int32 NumFrames = NumLoops * LoopFrames + SeamFrames;
+    const int32 MaxTicks = WarmUpFrames + NumFrames * 2;
+    TArray<float> Recorded;
+    int32 NumRecorded = 0;
+    double NextTimeMs = -1.0;
+    for (int32 Tick = 0; Tick < MaxTicks && NumRecorded < NumFrames; ++Tick) {
+        int ProcessedFrames = 0;
+        int RemainingFrames = 0;
+        err = SG_COM_ProcessTick(Engine, &ProcessedFrames, &RemainingFrames);
+        if (err != SG_COM_Error::SG_COM_ERROR_OK && err != SG_COM_Error::SG_COM_ERROR_INPUT_UNDERRUN) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Idle loop tick failed: %d"), err);
+            LogException(err);
+            break;
+        }
+
+        double MinTimeMs = 0.0;
+        double MaxTimeMs = 0.0;
+        SG_COM_GetPlayableRange(Player, &MinTimeMs, &MaxTimeMs);
+        if (Tick < WarmUpFrames) {
+            continue;
+        }
+        if (NextTimeMs < 0.0) {
+            NextTimeMs = MaxTimeMs;
+        }
+
+        // Record every frame the player can play
+        while (NextTimeMs <= MaxTimeMs && NumRecorded < NumFrames) {
+            double CurrentTimeMs = 0.0;
+            SG_AnimationNode* Nodes = nullptr;
+            sg_size NumNodes = 0;
+            SG_COM_UpdateAnimation(Player, NextTimeMs, &CurrentTimeMs);
+            SG_COM_GetAnimationNodes(Player, &Nodes, &NumNodes);
+
+            const int32 FrameStart = Recorded.Num();
+            for (sg_size i = 0; i < NumNodes; ++i) {
+                Recorded.Append(Nodes[i].channel_values, Nodes[i].num_channels);
+            }
+            OutLoops.NumChannels = Recorded.Num() - FrameStart;
+
+            NumRecorded++;
+            NextTimeMs += FSGBufferController::FrameMs;
+        }
+    }
+
+    SG_COM_DestroyEngine(Engine);
+    SG_COM_DestroyPlayer(Player);
+
+    if (NumRecorded < NumFrames || OutLoops.NumChannels == 0) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Generated %d of %d idle frames"), NumRecorded, NumFrames);
+        return false;
+    }
+
+    // Blend the frames following each loop into its start, so it wraps without a jump
+    const int32 NumChannels = OutLoops.NumChannels;
+    OutLoops.NumFrames = LoopFrames;
+    OutLoops.Loops.SetNum(NumLoops);
+    for (int32 i = 0; i < NumLoops; ++i) {
+        const float* Start = Recorded.GetData() + i * LoopFrames * NumChannels;
+        TArray<float>& Loop = OutLoops.Loops[i];
+        Loop.Reset();
+        Loop.Append(Start, LoopFrames * NumChannels);
+
+        for (int32 Frame = 0; Frame < SeamFrames; ++Frame) {
+            const float Alpha = (float)Frame / SeamFrames;
+            const float* After = Start + (LoopFrames + Frame) * NumChannels;
+            float* Values = Loop.GetData() + Frame * NumChannels;
+            for (int32 j = 0; j < NumChannels; ++j) {
+                Values[j] = FMath::Lerp(After[j], Values[j], Alpha);
+            }
+        }
+    }
+    return true;
+}
+
+FString FSGIdleLoopCache::GetKey(const FString& CharacterHash, SG_AnimationType AnimationType)
+{
+    return AnimationType == SG_BAKED_ANIMATION ? CharacterHash + TEXT("_baked") : CharacterHash;
+}
@@ -0,0 +1,53 @@
+// Idle animation loops generated once per character and shared by all of its
+// silent avatars, so the engine does not have to generate idle for them
+
+#pragma once
+
+#include "SG.h"
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// Loops of idle animation, as the channel values of all animation nodes in
+// order for every frame
+struct SGCOMUE4FILEEXAMPLE_API FSGIdleLoops
+{
+    int32 NumChannels = 0;
+    int32 NumFrames = 0;
+    TArray<TArray<float>> Loops;
+
+    double GetDurationMs() const;
+
+    // Interpolate the channel values of a loop at TimeMs, wrapping around
+    void Sample(int32 Loop, double TimeMs, TArray<float>& OutValues) const;
+
+    // Read or write the loops in the cache file layout
+    bool Serialize(FArchive& Ar);
+};
+
+using FSGIdleLoopsPtr = TSharedPtr<const FSGIdleLoops, ESPMode::ThreadSafe>;
+
+class SGCOMUE4FILEEXAMPLE_API FSGIdleLoopCache
+{
+public:
+    // The cache shared by all avatars
+    static FSGIdleLoopCache& Get();
+
+    // Get the loops of a character, nullptr until they are built
+    FSGIdleLoopsPtr Find(const FString& CharacterHash, SG_AnimationType AnimationType) const;
+
+    // Load the loops of a character from the disk cache, or generate them
+    // on an engine created from EngineConfig with a fixed random seed.
+    // Blocks until done, called on a background thread.
+    bool Build(SG_COM_EngineConfig EngineConfig, const FString& CharacterHash, SG_AnimationType AnimationType, int32 NumLoops, double LoopSec);
+
+private:
+    // Generate NumLoops loops of LoopFrames frames, each blended into its start over SeamFrames
+    static bool Generate(SG_COM_EngineConfig EngineConfig, SG_AnimationType AnimationType, int32 NumLoops, int32 LoopFrames, int32 SeamFrames, FSGIdleLoops& OutLoops);
+
+    static FString GetKey(const FString& CharacterHash, SG_AnimationType AnimationType);
+
+    mutable FCriticalSection Lock;
+    TMap<FString, FSGIdleLoopsPtr> Characters;
+};
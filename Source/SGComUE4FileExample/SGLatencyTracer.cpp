@@ -0,0 +1,296 @@
+#include "SGLatencyTracer.h"
+
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Stats/Stats.h"
+
+#include "SGComManager.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Utterance Latency (ms)"), STAT_SGCom_UtteranceLatency, STATGROUP_SGCom);
+
+// Upper bounds of the histogram buckets (ms), the last one is unbounded
+static const double BucketBoundsMs[] = { 1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 500.0, 1000.0, 2000.0, 5000.0, 10000.0 };
+
+// Utterances kept in the breakdown of the report
+static const int32 MaxRecent = 50;
+
+// ========================================================
+// Add a latency to the histogram
+// ========================================================
+void FSGLatencyTracer::FHistogram::Add(double Ms)
+{
+    int32 Bucket = 0;
+    while (Bucket < NumBuckets - 1 && Ms > BucketBoundsMs[Bucket]) {
+        Bucket++;
+    }
+
+    Buckets[Bucket]++;
+    Count++;
+    TotalMs += Ms;
+    MaxMs = FMath::Max(MaxMs, Ms);
+}
+
+// ========================================================
+// Upper bound of the bucket holding a fraction of the
+// samples, the maximum for the unbounded bucket
+// ========================================================
+double FSGLatencyTracer::FHistogram::GetPercentileMs(double Fraction) const
+{
+    const int64 Target = FMath::Max<int64>(1, (int64)FMath::CeilToDouble(Count * Fraction));
+    int64 Cumulative = 0;
+    for (int32 i = 0; i < NumBuckets - 1; ++i) {
+        Cumulative += Buckets[i];
+        if (Cumulative >= Target) {
+            return FMath::Min(BucketBoundsMs[i], MaxMs);
+        }
+    }
+    return MaxMs;
+}
+
+// ========================================================
+// The tracer shared by the session
+// ========================================================
+FSGLatencyTracer& FSGLatencyTracer::Get()
+{
+    static FSGLatencyTracer Tracer;
+    return Tracer;
+}
+
+void FSGLatencyTracer::Configure(const FString& InReportPath)
+{
+    ReportPath = InReportPath;
+    if (!ReportPath.IsEmpty()) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Writing utterance latency report to %s"), *ReportPath);
+    }
+}
+
+// ========================================================
+// Start tracing an utterance
+// ========================================================
+uint32 FSGLatencyTracer::Begin(const FString& Name, double DiscoveredTime)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (bCurrent) {
+        Finished.Add(MoveTemp(Current));
+    }
+
+    Current = FTrace();
+    Current.Id = NextId++;
+    Current.Name = Name;
+    Current.Times[(int32)ESGLatencyStage::Discovered] = DiscoveredTime;
+    bCurrent = true;
+    AwaitedStages = GetAwaited(Current);
+    return Current.Id;
+}
+
+// ========================================================
+// Stamp a stage of the current utterance
+// ========================================================
+void FSGLatencyTracer::Mark(ESGLatencyStage Stage)
+{
+    // Called every frame by the avatars, most calls stop here
+    const uint32 Bit = 1u << (uint32)Stage;
+    if ((AwaitedStages.Load(EMemoryOrder::Relaxed) & Bit) == 0) {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    FScopeLock ScopeLock(&Lock);
+    if (!bCurrent || (GetAwaited(Current) & Bit) == 0) {
+        return;
+    }
+    Current.Times[(int32)Stage] = Now;
+    AwaitedStages = GetAwaited(Current);
+}
+
+// ========================================================
+// Aggregate the finished traces and rewrite the report
+// ========================================================
+void FSGLatencyTracer::Update()
+{
+    TArray<FTrace> Traces;
+    {
+        FScopeLock ScopeLock(&Lock);
+
+        // The current utterance is finished once every stage was stamped
+        if (bCurrent && GetAwaited(Current) == 0) {
+            Finished.Add(MoveTemp(Current));
+            Current = FTrace();
+            bCurrent = false;
+            AwaitedStages = 0;
+        }
+        Traces = MoveTemp(Finished);
+        Finished.Reset();
+    }
+
+    if (Traces.Num() == 0) {
+        return;
+    }
+
+    for (const FTrace& Trace : Traces) {
+        Record(Trace);
+    }
+
+    if (!ReportPath.IsEmpty()) {
+        Export(ReportPath);
+    }
+}
+
+// ========================================================
+// Add a finished trace to the histograms and log its
+// breakdown
+// ========================================================
+void FSGLatencyTracer::Record(const FTrace& Trace)
+{
+    FString Breakdown;
+    int32 SlowestStage = INDEX_NONE;
+    double SlowestMs = 0.0;
+    for (int32 i = 1; i < NumStages; ++i) {
+        const double Start = Trace.Times[(int32)GetPrevious((ESGLatencyStage)i)];
+        const double End = Trace.Times[i];
+        if (Start <= 0.0 || End <= 0.0) {
+            continue;
+        }
+
+        const double Ms = (End - Start) * 1000.0;
+        Stages[i].Add(Ms);
+        Breakdown += FString::Printf(TEXT(" %s %.1f"), GetStageName((ESGLatencyStage)i), Ms);
+        if (Ms > SlowestMs) {
+            SlowestMs = Ms;
+            SlowestStage = i;
+        }
+    }
+
+    const double Discovered = Trace.Times[(int32)ESGLatencyStage::Discovered];
+    const double FirstEvaluate = Trace.Times[(int32)ESGLatencyStage::FirstEvaluate];
+    if (Discovered > 0.0 && FirstEvaluate > 0.0) {
+        const double TotalMs = (FirstEvaluate - Discovered) * 1000.0;
+        Total.Add(TotalMs);
+        SET_FLOAT_STAT(STAT_SGCom_UtteranceLatency, TotalMs);
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Utterance %u latency %.1f ms, slowest %s (ms):%s"),
+               Trace.Id, TotalMs, SlowestStage != INDEX_NONE ? GetStageName((ESGLatencyStage)SlowestStage) : TEXT("none"), *Breakdown);
+    }
+    else {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Utterance %u was not animated (ms):%s"), Trace.Id, *Breakdown);
+    }
+
+    if (Recent.Num() >= MaxRecent) {
+        Recent.RemoveAt(0, 1, false);
+    }
+    Recent.Add(Trace);
+}
+
+// ========================================================
+// Write the histograms and the latest breakdowns as JSON
+// ========================================================
+void FSGLatencyTracer::Export(const FString& Path)
+{
+    auto HistogramObject = [](const FHistogram& Histogram) {
+        TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetNumberField(TEXT("count"), Histogram.Count);
+        Object->SetNumberField(TEXT("mean_ms"), Histogram.Count > 0 ? Histogram.TotalMs / Histogram.Count : 0.0);
+        Object->SetNumberField(TEXT("p50_ms"), Histogram.GetPercentileMs(0.5));
+        Object->SetNumberField(TEXT("p95_ms"), Histogram.GetPercentileMs(0.95));
+        Object->SetNumberField(TEXT("p99_ms"), Histogram.GetPercentileMs(0.99));
+        Object->SetNumberField(TEXT("max_ms"), Histogram.MaxMs);
+
+        TArray<TSharedPtr<FJsonValue>> Buckets;
+        for (int32 i = 0; i < NumBuckets; ++i) {
+            TSharedPtr<FJsonObject> Bucket = MakeShared<FJsonObject>();
+            if (i < NumBuckets - 1) {
+                Bucket->SetNumberField(TEXT("le_ms"), BucketBoundsMs[i]);
+            }
+            else {
+                Bucket->SetStringField(TEXT("le_ms"), TEXT("inf"));
+            }
+            Bucket->SetNumberField(TEXT("count"), Histogram.Buckets[i]);
+            Buckets.Add(MakeShared<FJsonValueObject>(Bucket));
+        }
+        Object->SetArrayField(TEXT("buckets"), Buckets);
+        return Object;
+    };
+
+    // The stage with the highest mean is where the time goes
+    TSharedPtr<FJsonObject> StageObjects = MakeShared<FJsonObject>();
+    int32 SlowestStage = INDEX_NONE;
+    double SlowestMeanMs = -1.0;
+    for (int32 i = 1; i < NumStages; ++i) {
+        StageObjects->SetObjectField(GetStageName((ESGLatencyStage)i), HistogramObject(Stages[i]));
+        const double MeanMs = Stages[i].Count > 0 ? Stages[i].TotalMs / Stages[i].Count : -1.0;
+        if (MeanMs > SlowestMeanMs) {
+            SlowestMeanMs = MeanMs;
+            SlowestStage = i;
+        }
+    }
+
+    TArray<TSharedPtr<FJsonValue>> RecentValues;
+    for (const FTrace& Trace : Recent) {
+        TSharedPtr<FJsonObject> TraceObject = MakeShared<FJsonObject>();
+        TraceObject->SetNumberField(TEXT("id"), Trace.Id);
+        TraceObject->SetStringField(TEXT("name"), Trace.Name);
+
+        // Time of each stage since discovery, stages that were not reached are left out
+        const double Discovered = Trace.Times[(int32)ESGLatencyStage::Discovered];
+        for (int32 i = 1; i < NumStages; ++i) {
+            if (Trace.Times[i] > 0.0) {
+                TraceObject->SetNumberField(FString(GetStageName((ESGLatencyStage)i)) + TEXT("_ms"), (Trace.Times[i] - Discovered) * 1000.0);
+            }
+        }
+        RecentValues.Add(MakeShared<FJsonValueObject>(TraceObject));
+    }
+
+    TSharedPtr<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetNumberField(TEXT("utterances"), Total.Count);
+    Report->SetObjectField(TEXT("total"), HistogramObject(Total));
+    Report->SetObjectField(TEXT("stages"), StageObjects);
+    Report->SetStringField(TEXT("slowest_stage"), SlowestMeanMs >= 0.0 ? GetStageName((ESGLatencyStage)SlowestStage) : TEXT(""));
+    Report->SetArrayField(TEXT("recent"), RecentValues);
+
+    FString Json;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+    FJsonSerializer::Serialize(Report.ToSharedRef(), Writer);
+    if (!FFileHelper::SaveStringToFile(Json, *Path)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to write latency report to %s"), *Path);
+    }
+}
+
+const TCHAR* FSGLatencyTracer::GetStageName(ESGLatencyStage Stage)
+{
+    switch (Stage) {
+        case ESGLatencyStage::Discovered: return TEXT("discovered");
+        case ESGLatencyStage::Loaded: return TEXT("loaded");
+        case ESGLatencyStage::Input: return TEXT("input");
+        case ESGLatencyStage::FirstProcessed: return TEXT("first_processed");
+        case ESGLatencyStage::StartThreshold: return TEXT("start_threshold");
+        case ESGLatencyStage::FirstEvaluate: return TEXT("first_evaluate");
+        case ESGLatencyStage::AudioStart: return TEXT("audio_start");
+        default: return TEXT("unknown");
+    }
+}
+
+// ========================================================
+// Stage that must be stamped before a stage can be. Audio
+// starts playing independently of the analysis.
+// ========================================================
+ESGLatencyStage FSGLatencyTracer::GetPrevious(ESGLatencyStage Stage)
+{
+    switch (Stage) {
+        case ESGLatencyStage::AudioStart: return ESGLatencyStage::Input;
+        case ESGLatencyStage::Discovered: return ESGLatencyStage::Discovered;
+        default: return (ESGLatencyStage)((uint8)Stage - 1);
+    }
+}
+
+uint32 FSGLatencyTracer::GetAwaited(const FTrace& Trace)
+{
+    uint32 Awaited = 0;
+    for (int32 i = 1; i < NumStages; ++i) {
+        if (Trace.Times[i] <= 0.0 && Trace.Times[(int32)GetPrevious((ESGLatencyStage)i)] > 0.0) {
+            Awaited |= 1u << i;
+        }
+    }
+    return Awaited;
+}
@@ -0,0 +1,98 @@
+// Traces each utterance from its discovery in the watched folder to its first
+// animated frame, aggregating the latency of every stage into histograms
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// Stages of an utterance, in the order they are reached
+enum class ESGLatencyStage : uint8
+{
+    Discovered,
+    Loaded,
+    Input,
+    FirstProcessed,
+    StartThreshold,
+    FirstEvaluate,
+    AudioStart,
+    Num
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGLatencyTracer
+{
+public:
+    // The tracer shared by the session
+    static FSGLatencyTracer& Get();
+
+    // Write the report to ReportPath whenever an utterance is traced, disabled when empty
+    void Configure(const FString& InReportPath);
+
+    // Start tracing an utterance discovered at DiscoveredTime, ending the
+    // trace of the previous one. Returns the ID of the utterance.
+    uint32 Begin(const FString& Name, double DiscoveredTime);
+
+    // Stamp a stage of the current utterance, once the stage it follows was
+    // stamped. Cheap when the stage is not awaited, safe on any thread.
+    void Mark(ESGLatencyStage Stage);
+
+    // Aggregate the finished traces and rewrite the report, called on the game thread
+    void Update();
+
+    // Write the report now
+    void Export(const FString& Path);
+
+    static const TCHAR* GetStageName(ESGLatencyStage Stage);
+
+private:
+    static constexpr int32 NumStages = (int32)ESGLatencyStage::Num;
+    static constexpr int32 NumBuckets = 14;
+
+    // Latency of one stage over all traced utterances
+    struct FHistogram
+    {
+        int64 Count = 0;
+        double TotalMs = 0.0;
+        double MaxMs = 0.0;
+        int64 Buckets[NumBuckets] = {};
+
+        void Add(double Ms);
+
+        // Upper bound of the bucket holding the given fraction of the samples
+        double GetPercentileMs(double Fraction) const;
+    };
+
+    // Timestamps of one utterance, 0 when a stage was not reached
+    struct FTrace
+    {
+        uint32 Id = 0;
+        FString Name;
+        double Times[NumStages] = {};
+    };
+
+    // Stage that must be stamped before a stage can be
+    static ESGLatencyStage GetPrevious(ESGLatencyStage Stage);
+
+    // Stages whose previous stage is stamped and that are not stamped yet
+    static uint32 GetAwaited(const FTrace& Trace);
+
+    // Add a finished trace to the histograms and log its breakdown
+    void Record(const FTrace& Trace);
+
+    FString ReportPath;
+
+    FCriticalSection Lock;
+    FTrace Current;
+    bool bCurrent = false;
+    TArray<FTrace> Finished;
+    TAtomic<uint32> AwaitedStages{ 0 };
+    uint32 NextId = 1;
+
+    // Latency of each stage from the stage before it, and from discovery
+    // to the first animated frame
+    FHistogram Stages[NumStages];
+    FHistogram Total;
+
+    // Breakdown of the latest utterances, for the report
+    TArray<FTrace> Recent;
+};
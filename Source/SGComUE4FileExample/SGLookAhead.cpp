@@ -0,0 +1,367 @@
+#include "SGLookAhead.h"
+
+#include "SGBufferController.h"
+#include "SGComManager.h"
+#include "SGComSettings.h"
+
+#include "Async/Async.h"
+#include "Audio.h"
+#include "Misc/FileHelper.h"
+
+// ========================================================
+// Constructor
+// ========================================================
+FSGLookAhead::FSGLookAhead()
+{
+}
+
+// ========================================================
+// Destructor
+// ========================================================
+FSGLookAhead::~FSGLookAhead()
+{
+    Shutdown();
+}
+
+// ========================================================
+// Create the spare engines
+// ========================================================
+bool FSGLookAhead::Start(const SG_COM_EngineConfig& EngineConfig, int32 NumEngines, double InMaxClipSec, double MemoryBudgetMB, double CpuBudget)
+{
+    SampleType = EngineConfig.audio_sample_type;
+    SampleRate = (int32)get_audio_sample_rate(EngineConfig.audio_sample_rate);
+    MaxClipSec = InMaxClipSec;
+
+    const double BytesPerSample = SampleType == SG_AUDIO_INT_16 ? 2.0 : 4.0;
+    const int64 BudgetBytes = (int64)(MemoryBudgetMB * 1024.0 * 1024.0);
+    int64 NumChannels = 0;
+
+    for (int32 i = 0; i < NumEngines; ++i) {
+        TUniquePtr<FSlot> Slot = MakeUnique<FSlot>();
+
+        SG_COM_PlayerConfig PlayerConfig;
+        PlayerConfig.character_file_in_memory = EngineConfig.character_file_in_memory;
+        PlayerConfig.character_file_bytes = EngineConfig.character_file_bytes;
+        PlayerConfig.animation_type = FSGComSettings::Get().AnimationType;
+        PlayerConfig.buffer_sec = (float)(MaxClipSec + FlushSec);
+
+        SG_COM_Error err = SG_COM_CreatePlayer(&PlayerConfig, &Slot->Player);
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create look-ahead player: %d"), err);
+            LogException(err);
+            break;
+        }
+
+        // The first player tells how much one slot holds
+        if (i == 0) {
+            SG_AnimationNode* Nodes = nullptr;
+            sg_size NumNodes = 0;
+            if (SG_COM_GetAnimationNodes(Slot->Player, &Nodes, &NumNodes) == SG_COM_Error::SG_COM_ERROR_OK) {
+                for (sg_size j = 0; j < NumNodes; ++j) {
+                    NumChannels += Nodes[j].num_channels;
+                }
+            }
+
+            const double FramesPerSecond = 1000.0 / FSGBufferController::FrameMs;
+            SlotBytes = (int64)(MaxClipSec * BytesPerSample * SampleRate + (MaxClipSec + FlushSec) * FramesPerSecond * NumChannels * sizeof(float))
+                + (int64)EngineConfig.character_file_bytes;
+        }
+
+        if ((i + 1) * SlotBytes > BudgetBytes) {
+            SG_COM_DestroyPlayer(Slot->Player);
+            break;
+        }
+
+        SG_COM_EngineConfig SpareConfig = EngineConfig;
+        SpareConfig.local_player = Slot->Player;
+        SpareConfig.engine_broadcast_callback = nullptr;
+        SpareConfig.engine_status_callback = &FSGLookAhead::EngineStatusCallback;
+        SpareConfig.buffer_sec = (float)MaxClipSec;
+        SpareConfig.custom_engine_data = nullptr;
+
+        err = SG_COM_CreateEngine(&SpareConfig, &Slot->Engine);
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to create look-ahead engine: %d"), err);
+            LogException(err);
+            SG_COM_DestroyPlayer(Slot->Player);
+            break;
+        }
+
+        Slots.Add(MoveTemp(Slot));
+    }
+
+    if (Slots.Num() == 0) {
+        return false;
+    }
+
+    CpuShare = FMath::Max(0.01, CpuBudget / Slots.Num());
+    bRunning = true;
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Analysing up to %d clips ahead (%.2f MB, %.2f cores)"),
+           Slots.Num(), GetMemoryBytes() / (1024.0 * 1024.0), CpuBudget);
+    return true;
+}
+
+// ========================================================
+// Stop the analysis and destroy the spare engines
+// ========================================================
+void FSGLookAhead::Shutdown()
+{
+    bRunning = false;
+
+    for (TUniquePtr<FSlot>& Slot : Slots) {
+        if (Slot->Future.IsValid()) {
+            Slot->Future.Wait();
+        }
+        SG_COM_DestroyEngine(Slot->Engine);
+        SG_COM_DestroyPlayer(Slot->Player);
+    }
+    Slots.Empty();
+    Rejected.Empty();
+    RejectedQueue.Empty();
+}
+
+bool FSGLookAhead::IsRunning() const
+{
+    return bRunning;
+}
+
+int32 FSGLookAhead::GetNumSlots() const
+{
+    return Slots.Num();
+}
+
+// ========================================================
+// Analyse the given files, the next to play first
+// ========================================================
+void FSGLookAhead::Schedule(const TArray<FString>& Paths)
+{
+    if (!bRunning) {
+        return;
+    }
+
+    FString RejectedPath;
+    while (RejectedQueue.Dequeue(RejectedPath)) {
+        Rejected.Add(RejectedPath);
+    }
+    for (auto It = Rejected.CreateIterator(); It; ++It) {
+        if (!Paths.Contains(*It)) {
+            It.RemoveCurrent();
+        }
+    }
+
+    // Drop the analyses that are not needed any more
+    for (TUniquePtr<FSlot>& Slot : Slots) {
+        if (Paths.Contains(Slot->Path)) {
+            continue;
+        }
+        if (Slot->State == ESlotState::Ready) {
+            Slot->State = ESlotState::Free;
+        }
+        else if (Slot->State == ESlotState::Analysing) {
+            Slot->bCancel = true;
+        }
+    }
+
+    for (const FString& Path : Paths) {
+        if (Rejected.Contains(Path)) {
+            continue;
+        }
+
+        const bool bAssigned = Slots.ContainsByPredicate([&Path](const TUniquePtr<FSlot>& Slot) {
+            return Slot->State != ESlotState::Free && Slot->Path == Path;
+        });
+        if (bAssigned) {
+            continue;
+        }
+
+        TUniquePtr<FSlot>* FreeSlot = Slots.FindByPredicate([](const TUniquePtr<FSlot>& Slot) {
+            return IsSlotFree(*Slot);
+        });
+        if (!FreeSlot) {
+            break;
+        }
+
+        FSlot* Slot = FreeSlot->Get();
+        Slot->Path = Path;
+        Slot->bCancel = false;
+        Slot->State = ESlotState::Analysing;
+        Slot->Future = Async(EAsyncExecution::Thread, [this, Slot]() { Analyse(*Slot); });
+    }
+}
+
+// ========================================================
+// Check if a slot can be given a new clip. An analysis
+// marks its slot free just before its thread ends.
+// ========================================================
+bool FSGLookAhead::IsSlotFree(const FSlot& Slot)
+{
+    return Slot.State == ESlotState::Free && (!Slot.Future.IsValid() || Slot.Future.IsReady());
+}
+
+// ========================================================
+// Take the player holding the analysed animation of Path
+// ========================================================
+SG_COM_PlayerHandle FSGLookAhead::Acquire(const FString& Path, double& OutStartTimeMs)
+{
+    for (TUniquePtr<FSlot>& Slot : Slots) {
+        if (Slot->Path != Path) {
+            continue;
+        }
+
+        if (Slot->State == ESlotState::Ready) {
+            Slot->State = ESlotState::Playing;
+            OutStartTimeMs = Slot->StartTimeMs;
+            return Slot->Player;
+        }
+        if (Slot->State == ESlotState::Analysing) {
+            Slot->bCancel = true;
+        }
+    }
+
+    return nullptr;
+}
+
+// ========================================================
+// Return a player once its animation played
+// ========================================================
+void FSGLookAhead::Release(SG_COM_PlayerHandle Player)
+{
+    for (TUniquePtr<FSlot>& Slot : Slots) {
+        if (Slot->Player == Player && Slot->State == ESlotState::Playing) {
+            Slot->Path.Reset();
+            Slot->State = ESlotState::Free;
+        }
+    }
+}
+
+// ========================================================
+// Memory budgeted for the spare engines and their players
+// ========================================================
+int64 FSGLookAhead::GetMemoryBytes() const
+{
+    return Slots.Num() * SlotBytes;
+}
+
+// ========================================================
+// Analyse the clip assigned to a slot
+// ========================================================
+void FSGLookAhead::Analyse(FSlot& Slot)
+{
+    const uint8* Audio = nullptr;
+    int32 NumBytes = 0;
+    if (!LoadClip(Slot, Audio, NumBytes)) {
+        RejectedQueue.Enqueue(Slot.Path);
+        Slot.State = ESlotState::Free;
+        return;
+    }
+
+    const int32 BytesPerSample = SampleType == SG_AUDIO_INT_16 ? 2 : 4;
+    const double ClipMs = NumBytes * 1000.0 / (SampleRate * BytesPerSample);
+
+    bool bReady = false;
+    SG_COM_Error err = SG_COM_Reset(Slot.Engine);
+
+    // The animation of the clip starts after what the player already holds
+    double MinTimeMs = 0.0;
+    double MaxTimeMs = 0.0;
+    if (err == SG_COM_Error::SG_COM_ERROR_OK) {
+        err = SG_COM_GetPlayableRange(Slot.Player, &MinTimeMs, &MaxTimeMs);
+        Slot.StartTimeMs = MaxTimeMs;
+    }
+    if (err == SG_COM_Error::SG_COM_ERROR_OK) {
+        err = SG_COM_InputAudio(Slot.Engine, Audio, NumBytes);
+    }
+
+    // Silence pushing the last frames of the clip through the pipeline
+    TArray<uint8> FlushFrame;
+    FlushFrame.SetNumZeroed(SampleRate / 100 * BytesPerSample);
+    const double EndTimeMs = Slot.StartTimeMs + ClipMs;
+    const int32 MaxFlushFrames = (int32)(FlushSec * 1000.0 / FSGBufferController::FrameMs);
+    int32 FlushFrames = 0;
+
+    // Analyse as fast as the CPU budget allows, until the player holds the
+    // animation of the whole clip
+    while (err == SG_COM_Error::SG_COM_ERROR_OK && bRunning && !Slot.bCancel) {
+        const double StartTime = FPlatformTime::Seconds();
+        int ProcessedFrames = 0;
+        int RemainingFrames = 0;
+        err = SG_COM_ProcessTick(Slot.Engine, &ProcessedFrames, &RemainingFrames);
+        if (err == SG_COM_Error::SG_COM_ERROR_INPUT_UNDERRUN) {
+            err = SG_COM_InputAudio(Slot.Engine, FlushFrame.GetData(), FlushFrame.Num());
+        }
+        if (err == SG_COM_Error::SG_COM_ERROR_OK) {
+            err = SG_COM_GetPlayableRange(Slot.Player, &MinTimeMs, &MaxTimeMs);
+        }
+        if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+            break;
+        }
+
+        if (MaxTimeMs >= EndTimeMs) {
+            bReady = true;
+            break;
+        }
+
+        // The engine never caught up with the end of the clip
+        if (RemainingFrames == 0 && ++FlushFrames > MaxFlushFrames) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : %s analysed ahead up to %.0f of %.0f ms"), *Slot.Path, MaxTimeMs - Slot.StartTimeMs, ClipMs);
+            RejectedQueue.Enqueue(Slot.Path);
+            break;
+        }
+
+        if (CpuShare < 1.0) {
+            const double BusySeconds = FPlatformTime::Seconds() - StartTime;
+            FPlatformProcess::Sleep((float)(BusySeconds * (1.0 / CpuShare - 1.0)));
+        }
+    }
+
+    if (err != SG_COM_Error::SG_COM_ERROR_OK) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to analyse %s ahead: %d"), *Slot.Path, err);
+        LogException(err);
+        RejectedQueue.Enqueue(Slot.Path);
+    }
+
+    Slot.State = bReady && !Slot.bCancel ? ESlotState::Ready : ESlotState::Free;
+}
+
+// ========================================================
+// Load the clip of a slot
+// ========================================================
+bool FSGLookAhead::LoadClip(FSlot& Slot, const uint8*& OutAudio, int32& OutBytes) const
+{
+    if (!FFileHelper::LoadFileToArray(Slot.FileData, *Slot.Path)) {
+        return false;
+    }
+
+    FWaveModInfo WaveInfo;
+    if (!WaveInfo.ReadWaveInfo(Slot.FileData.GetData(), Slot.FileData.Num())) {
+        return false;
+    }
+
+    // Spare engines take the same format as the main engine
+    const uint16 BitsPerSample = *WaveInfo.pBitsPerSample;
+    const bool bSampleTypeMatches =
+        (SampleType == SG_AUDIO_INT_16 && *WaveInfo.pFormatTag == 0x0001 && BitsPerSample == 16) ||
+        (SampleType == SG_AUDIO_INT_32 && *WaveInfo.pFormatTag == 0x0001 && BitsPerSample == 32) ||
+        (SampleType == SG_AUDIO_FLOAT_32 && *WaveInfo.pFormatTag == 0x0003 && BitsPerSample == 32);
+    if (!bSampleTypeMatches || *WaveInfo.pChannels != 1 || (int32)*WaveInfo.pSamplesPerSec != SampleRate) {
+        return false;
+    }
+
+    // The player holds at most MaxClipSec of animation
+    const double DurationSec = (double)WaveInfo.SampleDataSize / (SampleRate * (BitsPerSample / 8));
+    if (DurationSec > MaxClipSec) {
+        return false;
+    }
+
+    OutAudio = WaveInfo.SampleDataStart;
+    OutBytes = (int32)WaveInfo.SampleDataSize;
+    return true;
+}
+
+// ========================================================
+// Spare engines do not report their status
+// ========================================================
+void FSGLookAhead::EngineStatusCallback(SG_COM_EngineHandle Handle, SG_COM_Status Status, const char* Message, void* CustomEngineData)
+{
+}
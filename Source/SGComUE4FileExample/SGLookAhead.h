@@ -0,0 +1,101 @@
+// Analyses upcoming queued clips on spare engines so they play without processing delay
+
+#pragma once
+
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Templates/UniquePtr.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGLookAhead
+{
+public:
+    FSGLookAhead();
+    ~FSGLookAhead();
+
+    // Create up to NumEngines spare engines from EngineConfig, each with a
+    // player holding MaxClipSec of animation. Engines are only created while
+    // they fit in MemoryBudgetMB, and analysis is paced to use at most
+    // CpuBudget cores in total.
+    bool Start(const SG_COM_EngineConfig& EngineConfig, int32 NumEngines, double MaxClipSec, double MemoryBudgetMB, double CpuBudget);
+
+    // Stop the analysis and destroy the spare engines
+    void Shutdown();
+
+    bool IsRunning() const;
+
+    // Number of clips that can be analysed ahead
+    int32 GetNumSlots() const;
+
+    // Analyse the given files, the next to play first. Analyses of files that
+    // are not listed any more are dropped. Called on the game thread.
+    void Schedule(const TArray<FString>& Paths);
+
+    // Take the player holding the analysed animation of Path, or nullptr if
+    // it is not ready. The animation starts at OutStartTimeMs. An analysis of
+    // Path still in progress is dropped.
+    SG_COM_PlayerHandle Acquire(const FString& Path, double& OutStartTimeMs);
+
+    // Return a player taken with Acquire once its animation played and no
+    // avatar reads its animation nodes any more
+    void Release(SG_COM_PlayerHandle Player);
+
+    // Memory budgeted for the spare engines and their players
+    int64 GetMemoryBytes() const;
+
+private:
+    enum class ESlotState : uint8
+    {
+        Free,
+        Analysing,
+        Ready,
+        Playing
+    };
+
+    // A spare engine and the player buffering its animation
+    struct FSlot
+    {
+        SG_COM_EngineHandle Engine = nullptr;
+        SG_COM_PlayerHandle Player = nullptr;
+        FString Path;
+        TAtomic<ESlotState> State{ ESlotState::Free };
+        FThreadSafeBool bCancel;
+        double StartTimeMs = 0.0;
+        TArray<uint8> FileData;
+        TFuture<void> Future;
+    };
+
+    // Analyse the clip assigned to a slot, on its own thread
+    void Analyse(FSlot& Slot);
+
+    // Load the clip of a slot, false if it cannot be analysed ahead
+    bool LoadClip(FSlot& Slot, const uint8*& OutAudio, int32& OutBytes) const;
+
+    // Check if a slot can be given a new clip, its last analysis finished
+    static bool IsSlotFree(const FSlot& Slot);
+
+    // Animation the players hold on top of the clip, for the latency of the
+    // engine pipeline flushed at the end of the clip
+    static constexpr double FlushSec = 1.0;
+
+    // Spare engines do not report their status
+    static void EngineStatusCallback(SG_COM_EngineHandle Handle, SG_COM_Status Status, const char* Message, void* CustomEngineData);
+
+    TArray<TUniquePtr<FSlot>> Slots;
+    FThreadSafeBool bRunning;
+
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 SampleRate = 16000;
+    double MaxClipSec = 0.0;
+
+    // Share of a core each slot may use while analysing
+    double CpuShare = 1.0;
+    int64 SlotBytes = 0;
+
+    // Files that cannot be analysed ahead, reported by the analysis threads
+    TQueue<FString, EQueueMode::Mpsc> RejectedQueue;
+    TSet<FString> Rejected;
+};
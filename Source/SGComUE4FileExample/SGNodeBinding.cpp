@@ -0,0 +1,501 @@
+#include "SGNodeBinding.h"
+
+#include "Animation/Skeleton.h"
+#include "Animation/MorphTarget.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+
+// Bumped whenever the cache file layout changes
+static const int32 BindingCacheVersion = 4;
+
+// ========================================================
+// Get the cache shared by all avatars
+// ========================================================
+FSGNodeBindingCache& FSGNodeBindingCache::Get()
+{
+    static FSGNodeBindingCache Cache;
+    return Cache;
+}
+
+FString FSGNodeBindingCache::GetDirectory()
+{
+    return FPaths::ProjectSavedDir() / TEXT("SGBindings");
+}
+
+// ========================================================
+// Read the cached bindings of a character from disk
+// ========================================================
+void FSGNodeBindingCache::Load(const FString& CharacterHash)
+{
+    if (CharacterHash.IsEmpty() || IsLoaded(CharacterHash)) {
+        return;
+    }
+    Flush();
+
+    // One file per skeleton and animation type, named after the character first
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *(GetDirectory() / CharacterHash + TEXT("_*.bin")), true, false);
+
+    TMap<FString, TArray<uint8>> Loaded;
+    for (const FString& File : Files) {
+        TArray<uint8> Data;
+        if (FFileHelper::LoadFileToArray(Data, *(GetDirectory() / File), FILEREAD_Silent)) {
+            Loaded.Add(FPaths::GetBaseFilename(File), MoveTemp(Data));
+        }
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    Entries = MoveTemp(Loaded);
+    Unsaved.Reset();
+    LoadedHash = CharacterHash;
+    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Loaded %d cached node bindings"), Entries.Num());
+}
+
+bool FSGNodeBindingCache::IsLoaded(const FString& CharacterHash) const
+{
+    FScopeLock ScopeLock(&Lock);
+    return LoadedHash == CharacterHash;
+}
+
+// ========================================================
+// Find a cached binding by name
+// ========================================================
+bool FSGNodeBindingCache::Find(const FString& Name, TArray<uint8>& OutData) const
+{
+    FScopeLock ScopeLock(&Lock);
+    const TArray<uint8>* Data = Entries.Find(Name);
+    if (!Data) {
+        return false;
+    }
+
+    OutData = *Data;
+    return true;
+}
+
+// ========================================================
+// Add a binding, written to disk by the next Flush
+// ========================================================
+void FSGNodeBindingCache::Add(const FString& Name, TArray<uint8>&& Data)
+{
+    FScopeLock ScopeLock(&Lock);
+    Entries.Add(Name, MoveTemp(Data));
+    Unsaved.AddUnique(Name);
+}
+
+// ========================================================
+// Write the bindings added since the last call
+// ========================================================
+void FSGNodeBindingCache::Flush()
+{
+    TArray<TPair<FString, TArray<uint8>>> Pending;
+    {
+        FScopeLock ScopeLock(&Lock);
+        for (const FString& Name : Unsaved) {
+            Pending.Emplace(Name, Entries.FindChecked(Name));
+        }
+        Unsaved.Reset();
+    }
+
+    for (const TPair<FString, TArray<uint8>>& Entry : Pending) {
+        const FString Path = GetDirectory() / Entry.Key + TEXT(".bin");
+        if (!FFileHelper::SaveArrayToFile(Entry.Value, *Path)) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Failed to save node binding to %s"), *Path);
+        }
+    }
+}
+
+// ========================================================
+// Bind the animation nodes to a skeleton and mesh
+// ========================================================
+bool FSGNodeBinding::Bind(const SG_AnimationNode* InNodes, sg_size NumNodes, SG_AnimationType InAnimationType, const FString& CharacterHash, const USkeleton* Skeleton, const USkeletalMesh* Mesh)
+{
+    Reset();
+    if (!InNodes || NumNodes == 0 || !Skeleton) {
+        return false;
+    }
+
+    // Bound once the game thread read the cache of the character
+    FSGNodeBindingCache& Cache = FSGNodeBindingCache::Get();
+    if (!CharacterHash.IsEmpty() && !Cache.IsLoaded(CharacterHash)) {
+        return false;
+    }
+
+    // The cache is invalidated by a change to either input through its name
+    const TCHAR* TypeSuffix = InAnimationType == SG_BAKED_ANIMATION ? TEXT("_baked") : TEXT("");
+    const FString CacheName = CharacterHash + TEXT("_") + HashSkeleton(Skeleton, Mesh) + TypeSuffix;
+    if (!CharacterHash.IsEmpty() && Load(CacheName, InNodes, NumNodes, InAnimationType, Skeleton)) {
+        BuildBatches();
+        return true;
+    }
+
+    AnimationType = (uint8)InAnimationType;
+    if (InAnimationType == SG_BAKED_ANIMATION) {
+        ResolveBaked(InNodes, NumNodes, Skeleton, Mesh);
+    }
+    else {
+        Resolve(InNodes, NumNodes, Skeleton, Mesh);
+    }
+    BuildBatches();
+    if (!CharacterHash.IsEmpty()) {
+        Save(CacheName);
+    }
+    return true;
+}
+
+// ========================================================
+// Check if the binding was made for the given nodes
+// ========================================================
+bool FSGNodeBinding::IsBoundTo(const SG_AnimationNode* InNodes, sg_size NumNodes, SG_AnimationType InAnimationType) const
+{
+    if (!InNodes || Nodes.Num() != (int32)NumNodes || AnimationType != (uint8)InAnimationType) {
+        return false;
+    }
+
+    for (sg_size i = 0; i < NumNodes; ++i) {
+        if (Nodes[i].Type != (uint8)InNodes[i].type || Nodes[i].NumChannels != (int32)InNodes[i].num_channels) {
+            return false;
+        }
+        if (Nodes[i].Name != FName(InNodes[i].name)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FSGNodeBinding::Reset()
+{
+    AnimationType = SG_NORMAL_ANIMATION;
+    Nodes.Reset();
+    MorphNames.Reset();
+    MorphUIDs.Reset();
+    CurveUIDs.Reset();
+    JointBatch.Reset();
+    MorphCurveBatch.Reset();
+    MorphBatch.Reset();
+    CurveBatch.Reset();
+    NumChannels = 0;
+}
+
+// ========================================================
+// Resolve the node names of normal animation
+// ========================================================
+void FSGNodeBinding::Resolve(const SG_AnimationNode* InNodes, sg_size NumNodes, const USkeleton* Skeleton, const USkeletalMesh* Mesh)
+{
+    const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+
+    Nodes.SetNum(NumNodes);
+    for (sg_size i = 0; i < NumNodes; ++i) {
+        const SG_AnimationNode& AnimationNode = InNodes[i];
+        FSGBoundNode& Node = Nodes[i];
+        Node.Name = AnimationNode.name;
+        Node.Type = (uint8)AnimationNode.type;
+        Node.NumChannels = (int32)AnimationNode.num_channels;
+
+        if (AnimationNode.type == SG_JOINT) {
+            Node.SkeletonBoneIndex = RefSkeleton.FindBoneIndex(AnimationNode.name);
+            if (Node.SkeletonBoneIndex == INDEX_NONE) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Node name %s was not found."), *FString(AnimationNode.name));
+            }
+        }
+        else if (AnimationNode.type == SG_BLENDSHAPE) {
+            Node.FirstTarget = MorphNames.Num();
+            for (uint32_t j = 0; j < AnimationNode.num_channels; ++j) {
+                FName Name = AnimationNode.channel_names[j];
+                if (Mesh && !Mesh->FindMorphTarget(Name)) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Morph target name %s was not found."), *Name.ToString());
+                    Name = NAME_None;
+                }
+                MorphNames.Add(Name);
+                MorphUIDs.Add(FindMorphCurve(Skeleton, Name));
+            }
+        }
+        else if (AnimationNode.type == SG_OTHER_ANIMATION_NODE) {
+            // Specific to Metahumans
+            Node.FirstTarget = CurveUIDs.Num();
+            for (uint32_t j = 0; j < AnimationNode.num_channels; ++j) {
+                const FName CurveName = FName(FString(AnimationNode.name) + FString("_") + FString(AnimationNode.channel_names[j]));
+                const SmartName::UID_Type NameUID = Skeleton->GetUIDByName(USkeleton::AnimCurveMappingName, CurveName);
+                if (NameUID == SmartName::MaxUID) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Animation curve %s was not found."), *CurveName.ToString());
+                }
+                CurveUIDs.Add(NameUID);
+            }
+        }
+    }
+}
+
+// ========================================================
+// Resolve the node names of baked animation
+// ========================================================
+void FSGNodeBinding::ResolveBaked(const SG_AnimationNode* InNodes, sg_size NumNodes, const USkeleton* Skeleton, const USkeletalMesh* Mesh)
+{
+    const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+
+    Nodes.SetNum(NumNodes);
+    for (sg_size i = 0; i < NumNodes; ++i) {
+        const SG_AnimationNode& AnimationNode = InNodes[i];
+        FSGBoundNode& Node = Nodes[i];
+        Node.Name = AnimationNode.name;
+        Node.Type = (uint8)AnimationNode.type;
+        Node.NumChannels = (int32)AnimationNode.num_channels;
+
+        if (AnimationNode.type == SG_JOINT) {
+            Node.SkeletonBoneIndex = RefSkeleton.FindBoneIndex(AnimationNode.name);
+            if (Node.SkeletonBoneIndex == INDEX_NONE) {
+                UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Baked joint %s was not found."), *FString(AnimationNode.name));
+            }
+        }
+        else if (AnimationNode.type == SG_BLENDSHAPE) {
+            // Morph targets of a baked rig are named per mesh, e.g. head_lod0_mesh__eye_blink_L
+            Node.FirstTarget = MorphNames.Num();
+            for (uint32_t j = 0; j < AnimationNode.num_channels; ++j) {
+                FName Name = AnimationNode.channel_names[j];
+                if (Mesh && !Mesh->FindMorphTarget(Name)) {
+                    const FName MeshName = FName(FString(AnimationNode.name) + FString("__") + FString(AnimationNode.channel_names[j]));
+                    Name = Mesh->FindMorphTarget(MeshName) ? MeshName : NAME_None;
+                }
+                if (Name == NAME_None) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Baked blendshape %s was not found."), *FString(AnimationNode.channel_names[j]));
+                }
+                MorphNames.Add(Name);
+                MorphUIDs.Add(FindMorphCurve(Skeleton, Name));
+            }
+        }
+        else if (AnimationNode.type == SG_OTHER_ANIMATION_NODE) {
+            // Anything else a baked rig outputs drives curves of the same name
+            Node.FirstTarget = CurveUIDs.Num();
+            for (uint32_t j = 0; j < AnimationNode.num_channels; ++j) {
+                const FName CurveName = AnimationNode.channel_names[j];
+                const SmartName::UID_Type NameUID = Skeleton->GetUIDByName(USkeleton::AnimCurveMappingName, CurveName);
+                if (NameUID == SmartName::MaxUID) {
+                    UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Animation curve %s was not found."), *CurveName.ToString());
+                }
+                CurveUIDs.Add(NameUID);
+            }
+        }
+    }
+}
+
+// ========================================================
+// Load a cached binding
+// ========================================================
+bool FSGNodeBinding::Load(const FString& Name, const SG_AnimationNode* InNodes, sg_size NumNodes, SG_AnimationType InAnimationType, const USkeleton* Skeleton)
+{
+    TArray<uint8> Data;
+    if (!FSGNodeBindingCache::Get().Find(Name, Data)) {
+        return false;
+    }
+
+    // A damaged file is resolved again and overwritten
+    FMemoryReader Reader(Data);
+    if (!Serialize(Reader) || Reader.IsError() || !IsWithinBounds(Skeleton->GetReferenceSkeleton().GetNum())) {
+        UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Cached node binding %s is invalid and is rebuilt"), *Name);
+        Reset();
+        return false;
+    }
+    if (!IsBoundTo(InNodes, NumNodes, InAnimationType)) {
+        Reset();
+        return false;
+    }
+
+    return true;
+}
+
+// ========================================================
+// Add the binding to the cache
+// ========================================================
+void FSGNodeBinding::Save(const FString& Name)
+{
+    FBufferArchive Writer;
+    Serialize(Writer);
+    FSGNodeBindingCache::Get().Add(Name, MoveTemp(Writer));
+}
+
+// ========================================================
+// Read or write the binding in the cache file layout
+// ========================================================
+bool FSGNodeBinding::Serialize(FArchive& Ar)
+{
+    int32 Version = BindingCacheVersion;
+    int32 NumBoundNodes = Nodes.Num();
+    Ar << Version;
+    Ar << AnimationType;
+    Ar << NumBoundNodes;
+    if (Version != BindingCacheVersion || NumBoundNodes < 0) {
+        return false;
+    }
+
+    if (Ar.IsLoading()) {
+        Nodes.SetNum(NumBoundNodes);
+    }
+    for (FSGBoundNode& Node : Nodes) {
+        Ar << Node.Name;
+        Ar << Node.Type;
+        Ar << Node.NumChannels;
+        Ar << Node.SkeletonBoneIndex;
+        Ar << Node.FirstTarget;
+    }
+    Ar << MorphNames;
+    Ar << MorphUIDs;
+    Ar << CurveUIDs;
+    if (MorphUIDs.Num() != MorphNames.Num()) {
+        return false;
+    }
+
+    return true;
+}
+
+// ========================================================
+// Check that the nodes stay within the targets and bones
+// ========================================================
+bool FSGNodeBinding::IsWithinBounds(int32 NumBones) const
+{
+    for (const FSGBoundNode& Node : Nodes) {
+        if (Node.NumChannels < 0 || Node.FirstTarget < 0) {
+            return false;
+        }
+
+        if (Node.Type == SG_JOINT) {
+            if (Node.SkeletonBoneIndex != INDEX_NONE && (Node.SkeletonBoneIndex < 0 || Node.SkeletonBoneIndex >= NumBones)) {
+                return false;
+            }
+        }
+        else if (Node.Type == SG_BLENDSHAPE) {
+            if ((int64)Node.FirstTarget + Node.NumChannels > MorphNames.Num()) {
+                return false;
+            }
+        }
+        else if (Node.Type == SG_OTHER_ANIMATION_NODE) {
+            if ((int64)Node.FirstTarget + Node.NumChannels > CurveUIDs.Num()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// ========================================================
+// Group the resolved nodes into batches by type
+// ========================================================
+void FSGNodeBinding::BuildBatches()
+{
+    JointBatch.Reset();
+    MorphCurveBatch.Reset();
+    MorphBatch.Reset();
+    CurveBatch.Reset();
+    NumChannels = 0;
+
+    for (int32 i = 0; i < Nodes.Num(); ++i) {
+        FSGBoundNode& Node = Nodes[i];
+        Node.ChannelOffset = NumChannels;
+        NumChannels += Node.NumChannels;
+
+        if (Node.Type == SG_JOINT) {
+            if (Node.SkeletonBoneIndex != INDEX_NONE) {
+                JointBatch.Add({ i, Node.SkeletonBoneIndex });
+            }
+        }
+        else if (Node.Type == SG_BLENDSHAPE) {
+            // Morph targets are driven through the pose curves where the skeleton allows it
+            for (int32 j = 0; j < Node.NumChannels; ++j) {
+                const FName& Name = MorphNames[Node.FirstTarget + j];
+                const SmartName::UID_Type UID = MorphUIDs[Node.FirstTarget + j];
+                if (UID != SmartName::MaxUID) {
+                    MorphCurveBatch.Add({ i, j, UID });
+                }
+                else if (Name != NAME_None) {
+                    MorphBatch.Add({ i, j, Name });
+                }
+            }
+        }
+        else if (Node.Type == SG_OTHER_ANIMATION_NODE) {
+            for (int32 j = 0; j < Node.NumChannels; ++j) {
+                const SmartName::UID_Type UID = CurveUIDs[Node.FirstTarget + j];
+                if (UID != SmartName::MaxUID) {
+                    CurveBatch.Add({ i, j, UID });
+                }
+            }
+        }
+    }
+
+    // Bound by every avatar on the animation threads, each morph target is only logged once
+    static FCriticalSection LoggedLock;
+    static TSet<FName> LoggedMorphs;
+    FScopeLock ScopeLock(&LoggedLock);
+    for (const FSGMorphTarget& Target : MorphBatch) {
+        bool bLogged = false;
+        LoggedMorphs.Add(Target.Name, &bLogged);
+        if (!bLogged) {
+            UE_LOG(LogTemp, Warning, TEXT("[SG_COM] : Morph target %s has no morph target curve on the skeleton and is set on the mesh by the game thread"), *Target.Name.ToString());
+        }
+    }
+}
+
+// ========================================================
+// Curve driving a morph target
+// ========================================================
+SmartName::UID_Type FSGNodeBinding::FindMorphCurve(const USkeleton* Skeleton, const FName& MorphName)
+{
+    if (MorphName == NAME_None) {
+        return SmartName::MaxUID;
+    }
+
+    // Only curves flagged as morph targets reach the mesh
+    const FCurveMetaData* MetaData = Skeleton->GetCurveMetaData(MorphName);
+    if (!MetaData || !MetaData->Type.bMorphtarget) {
+        return SmartName::MaxUID;
+    }
+    return Skeleton->GetUIDByName(USkeleton::AnimCurveMappingName, MorphName);
+}
+
+// ========================================================
+// Hash of the names a binding depends on
+// ========================================================
+FString FSGNodeBinding::HashSkeleton(const USkeleton* Skeleton, const USkeletalMesh* Mesh)
+{
+    FMD5 Md5;
+    auto UpdateName = [&Md5](const FName& Name) {
+        const FString String = Name.ToString();
+        Md5.Update((const uint8*)*String, String.Len() * sizeof(TCHAR));
+    };
+
+    for (const FMeshBoneInfo& BoneInfo : Skeleton->GetReferenceSkeleton().GetRefBoneInfo()) {
+        UpdateName(BoneInfo.Name);
+    }
+
+    // Curve UIDs depend on the order the names were added
+    if (const FSmartNameMapping* Mapping = Skeleton->GetSmartNameContainer(USkeleton::AnimCurveMappingName)) {
+        TArray<FName> CurveNames;
+        Mapping->FillNameArray(CurveNames);
+        for (const FName& CurveName : CurveNames) {
+            UpdateName(CurveName);
+            SmartName::UID_Type UID = Mapping->FindUID(CurveName);
+            Md5.Update((const uint8*)&UID, sizeof(UID));
+
+            // Morph target curves are bound in place of the morph targets
+            const FCurveMetaData* MetaData = Mapping->GetCurveMetaData(CurveName);
+            const uint8 bMorphtarget = MetaData && MetaData->Type.bMorphtarget ? 1 : 0;
+            Md5.Update(&bMorphtarget, sizeof(bMorphtarget));
+        }
+    }
+
+    if (Mesh) {
+        for (const UMorphTarget* MorphTarget : Mesh->MorphTargets) {
+            if (MorphTarget) {
+                UpdateName(MorphTarget->GetFName());
+            }
+        }
+    }
+
+    uint8 Digest[16];
+    Md5.Final(Digest);
+    return BytesToHex(Digest, sizeof(Digest));
+}
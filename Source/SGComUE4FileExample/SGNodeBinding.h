@@ -0,0 +1,167 @@
+// Resolves the SG animation nodes of a character to the bones, morph targets
+// and curves of a skeletal mesh, cached on disk per character and skeleton.
+// The cache files are read and written on the game thread, bindings made on
+// the animation threads only look them up in memory.
+
+#pragma once
+
+#include "SG.h"
+
+#include "CoreMinimal.h"
+#include "Animation/SmartName.h"
+#include "HAL/CriticalSection.h"
+
+class USkeleton;
+class USkeletalMesh;
+
+// Where the channels of one animation node are applied
+struct FSGBoundNode
+{
+    FName Name;
+    uint8 Type = SG_OTHER_ANIMATION_NODE;
+    int32 NumChannels = 0;
+
+    // Skeleton bone index of a joint, INDEX_NONE if it was not found
+    int32 SkeletonBoneIndex = INDEX_NONE;
+
+    // First entry of the node in the morph names or curve UIDs
+    int32 FirstTarget = 0;
+
+    // First channel of the node among the channels of all nodes
+    int32 ChannelOffset = 0;
+};
+
+// A joint node in the joint batch
+struct FSGJointTarget
+{
+    int32 NodeIndex = 0;
+    int32 SkeletonBoneIndex = INDEX_NONE;
+};
+
+// A blendshape channel set on the mesh, when its morph target has no curve
+struct FSGMorphTarget
+{
+    int32 NodeIndex = 0;
+    int32 Channel = 0;
+    FName Name;
+};
+
+// A channel written to a curve of the pose, an other channel in the curve
+// batch or a blendshape channel in the morph curve batch
+struct FSGCurveTarget
+{
+    int32 NodeIndex = 0;
+    int32 Channel = 0;
+    SmartName::UID_Type UID = SmartName::MaxUID;
+};
+
+// Cached bindings of the current character
+class SGCOMUE4FILEEXAMPLE_API FSGNodeBindingCache
+{
+public:
+    static FSGNodeBindingCache& Get();
+
+    // Read the cached bindings of a character from disk, called on the game
+    // thread before its avatars are bound
+    void Load(const FString& CharacterHash);
+
+    // Check if the bindings of a character were read
+    bool IsLoaded(const FString& CharacterHash) const;
+
+    // Find a cached binding by name, from any thread
+    bool Find(const FString& Name, TArray<uint8>& OutData) const;
+
+    // Add a binding, written to disk by the next Flush
+    void Add(const FString& Name, TArray<uint8>&& Data);
+
+    // Write the bindings added since the last call, called on the game thread
+    void Flush();
+
+private:
+    static FString GetDirectory();
+
+    mutable FCriticalSection Lock;
+    FString LoadedHash;
+    TMap<FString, TArray<uint8>> Entries;
+    TArray<FString> Unsaved;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGNodeBinding
+{
+public:
+    // Bind the animation nodes of the given animation type to a skeleton and
+    // mesh, using the cached binding when the character and skeleton are
+    // unchanged and resolving and caching it otherwise. Fails until the
+    // cache of the character was loaded.
+    bool Bind(const SG_AnimationNode* Nodes, sg_size NumNodes, SG_AnimationType AnimationType, const FString& CharacterHash, const USkeleton* Skeleton, const USkeletalMesh* Mesh);
+
+    // Check if the binding was made for the given nodes
+    bool IsBoundTo(const SG_AnimationNode* Nodes, sg_size NumNodes, SG_AnimationType AnimationType) const;
+
+    void Reset();
+
+    const TArray<FSGBoundNode>& GetNodes() const { return Nodes; }
+
+    // Morph target of each blendshape channel, NAME_None if it was not found
+    const TArray<FName>& GetMorphNames() const { return MorphNames; }
+
+    // Morph target curve of each blendshape channel, SmartName::MaxUID if
+    // the skeleton has no curve driving its morph target
+    const TArray<SmartName::UID_Type>& GetMorphUIDs() const { return MorphUIDs; }
+
+    // Curve of each other channel, SmartName::MaxUID if it was not found
+    const TArray<SmartName::UID_Type>& GetCurveUIDs() const { return CurveUIDs; }
+
+    // The nodes grouped by type, without the targets that were not found
+    const TArray<FSGJointTarget>& GetJointBatch() const { return JointBatch; }
+    const TArray<FSGCurveTarget>& GetMorphCurveBatch() const { return MorphCurveBatch; }
+    const TArray<FSGMorphTarget>& GetMorphBatch() const { return MorphBatch; }
+    const TArray<FSGCurveTarget>& GetCurveBatch() const { return CurveBatch; }
+
+    // Number of channels of all nodes
+    int32 GetNumChannels() const { return NumChannels; }
+
+private:
+    // Resolve the node names of normal animation, whose joints and raw rig
+    // controls are evaluated by the rig logic in Unreal
+    void Resolve(const SG_AnimationNode* InNodes, sg_size NumNodes, const USkeleton* Skeleton, const USkeletalMesh* Mesh);
+
+    // Resolve the node names of baked animation, whose joints and blendshapes
+    // already went through the rig logic of the character setup
+    void ResolveBaked(const SG_AnimationNode* InNodes, sg_size NumNodes, const USkeleton* Skeleton, const USkeletalMesh* Mesh);
+
+    // Load a cached binding, false if it is missing, does not match the nodes
+    // or refers past the targets or the bones of the skeleton
+    bool Load(const FString& Name, const SG_AnimationNode* InNodes, sg_size NumNodes, SG_AnimationType InAnimationType, const USkeleton* Skeleton);
+
+    // Add the binding to the cache
+    void Save(const FString& Name);
+
+    // Read or write the binding in the cache file layout
+    bool Serialize(FArchive& Ar);
+
+    // Check that the nodes of a loaded binding stay within its targets and
+    // the bones of the skeleton
+    bool IsWithinBounds(int32 NumBones) const;
+
+    // Group the resolved nodes into batches by type
+    void BuildBatches();
+
+    // Curve driving a morph target, SmartName::MaxUID if the skeleton has none
+    static SmartName::UID_Type FindMorphCurve(const USkeleton* Skeleton, const FName& MorphName);
+
+    // Hash of the bone, curve and morph target names a binding depends on
+    static FString HashSkeleton(const USkeleton* Skeleton, const USkeletalMesh* Mesh);
+
+    uint8 AnimationType = SG_NORMAL_ANIMATION;
+    TArray<FSGBoundNode> Nodes;
+    TArray<FName> MorphNames;
+    TArray<SmartName::UID_Type> MorphUIDs;
+    TArray<SmartName::UID_Type> CurveUIDs;
+
+    TArray<FSGJointTarget> JointBatch;
+    TArray<FSGCurveTarget> MorphCurveBatch;
+    TArray<FSGMorphTarget> MorphBatch;
+    TArray<FSGCurveTarget> CurveBatch;
+    int32 NumChannels = 0;
+};
@@ -0,0 +1,173 @@
+// Applies the bound animation nodes one batch per node type, with the batches
+// a character has selected at compile time
+
+#pragma once
+
+#include "SGNodeBinding.h"
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+
+// What the kernels read from and write to
+struct FSGKernelContext
+{
+    // Channel values of all nodes in node order, from the snapshot published
+    // by the game thread
+    const float* Values = nullptr;
+    const FSGNodeBinding* Binding = nullptr;
+
+    // Channel values of all nodes blended for a cross-fade, nullptr to read Values
+    const float* BlendedValues = nullptr;
+
+    FPoseContext* Output = nullptr;
+
+    // Receives the value of each morph target in the morph batch, set on the
+    // mesh later by the game thread
+    float* MorphValues = nullptr;
+
+    // Scales the morph values, which are not blended with the pose
+    float MorphTargetWeight = 1.f;
+
+    // Receives the applied channel values for the pose stream, nullptr if not streaming
+    float* StreamValues = nullptr;
+
+    FORCEINLINE const float* GetValues(int32 NodeIndex) const
+    {
+        return (BlendedValues ? BlendedValues : Values) + Binding->GetNodes()[NodeIndex].ChannelOffset;
+    }
+
+    FORCEINLINE float* GetStreamValues(int32 NodeIndex) const
+    {
+        return StreamValues + Binding->GetNodes()[NodeIndex].ChannelOffset;
+    }
+};
+
+template <SG_AnimationNodeType Type>
+struct TSGNodeKernel;
+
+// Joints add a translation and rotation and scale the bone
+template <>
+struct TSGNodeKernel<SG_JOINT>
+{
+    static void Apply(const FSGKernelContext& Context)
+    {
+        FCompactPose& Pose = Context.Output->Pose;
+        const FBoneContainer& BoneContainer = Pose.GetBoneContainer();
+
+        for (const FSGJointTarget& Target : Context.Binding->GetJointBatch()) {
+            // Bones can be missing from the current LOD
+            const FCompactPoseBoneIndex idx = BoneContainer.GetCompactPoseIndexFromSkeletonIndex(Target.SkeletonBoneIndex);
+            if (!idx.IsValid()) {
+                continue;
+            }
+
+            const float* AnimationData = Context.GetValues(Target.NodeIndex);
+            FVector l = FVector(AnimationData[0], -AnimationData[1], AnimationData[2]);
+            FQuat q = FQuat::MakeFromEuler(FVector(AnimationData[3], -AnimationData[4], -AnimationData[5]));
+            FVector s = FVector(AnimationData[6], AnimationData[7], AnimationData[8]);
+
+            FTransform& Transform = Pose[idx];
+            Transform.AddToTranslation(l);
+            Transform.ConcatenateRotation(q);
+            Transform.SetScale3D(Transform.GetScale3D() * s);
+
+            if (Context.StreamValues) {
+                float* Stream = Context.GetStreamValues(Target.NodeIndex);
+                Stream[0] = l.X;
+                Stream[1] = l.Y;
+                Stream[2] = l.Z;
+                Stream[3] = AnimationData[3];
+                Stream[4] = -AnimationData[4];
+                Stream[5] = -AnimationData[5];
+                Stream[6] = s.X;
+                Stream[7] = s.Y;
+                Stream[8] = s.Z;
+            }
+        }
+    }
+};
+
+// Blendshapes write the morph target curves of the pose, and collect the
+// morph targets without a curve for the game thread to set on the mesh
+template <>
+struct TSGNodeKernel<SG_BLENDSHAPE>
+{
+    static void Apply(const FSGKernelContext& Context)
+    {
+        FBlendedCurve& Curve = Context.Output->Curve;
+        for (const FSGCurveTarget& Target : Context.Binding->GetMorphCurveBatch()) {
+            const float Value = Context.GetValues(Target.NodeIndex)[Target.Channel];
+            Curve.Set(Target.UID, Value);
+
+            if (Context.StreamValues) {
+                Context.GetStreamValues(Target.NodeIndex)[Target.Channel] = Value;
+            }
+        }
+
+        const TArray<FSGMorphTarget>& MorphBatch = Context.Binding->GetMorphBatch();
+        for (int32 i = 0; i < MorphBatch.Num(); ++i) {
+            const FSGMorphTarget& Target = MorphBatch[i];
+            const float Value = Context.GetValues(Target.NodeIndex)[Target.Channel];
+            Context.MorphValues[i] = Value * Context.MorphTargetWeight;
+
+            if (Context.StreamValues) {
+                Context.GetStreamValues(Target.NodeIndex)[Target.Channel] = Value;
+            }
+        }
+    }
+};
+
+// Other nodes set animation curves, specific to Metahumans
+template <>
+struct TSGNodeKernel<SG_OTHER_ANIMATION_NODE>
+{
+    static void Apply(const FSGKernelContext& Context)
+    {
+        FBlendedCurve& Curve = Context.Output->Curve;
+        for (const FSGCurveTarget& Target : Context.Binding->GetCurveBatch()) {
+            const float Value = Context.GetValues(Target.NodeIndex)[Target.Channel];
+            Curve.Set(Target.UID, Value);
+
+            if (Context.StreamValues) {
+                Context.GetStreamValues(Target.NodeIndex)[Target.Channel] = Value;
+            }
+        }
+    }
+};
+
+// Apply the batches of the node types a character has
+template <bool bJoints, bool bMorphs, bool bCurves>
+void ApplySGNodeBatches(const FSGKernelContext& Context)
+{
+    if (bJoints) {
+        TSGNodeKernel<SG_JOINT>::Apply(Context);
+    }
+    if (bMorphs) {
+        TSGNodeKernel<SG_BLENDSHAPE>::Apply(Context);
+    }
+    if (bCurves) {
+        TSGNodeKernel<SG_OTHER_ANIMATION_NODE>::Apply(Context);
+    }
+}
+
+using FSGApplyBatchesFunc = void (*)(const FSGKernelContext&);
+
+// Select the batch applier for the node types present in a binding
+inline FSGApplyBatchesFunc SelectSGNodeBatches(const FSGNodeBinding& Binding)
+{
+    static const FSGApplyBatchesFunc Appliers[8] = {
+        &ApplySGNodeBatches<false, false, false>,
+        &ApplySGNodeBatches<false, false, true>,
+        &ApplySGNodeBatches<false, true, false>,
+        &ApplySGNodeBatches<false, true, true>,
+        &ApplySGNodeBatches<true, false, false>,
+        &ApplySGNodeBatches<true, false, true>,
+        &ApplySGNodeBatches<true, true, false>,
+        &ApplySGNodeBatches<true, true, true>,
+    };
+
+    const int32 Index = (Binding.GetJointBatch().Num() > 0 ? 4 : 0)
+                      | (Binding.GetMorphBatch().Num() + Binding.GetMorphCurveBatch().Num() > 0 ? 2 : 0)
+                      | (Binding.GetCurveBatch().Num() > 0 ? 1 : 0);
+    return Appliers[Index];
+}
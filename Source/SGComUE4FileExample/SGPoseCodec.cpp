@@ -0,0 +1,308 @@
+#include "SGPoseCodec.h"
+
+// ========================================================
+// Varint helpers
+// ========================================================
+static void WriteVarint(TArray<uint8>& Data, uint32 Value)
+{
+    while (Value >= 0x80) {
+        Data.Add((uint8)(Value | 0x80));
+        Value >>= 7;
+    }
+    Data.Add((uint8)Value);
+}
+
+static void WriteSignedVarint(TArray<uint8>& Data, int32 Value)
+{
+    WriteVarint(Data, ((uint32)Value << 1) ^ (uint32)(Value >> 31));
+}
+
+static bool ReadVarint(const uint8*& Cursor, const uint8* End, uint32& OutValue)
+{
+    OutValue = 0;
+    for (int32 Shift = 0; Shift < 35 && Cursor < End; Shift += 7) {
+        const uint8 Byte = *Cursor++;
+        OutValue |= (uint32)(Byte & 0x7F) << Shift;
+        if ((Byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ReadSignedVarint(const uint8*& Cursor, const uint8* End, int32& OutValue)
+{
+    uint32 Value;
+    if (!ReadVarint(Cursor, End, Value)) {
+        return false;
+    }
+    OutValue = (int32)(Value >> 1) ^ -(int32)(Value & 1);
+    return true;
+}
+
+// ========================================================
+// Quantization step of a channel class
+// ========================================================
+float FSGPoseDecoder::GetStep(ESGPoseChannelClass Class)
+{
+    switch (Class) {
+        case ESGPoseChannelClass::Translation:
+            return 0.001f;
+        case ESGPoseChannelClass::Rotation:
+            return 0.01f;
+        case ESGPoseChannelClass::Scale:
+            return 0.0001f;
+        case ESGPoseChannelClass::Weight:
+        default:
+            return 1.f / 4096.f;
+    };
+}
+
+// ========================================================
+// Set the class of every channel and the keyframe interval
+// ========================================================
+void FSGPoseEncoder::Configure(TArrayView<const ESGPoseChannelClass> InClasses, int32 InKeyframeInterval)
+{
+    Classes = InClasses;
+    Previous.Init(0, Classes.Num());
+    KeyframeInterval = FMath::Max(1, InKeyframeInterval);
+    bKeyframeRequested = true;
+}
+
+void FSGPoseEncoder::RequestKeyframe()
+{
+    bKeyframeRequested = true;
+}
+
+// Channels in a keyframe part, with the largest varint for every value
+static const int32 KeyframePartChannels = (SG_POSE_MAX_DATAGRAM - sizeof(FSGPoseHeader) - sizeof(FSGPoseKeyframePart)) * 4 / 21;
+
+// ========================================================
+// Encode one frame of channel values
+// ========================================================
+void FSGPoseEncoder::Encode(uint16 Avatar, TArrayView<const float> Values, TArray<TArray<uint8>>& OutDatagrams)
+{
+    const int32 NumChannels = Classes.Num();
+    check(Values.Num() == NumChannels);
+
+    Quantized.SetNumUninitialized(NumChannels, false);
+    for (int32 i = 0; i < NumChannels; ++i) {
+        Quantized[i] = FMath::RoundToInt(Values[i] / FSGPoseDecoder::GetStep(Classes[i]));
+    }
+
+    FSGPoseHeader Header;
+    Header.Magic = SG_POSE_MAGIC;
+    Header.Version = SG_POSE_VERSION;
+    Header.Avatar = Avatar;
+    Header.Sequence = Sequence;
+    Header.NumChannels = (uint16)NumChannels;
+
+    OutDatagrams.SetNum(1);
+    bool bKeyframe = bKeyframeRequested || FramesSinceKeyframe >= KeyframeInterval;
+    if (!bKeyframe) {
+        TArray<uint8>& Data = OutDatagrams[0];
+        Header.Flags = 0;
+        Data.Reset();
+        Data.Append((const uint8*)&Header, sizeof(Header));
+
+        // Runs of unchanged channels cost one byte
+        uint32 Unchanged = 0;
+        for (int32 i = 0; i < NumChannels; ++i) {
+            const int32 Delta = Quantized[i] - Previous[i];
+            if (Delta == 0) {
+                Unchanged++;
+                continue;
+            }
+
+            WriteVarint(Data, Unchanged);
+            WriteSignedVarint(Data, Delta);
+            Unchanged = 0;
+        }
+        if (Unchanged > 0) {
+            WriteVarint(Data, Unchanged);
+        }
+
+        // A keyframe is split in parts, a delta frame is not
+        bKeyframe = Data.Num() > SG_POSE_MAX_DATAGRAM;
+    }
+
+    if (bKeyframe) {
+        Header.Flags = SG_POSE_FLAG_KEYFRAME;
+        EncodeKeyframe(Header, OutDatagrams);
+    }
+
+    FramesSinceKeyframe = bKeyframe ? 1 : FramesSinceKeyframe + 1;
+    bKeyframeRequested = false;
+    Sequence++;
+    Previous = Quantized;
+}
+
+// ========================================================
+// Encode the quantized values as keyframe parts
+// ========================================================
+void FSGPoseEncoder::EncodeKeyframe(const FSGPoseHeader& Header, TArray<TArray<uint8>>& OutDatagrams) const
+{
+    const int32 NumChannels = Classes.Num();
+    const int32 NumParts = FMath::Max(1, FMath::DivideAndRoundUp(NumChannels, KeyframePartChannels));
+    OutDatagrams.SetNum(NumParts);
+
+    for (int32 Part = 0; Part < NumParts; ++Part) {
+        FSGPoseKeyframePart PartHeader;
+        PartHeader.FirstChannel = (uint16)(Part * KeyframePartChannels);
+        PartHeader.NumChannels = (uint16)FMath::Min(KeyframePartChannels, NumChannels - PartHeader.FirstChannel);
+
+        TArray<uint8>& Data = OutDatagrams[Part];
+        Data.Reset();
+        Data.Append((const uint8*)&Header, sizeof(Header));
+        Data.Append((const uint8*)&PartHeader, sizeof(PartHeader));
+
+        // Channel classes, 4 per byte
+        for (int32 i = 0; i < PartHeader.NumChannels; i += 4) {
+            uint8 Packed = 0;
+            for (int32 j = 0; j < 4 && i + j < PartHeader.NumChannels; ++j) {
+                Packed |= (uint8)Classes[PartHeader.FirstChannel + i + j] << (j * 2);
+            }
+            Data.Add(Packed);
+        }
+
+        for (int32 i = 0; i < PartHeader.NumChannels; ++i) {
+            WriteSignedVarint(Data, Quantized[PartHeader.FirstChannel + i]);
+        }
+    }
+}
+
+// ========================================================
+// Decode one datagram
+// ========================================================
+bool FSGPoseDecoder::Decode(TArrayView<const uint8> Data, TArray<float>& OutValues, uint16* OutAvatar)
+{
+    if (Data.Num() < (int32)sizeof(FSGPoseHeader)) {
+        return false;
+    }
+
+    FSGPoseHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+    if (Header.Magic != SG_POSE_MAGIC || Header.Version != SG_POSE_VERSION) {
+        return false;
+    }
+
+    const uint8* Cursor = Data.GetData() + sizeof(Header);
+    const uint8* End = Data.GetData() + Data.Num();
+    FAvatarState& State = Avatars.FindOrAdd(Header.Avatar);
+
+    const bool bDecoded = (Header.Flags & SG_POSE_FLAG_KEYFRAME)
+        ? DecodeKeyframePart(Header, Cursor, End, State)
+        : DecodeDelta(Header, Cursor, End, State);
+    if (!bDecoded) {
+        return false;
+    }
+
+    const int32 NumChannels = State.Previous.Num();
+    OutValues.SetNumUninitialized(NumChannels);
+    for (int32 i = 0; i < NumChannels; ++i) {
+        OutValues[i] = State.Previous[i] * GetStep(State.Classes[i]);
+    }
+    if (OutAvatar) {
+        *OutAvatar = Header.Avatar;
+    }
+    return true;
+}
+
+// ========================================================
+// Read a keyframe part, the keyframe replaces the previous
+// frame once all of its channels were read
+// ========================================================
+bool FSGPoseDecoder::DecodeKeyframePart(const FSGPoseHeader& Header, const uint8* Cursor, const uint8* End, FAvatarState& State)
+{
+    const int32 NumChannels = Header.NumChannels;
+    if (End - Cursor < (int32)sizeof(FSGPoseKeyframePart)) {
+        return false;
+    }
+
+    FSGPoseKeyframePart Part;
+    FMemory::Memcpy(&Part, Cursor, sizeof(Part));
+    Cursor += sizeof(Part);
+    if (Part.NumChannels == 0 || Part.FirstChannel + Part.NumChannels > NumChannels) {
+        return false;
+    }
+
+    const int32 NumClassBytes = (Part.NumChannels + 3) / 4;
+    if (End - Cursor < NumClassBytes) {
+        return false;
+    }
+
+    // Parts of an older keyframe that did not complete are dropped
+    if (State.KeyframeSequence != Header.Sequence || State.KeyframeValues.Num() != NumChannels || State.NumKeyframeReceived == 0) {
+        State.KeyframeSequence = Header.Sequence;
+        State.KeyframeClasses.SetNumUninitialized(NumChannels);
+        State.KeyframeValues.SetNumUninitialized(NumChannels);
+        State.KeyframeReceived.Init(false, NumChannels);
+        State.NumKeyframeReceived = 0;
+    }
+
+    const uint8* ClassBytes = Cursor;
+    Cursor += NumClassBytes;
+    for (int32 i = 0; i < Part.NumChannels; ++i) {
+        const int32 Channel = Part.FirstChannel + i;
+        int32 Value;
+        if (!ReadSignedVarint(Cursor, End, Value)) {
+            return false;
+        }
+
+        State.KeyframeClasses[Channel] = (ESGPoseChannelClass)((ClassBytes[i / 4] >> ((i % 4) * 2)) & 0x03);
+        State.KeyframeValues[Channel] = Value;
+        if (!State.KeyframeReceived[Channel]) {
+            State.KeyframeReceived[Channel] = true;
+            State.NumKeyframeReceived++;
+        }
+    }
+
+    if (State.NumKeyframeReceived < NumChannels) {
+        return false;
+    }
+
+    State.Classes = State.KeyframeClasses;
+    State.Previous = State.KeyframeValues;
+    State.Sequence = Header.Sequence;
+    State.bSynced = true;
+    State.NumKeyframeReceived = 0;
+    return true;
+}
+
+// ========================================================
+// Read a delta frame on top of the previous frame
+// ========================================================
+bool FSGPoseDecoder::DecodeDelta(const FSGPoseHeader& Header, const uint8* Cursor, const uint8* End, FAvatarState& State)
+{
+    // A delta frame needs the frame before it
+    const int32 NumChannels = Header.NumChannels;
+    if (!State.bSynced || Header.Sequence != State.Sequence + 1 || NumChannels != State.Classes.Num()) {
+        State.bSynced = false;
+        return false;
+    }
+
+    // Counts and changes are checked against the channels left, so a bad
+    // datagram cannot write past the previous frame
+    int32 Channel = 0;
+    while (Channel < NumChannels) {
+        uint32 Unchanged;
+        if (!ReadVarint(Cursor, End, Unchanged) || Unchanged > (uint32)(NumChannels - Channel)) {
+            State.bSynced = false;
+            return false;
+        }
+        Channel += (int32)Unchanged;
+        if (Channel >= NumChannels) {
+            break;
+        }
+
+        int32 Delta;
+        if (!ReadSignedVarint(Cursor, End, Delta)) {
+            State.bSynced = false;
+            return false;
+        }
+        State.Previous[Channel++] += Delta;
+    }
+
+    State.Sequence = Header.Sequence;
+    return true;
+}
@@ -0,0 +1,120 @@
+// Compact encoding of the per-avatar channel values sent on the pose stream
+//
+// Every datagram is a FSGPoseHeader followed by its payload. Channel values
+// are quantized with the step of their channel class. A keyframe is split in
+// parts that fit SG_POSE_MAX_DATAGRAM, sharing the sequence number of the
+// frame. A part holds a FSGPoseKeyframePart, the class of each of its
+// channels, packed 2 bits per channel, then the quantized value of each of its
+// channels as a zigzag varint. A delta frame holds pairs of a varint count of
+// unchanged channels and the zigzag varint change of the next channel from
+// the previous frame, until all channels are covered. A delta frame that
+// would not fit a datagram is sent as a keyframe instead. Delta frames only
+// decode on top of the previous sequence number of their avatar, so a
+// receiver that lost a frame waits for the next keyframe. All fields are
+// little endian.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#define SG_POSE_MAGIC 0x53504753 // "SGPS"
+#define SG_POSE_VERSION 2
+
+// Largest datagram sent, below the usual 1500 byte MTU
+#define SG_POSE_MAX_DATAGRAM 1200
+
+// Frame flags
+#define SG_POSE_FLAG_KEYFRAME 0x01
+
+#pragma pack(push, 1)
+struct FSGPoseHeader
+{
+    uint32 Magic;
+    uint8 Version;
+    uint8 Flags;
+    uint16 Avatar;
+    uint32 Sequence;
+    uint16 NumChannels;
+};
+
+// Channels held by one part of a keyframe
+struct FSGPoseKeyframePart
+{
+    uint16 FirstChannel;
+    uint16 NumChannels;
+};
+#pragma pack(pop)
+
+// What a channel holds, which sets its quantization step
+enum class ESGPoseChannelClass : uint8
+{
+    Translation, // cm, in steps of 0.001
+    Rotation,    // Degrees, in steps of 0.01
+    Scale,       // In steps of 0.0001
+    Weight       // Blendshape or curve weight, in steps of 1/4096
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGPoseEncoder
+{
+public:
+    // Set the class of every channel and how many frames apart keyframes are
+    void Configure(TArrayView<const ESGPoseChannelClass> InClasses, int32 InKeyframeInterval);
+
+    // Make the next frame a keyframe
+    void RequestKeyframe();
+
+    int32 GetNumChannels() const { return Classes.Num(); }
+
+    // Encode one frame of channel values into one datagram per element of
+    // OutDatagrams, several for a keyframe too large for one datagram
+    void Encode(uint16 Avatar, TArrayView<const float> Values, TArray<TArray<uint8>>& OutDatagrams);
+
+private:
+    // Encode the quantized values as keyframe parts
+    void EncodeKeyframe(const FSGPoseHeader& Header, TArray<TArray<uint8>>& OutDatagrams) const;
+
+    TArray<ESGPoseChannelClass> Classes;
+    TArray<int32> Previous;
+    TArray<int32> Quantized;
+    int32 KeyframeInterval = 30;
+    int32 FramesSinceKeyframe = 0;
+    uint32 Sequence = 0;
+    bool bKeyframeRequested = true;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGPoseDecoder
+{
+public:
+    // Decode one datagram into OutValues, false if it is invalid, cannot be
+    // decoded until the next keyframe or is a part of a keyframe that is not
+    // complete yet
+    bool Decode(TArrayView<const uint8> Data, TArray<float>& OutValues, uint16* OutAvatar = nullptr);
+
+    // Quantization step of a channel class
+    static float GetStep(ESGPoseChannelClass Class);
+
+private:
+    // Frames of every avatar decode on top of the previous frame of that avatar
+    struct FAvatarState
+    {
+        TArray<ESGPoseChannelClass> Classes;
+        TArray<int32> Previous;
+        uint32 Sequence = 0;
+        bool bSynced = false;
+
+        // Keyframe being reassembled from its parts
+        uint32 KeyframeSequence = 0;
+        TArray<ESGPoseChannelClass> KeyframeClasses;
+        TArray<int32> KeyframeValues;
+        TBitArray<> KeyframeReceived;
+        int32 NumKeyframeReceived = 0;
+    };
+
+    // Read a keyframe part, true once every part of the keyframe was read
+    static bool DecodeKeyframePart(const FSGPoseHeader& Header, const uint8* Cursor, const uint8* End, FAvatarState& State);
+
+    // Read a delta frame on top of the previous frame
+    static bool DecodeDelta(const FSGPoseHeader& Header, const uint8* Cursor, const uint8* End, FAvatarState& State);
+
+    TMap<uint16, FAvatarState> Avatars;
+};
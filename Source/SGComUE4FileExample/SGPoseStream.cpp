@@ -0,0 +1,91 @@
+#include "SGPoseStream.h"
+
+#include "SGComManager.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "Misc/ScopeLock.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Pose Stream (kbit/s)"), STAT_SGCom_PoseStreamBitrate, STATGROUP_SGCom);
+
+// ========================================================
+// The stream shared by all avatars
+// ========================================================
+FSGPoseStream& FSGPoseStream::Get()
+{
+    static FSGPoseStream Stream;
+    return Stream;
+}
+
+// ========================================================
+// Start sending to an address
+// ========================================================
+bool FSGPoseStream::Start(const FString& Address)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (!FIPv4Endpoint::Parse(Address, Endpoint)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Invalid pose stream address %s"), *Address);
+        return false;
+    }
+
+    Socket = FUdpSocketBuilder(TEXT("SGPoseStream")).Build();
+    if (!Socket) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to create the pose stream socket"));
+        return false;
+    }
+
+    RemoteAddr = Endpoint.ToInternetAddr();
+    WindowStartTime = FPlatformTime::Seconds();
+    WindowBytes = 0;
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Streaming poses to %s"), *Endpoint.ToString());
+    return true;
+}
+
+// ========================================================
+// Stop sending
+// ========================================================
+void FSGPoseStream::Shutdown()
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (Socket) {
+        Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+}
+
+bool FSGPoseStream::IsRunning() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Socket != nullptr;
+}
+
+uint16 FSGPoseStream::AllocateAvatar()
+{
+    return NextAvatar++;
+}
+
+// ========================================================
+// Send one encoded datagram
+// ========================================================
+void FSGPoseStream::Send(TArrayView<const uint8> Datagram)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (!Socket) {
+        return;
+    }
+
+    int32 BytesSent = 0;
+    Socket->SendTo(Datagram.GetData(), Datagram.Num(), BytesSent, *RemoteAddr);
+
+    WindowBytes += BytesSent;
+    const double Now = FPlatformTime::Seconds();
+    if (Now - WindowStartTime >= 1.0) {
+        SET_FLOAT_STAT(STAT_SGCom_PoseStreamBitrate, WindowBytes * 8.0 / 1000.0 / (Now - WindowStartTime));
+        WindowStartTime = Now;
+        WindowBytes = 0;
+    }
+}
@@ -0,0 +1,42 @@
+// Sends the encoded per-avatar pose frames to a viewer over UDP, see
+// SGPoseCodec.h for the datagram layout
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+
+class FInternetAddr;
+class FSocket;
+
+class SGCOMUE4FILEEXAMPLE_API FSGPoseStream
+{
+public:
+    // The stream shared by all avatars
+    static FSGPoseStream& Get();
+
+    // Start sending to Address, given as host:port
+    bool Start(const FString& Address);
+
+    void Shutdown();
+
+    bool IsRunning() const;
+
+    // Give an avatar the id its frames are sent with
+    uint16 AllocateAvatar();
+
+    // Send one encoded datagram, called on the animation threads
+    void Send(TArrayView<const uint8> Datagram);
+
+private:
+    mutable FCriticalSection Lock;
+    FSocket* Socket = nullptr;
+    FIPv4Endpoint Endpoint;
+    TSharedPtr<FInternetAddr> RemoteAddr;
+    TAtomic<uint16> NextAvatar{ 0 };
+
+    // Bitrate over the last second
+    double WindowStartTime = 0.0;
+    int64 WindowBytes = 0;
+};
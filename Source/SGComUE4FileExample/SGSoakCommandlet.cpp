@@ -0,0 +1,189 @@
+#include "SGSoakCommandlet.h"
+
+#include "SGComManager.h"
+#include "SGComSettings.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Animation frame rate of the sessions
+static const double SoakFrameSec = 1.0 / 60.0;
+
+// Synthetic utterances are 16 bit, 16 kHz
+static const int32 SoakSampleRate = 16000;
+static const double SoakUtteranceSec = 3.0;
+
+// ========================================================
+// Constructor
+// ========================================================
+USGSoakCommandlet::USGSoakCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+// ========================================================
+// Run the soak sessions and write the report
+// ========================================================
+int32 USGSoakCommandlet::Main(const FString& Params)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+
+    int32 NumSessions = 10;
+    double SessionSec = 60.0;
+    double UtteranceIntervalSec = Settings.SoakArrivalIntervalSec;
+    FString ReportPath = Settings.SoakReportFile.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("SGSoak.json") : Settings.SoakReportFile;
+    FString CharacterPath = FPaths::ProjectContentDir() / TEXT("Resources/Characters/Avatar.k");
+    FParse::Value(*Params, TEXT("Sessions="), NumSessions);
+    FParse::Value(*Params, TEXT("SessionSec="), SessionSec);
+    FParse::Value(*Params, TEXT("UtteranceIntervalSec="), UtteranceIntervalSec);
+    FParse::Value(*Params, TEXT("Report="), ReportPath);
+    FParse::Value(*Params, TEXT("Character="), CharacterPath);
+
+    if (!FFileHelper::LoadFileToArray(CharacterFileData, *CharacterPath)) {
+#if SG_COM_STUB
+        // The stub does not read the character, any content gives it a hash
+        const FTCHARToUTF8 Placeholder(TEXT("SG_Com stub character"));
+        CharacterFileData.Append((const uint8*)Placeholder.Get(), Placeholder.Length());
+#else
+        UE_LOG(LogTemp, Error, TEXT("[APP] : Failed to load the character file %s"), *CharacterPath);
+        return 1;
+#endif
+    }
+
+    // Bursts of a voiced tone with pauses, so the voice activity gate sees both
+    const int32 NumSamples = (int32)(SoakUtteranceSec * SoakSampleRate);
+    UtteranceData.SetNumUninitialized(NumSamples * sizeof(int16));
+    int16* Samples = (int16*)UtteranceData.GetData();
+    for (int32 i = 0; i < NumSamples; ++i) {
+        const float Time = (float)i / SoakSampleRate;
+        const bool bVoiced = FMath::Fmod(Time, 0.6f) < 0.4f;
+        Samples[i] = bVoiced ? (int16)(8000.f * FMath::Sin(2.f * PI * 180.f * Time) * (0.6f + 0.4f * FMath::Sin(2.f * PI * 4.f * Time))) : 0;
+    }
+
+    const FString LogPath = FPaths::ProjectSavedDir() / TEXT("Logs") / (TEXT("SG_COM_soak_") + FDateTime::Now().ToString() + TEXT(".txt"));
+    if (!FSGComManager::Initialize(LogPath)) {
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Running %d soak sessions of %.0f s%s"), NumSessions, SessionSec, SG_COM_STUB ? TEXT(" against the SG_Com stub") : TEXT(""));
+    SoakMonitor.Start(ReportPath, Settings.SoakReportIntervalSec);
+
+    int32 NumFailed = 0;
+    for (int32 Session = 0; Session < NumSessions; ++Session) {
+        if (!RunSession(Session, SessionSec, UtteranceIntervalSec)) {
+            NumFailed++;
+        }
+    }
+
+    SoakMonitor.Stop(GetSoakCounters());
+    FSGComManager::Shutdown();
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Soak finished, %d of %d sessions failed, report written to %s"), NumFailed, NumSessions, *ReportPath);
+    return NumFailed > 0 ? 1 : 0;
+}
+
+// ========================================================
+// Run one session on a new engine
+// ========================================================
+bool USGSoakCommandlet::RunSession(int32 Session, double SessionSec, double UtteranceIntervalSec)
+{
+    const FSGComSettings& Settings = FSGComSettings::Get();
+
+    SG_COM_EngineConfig EngineConfig;
+    EngineConfig.character_file_in_memory = (sg_byte*)CharacterFileData.GetData();
+    EngineConfig.character_file_bytes = CharacterFileData.Num();
+    EngineConfig.audio_sample_type = SG_AUDIO_INT_16;
+    EngineConfig.audio_sample_rate = SG_AUDIO_16_KHZ;
+    EngineConfig.local_player = nullptr;
+    EngineConfig.engine_broadcast_callback = nullptr;
+    EngineConfig.engine_status_callback = nullptr;
+    EngineConfig.buffer_sec = (float)Settings.EngineBufferSec;
+    EngineConfig.flag = SG_COM_EngineConfigFlag::SG_COM_ENGINE_CONFIG_ENABLE_IDLE;
+    EngineConfig.custom_engine_data = nullptr;
+
+    if (!FSGComManager::CreateEngine(EngineConfig)) {
+        UE_LOG(LogTemp, Warning, TEXT("[APP] : Soak session %d could not create the engine"), Session);
+        FSGComManager::DestroyEngine();
+        return false;
+    }
+
+    // Engine ticks of 10 ms are run to keep up with the clock, as the
+    // processing thread of the game does
+    const double StartTime = FPlatformTime::Seconds();
+    double NextUtteranceTime = StartTime;
+    double NextTickTime = StartTime;
+    double LastFrameTime = StartTime;
+    while (true) {
+        const double Now = FPlatformTime::Seconds();
+        if (Now - StartTime >= SessionSec) {
+            break;
+        }
+
+        if (Now >= NextUtteranceTime) {
+            FSGComManager::InputAudio(UtteranceData);
+            NumUtterances++;
+            NextUtteranceTime += FMath::Max(SoakUtteranceSec, UtteranceIntervalSec);
+        }
+
+        for (int32 i = 0; i < 10 && NextTickTime <= Now; ++i) {
+            const double TickStart = FPlatformTime::Seconds();
+            FSGComManager::ProcessAudio();
+            SoakMonitor.RecordProcessTick(FPlatformTime::Seconds() - TickStart);
+            NextTickTime += FSGBufferController::FrameMs / 1000.0;
+        }
+        NextTickTime = FMath::Max(NextTickTime, Now - 0.1);
+
+        // Each loop stands in for a game frame, retiring Players as the game would
+        const double FrameStart = FPlatformTime::Seconds();
+        FSGComManager::UpdateAnimation((float)(FrameStart - LastFrameTime));
+        SoakMonitor.RecordGameTick(FPlatformTime::Seconds() - FrameStart);
+        LastFrameTime = FrameStart;
+        GFrameCounter++;
+
+        SoakMonitor.Update([this]() { return GetSoakCounters(); });
+
+        const double SleepSec = FrameStart + SoakFrameSec - FPlatformTime::Seconds();
+        if (SleepSec > 0.0) {
+            FPlatformProcess::Sleep((float)SleepSec);
+        }
+    }
+
+    FinishedUnderruns += FSGComManager::GetBufferController().GetMetrics().NumUnderruns;
+    FSGComManager::GetBufferController().LogMetrics();
+    FSGComManager::DestroyEngine();
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Soak session %d finished"), Session);
+    return true;
+}
+
+// ========================================================
+// Counters of the sessions so far
+// ========================================================
+FSGSoakCounters USGSoakCommandlet::GetSoakCounters() const
+{
+    FSGSoakCounters Counters;
+    Counters.NumUtterances = NumUtterances;
+    Counters.NumUnderruns = FinishedUnderruns;
+    if (FSGComManager::IsEngineValid()) {
+        Counters.NumUnderruns += FSGComManager::GetBufferController().GetMetrics().NumUnderruns;
+        Counters.AudioPoolBytes = FSGComManager::GetMemoryReport().AudioPoolAllocatedBytes;
+    }
+
+    // Totals since the start, the soak monitor reports the cost per interval
+    const FSGAnimationCost AnimationCost = FSGComManager::GetAnimationCost();
+    Counters.bBakedAnimation = FSGComManager::GetAnimationType() == SG_BAKED_ANIMATION;
+    Counters.NumPlayerUpdates = AnimationCost.NumPlayerUpdates;
+    Counters.PlayerUpdateSec = AnimationCost.PlayerUpdateSec;
+    Counters.NumAvatarFrames = AnimationCost.NumAvatarFrames;
+    Counters.AvatarApplySec = AnimationCost.AvatarApplySec;
+
+    const FSGVoiceGateMetrics VoiceGate = FSGComManager::GetVoiceGateMetrics();
+    Counters.VadSkippedMs = VoiceGate.SkippedMs;
+    Counters.VadCpuSavedMs = VoiceGate.CpuSavedMs;
+    return Counters;
+}
@@ -0,0 +1,42 @@
+// Runs soak sessions without a map or avatars and writes the soak report,
+// e.g. against the SG_Com stub built with SG_COM_STUB=1:
+//   UE4Editor-Cmd SGComUE4FileExample -run=SGSoak -Sessions=20 -SessionSec=60 -Report=Saved/Soak.json
+
+#pragma once
+
+#include "SGSoakMonitor.h"
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SGSoakCommandlet.generated.h"
+
+UCLASS()
+class SGCOMUE4FILEEXAMPLE_API USGSoakCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    USGSoakCommandlet();
+
+    // Create the engine, feed it a synthetic utterance every
+    // -UtteranceIntervalSec and animate it at 60 Hz for -SessionSec, then
+    // destroy it, -Sessions times. Returns 0 if every session ran.
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    // Run one session, false if the engine could not be created
+    bool RunSession(int32 Session, double SessionSec, double UtteranceIntervalSec);
+
+    // Counters of the sessions so far, sampled into the report
+    FSGSoakCounters GetSoakCounters() const;
+
+    FSGSoakMonitor SoakMonitor;
+
+    // Character file referenced by the engines, and a speech-like utterance
+    TArray<uint8> CharacterFileData;
+    TArray<uint8> UtteranceData;
+
+    // Totals of the finished sessions, the buffer controller is reset per engine
+    int32 NumUtterances = 0;
+    int32 FinishedUnderruns = 0;
+};
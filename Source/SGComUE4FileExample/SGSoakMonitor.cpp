@@ -0,0 +1,215 @@
+#include "SGSoakMonitor.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/ThreadManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+static const double BytesPerMB = 1024.0 * 1024.0;
+
+// ========================================================
+// Add a duration to the statistics
+// ========================================================
+void FSGSoakMonitor::FDurationStats::Add(double Ms)
+{
+    Count++;
+    TotalMs += Ms;
+    MaxMs = FMath::Max(MaxMs, Ms);
+}
+
+// ========================================================
+// Start recording
+// ========================================================
+void FSGSoakMonitor::Start(const FString& InReportPath, double InIntervalSec)
+{
+    ReportPath = InReportPath;
+    IntervalSec = FMath::Max(1.0, InIntervalSec);
+    StartTime = FPlatformTime::Seconds();
+    NextSampleTime = StartTime + IntervalSec;
+    StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+    Samples.Reset();
+    AnimationBenchmarks.Reset();
+    LastCounters = FSGSoakCounters();
+    bRunning = true;
+
+    UE_LOG(LogTemp, Warning, TEXT("[APP] : Writing soak report to %s every %.0f s"), *ReportPath, IntervalSec);
+}
+
+// ========================================================
+// Copy SourceFile into TargetDirectory every IntervalSec
+// on average
+// ========================================================
+void FSGSoakMonitor::SetArrivalScript(const FString& InSourceFile, const FString& InTargetDirectory, double InIntervalSec, int32 Seed)
+{
+    SourceFile = InSourceFile;
+    TargetDirectory = InTargetDirectory;
+    ArrivalIntervalSec = InIntervalSec;
+    ArrivalStream.Initialize(Seed);
+    NextArrivalTime = FPlatformTime::Seconds() + ArrivalIntervalSec;
+    NumArrivals = 0;
+}
+
+bool FSGSoakMonitor::IsRunning() const
+{
+    return bRunning;
+}
+
+// ========================================================
+// Record the duration of a game tick
+// ========================================================
+void FSGSoakMonitor::RecordGameTick(double Seconds)
+{
+    if (!bRunning) {
+        return;
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    GameTicks.Add(Seconds * 1000.0);
+}
+
+// ========================================================
+// Record the duration of an engine tick
+// ========================================================
+void FSGSoakMonitor::RecordProcessTick(double Seconds)
+{
+    if (!bRunning) {
+        return;
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    ProcessTicks.Add(Seconds * 1000.0);
+}
+
+// ========================================================
+// Drive the arrivals and sample the counters when due
+// ========================================================
+void FSGSoakMonitor::Update(TFunctionRef<FSGSoakCounters()> GetCounters)
+{
+    if (!bRunning) {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+
+    if (ArrivalIntervalSec > 0.0 && Now >= NextArrivalTime) {
+        // Arrivals are uniformly spread between half and one and a half intervals
+        const FString TargetFile = FPaths::Combine(TargetDirectory, FString::Printf(TEXT("soak_%06d.wav"), NumArrivals++));
+        if (IFileManager::Get().Copy(*TargetFile, *SourceFile) != COPY_OK) {
+            UE_LOG(LogTemp, Warning, TEXT("[APP] : Failed to copy soak utterance to %s"), *TargetFile);
+        }
+        NextArrivalTime += ArrivalIntervalSec * (0.5 + ArrivalStream.FRand());
+    }
+
+    if (Now >= NextSampleTime) {
+        NextSampleTime += IntervalSec;
+        Sample(GetCounters());
+    }
+}
+
+// ========================================================
+// Write the final report
+// ========================================================
+void FSGSoakMonitor::Stop(const FSGSoakCounters& Counters)
+{
+    if (!bRunning) {
+        return;
+    }
+
+    Sample(Counters);
+    bRunning = false;
+}
+
+// ========================================================
+// Add an animation benchmark to the report
+// ========================================================
+void FSGSoakMonitor::RecordAnimationBenchmark(bool bBakedAnimation, int32 NumFrames, double RigLogicUs, double BypassedUs)
+{
+    TSharedPtr<FJsonObject> BenchmarkObject = MakeShared<FJsonObject>();
+    BenchmarkObject->SetNumberField(TEXT("time_sec"), FPlatformTime::Seconds() - StartTime);
+    BenchmarkObject->SetStringField(TEXT("animation_type"), bBakedAnimation ? TEXT("baked") : TEXT("normal"));
+    BenchmarkObject->SetNumberField(TEXT("frames"), NumFrames);
+    BenchmarkObject->SetNumberField(TEXT("anim_eval_us_riglogic"), RigLogicUs);
+    BenchmarkObject->SetNumberField(TEXT("anim_eval_us_bypassed"), BypassedUs);
+    AnimationBenchmarks.Add(MakeShared<FJsonValueObject>(BenchmarkObject));
+}
+
+// ========================================================
+// Take a sample and rewrite the report
+// ========================================================
+void FSGSoakMonitor::Sample(const FSGSoakCounters& Counters)
+{
+    FDurationStats Game;
+    FDurationStats Process;
+    {
+        FScopeLock ScopeLock(&Lock);
+        Game = GameTicks;
+        Process = ProcessTicks;
+        GameTicks = FDurationStats();
+        ProcessTicks = FDurationStats();
+    }
+
+    // The animation cost is counted since the start
+    const int64 NumPlayerUpdates = Counters.NumPlayerUpdates - LastCounters.NumPlayerUpdates;
+    const double PlayerUpdateSec = Counters.PlayerUpdateSec - LastCounters.PlayerUpdateSec;
+    const int64 NumAvatarFrames = Counters.NumAvatarFrames - LastCounters.NumAvatarFrames;
+    const double AvatarApplySec = Counters.AvatarApplySec - LastCounters.AvatarApplySec;
+    LastCounters = Counters;
+
+    const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+    const double RssMB = MemoryStats.UsedPhysical / BytesPerMB;
+    const double RssGrowthMB = ((double)MemoryStats.UsedPhysical - (double)StartUsedPhysical) / BytesPerMB;
+
+    TSharedPtr<FJsonObject> SampleObject = MakeShared<FJsonObject>();
+    SampleObject->SetNumberField(TEXT("time_sec"), FPlatformTime::Seconds() - StartTime);
+    SampleObject->SetNumberField(TEXT("rss_mb"), RssMB);
+    SampleObject->SetNumberField(TEXT("rss_growth_mb"), RssGrowthMB);
+    SampleObject->SetNumberField(TEXT("peak_rss_mb"), MemoryStats.PeakUsedPhysical / BytesPerMB);
+    SampleObject->SetNumberField(TEXT("threads"), CountThreads());
+    SampleObject->SetNumberField(TEXT("game_tick_ms_avg"), Game.Count > 0 ? Game.TotalMs / Game.Count : 0.0);
+    SampleObject->SetNumberField(TEXT("game_tick_ms_max"), Game.MaxMs);
+    SampleObject->SetNumberField(TEXT("process_tick_ms_avg"), Process.Count > 0 ? Process.TotalMs / Process.Count : 0.0);
+    SampleObject->SetNumberField(TEXT("process_tick_ms_max"), Process.MaxMs);
+    SampleObject->SetNumberField(TEXT("process_ticks"), Process.Count);
+    SampleObject->SetNumberField(TEXT("utterances"), Counters.NumUtterances);
+    SampleObject->SetNumberField(TEXT("arrivals"), NumArrivals);
+    SampleObject->SetNumberField(TEXT("underruns"), Counters.NumUnderruns);
+    SampleObject->SetNumberField(TEXT("queued_files"), Counters.NumQueuedFiles);
+    SampleObject->SetNumberField(TEXT("discovered_files"), Counters.NumDiscoveredFiles);
+    SampleObject->SetNumberField(TEXT("audio_pool_mb"), Counters.AudioPoolBytes / BytesPerMB);
+    SampleObject->SetStringField(TEXT("animation_type"), Counters.bBakedAnimation ? TEXT("baked") : TEXT("normal"));
+    SampleObject->SetNumberField(TEXT("player_update_us_avg"), NumPlayerUpdates > 0 ? PlayerUpdateSec * 1e6 / NumPlayerUpdates : 0.0);
+    SampleObject->SetNumberField(TEXT("avatar_apply_us_avg"), NumAvatarFrames > 0 ? AvatarApplySec * 1e6 / NumAvatarFrames : 0.0);
+    SampleObject->SetNumberField(TEXT("avatar_frames"), NumAvatarFrames);
+    SampleObject->SetNumberField(TEXT("vad_skipped_ms"), Counters.VadSkippedMs);
+    SampleObject->SetNumberField(TEXT("vad_cpu_saved_ms"), Counters.VadCpuSavedMs);
+    Samples.Add(MakeShared<FJsonValueObject>(SampleObject));
+
+    TSharedPtr<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetNumberField(TEXT("interval_sec"), IntervalSec);
+    Report->SetNumberField(TEXT("duration_sec"), FPlatformTime::Seconds() - StartTime);
+    Report->SetNumberField(TEXT("rss_growth_mb"), RssGrowthMB);
+    Report->SetArrayField(TEXT("samples"), Samples);
+    Report->SetArrayField(TEXT("animation_benchmarks"), AnimationBenchmarks);
+
+    FString Json;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+    FJsonSerializer::Serialize(Report.ToSharedRef(), Writer);
+    FFileHelper::SaveStringToFile(Json, *ReportPath);
+}
+
+// ========================================================
+// Number of threads created through the engine
+// ========================================================
+int32 FSGSoakMonitor::CountThreads()
+{
+    int32 NumThreads = 0;
+    FThreadManager::Get().ForEachThread([&NumThreads](uint32 ThreadId, FRunnableThread* Thread) {
+        NumThreads++;
+    });
+    return NumThreads;
+}
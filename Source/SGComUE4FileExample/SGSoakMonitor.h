@@ -0,0 +1,103 @@
+// Records soak test metrics and drives scripted utterance arrivals
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+#include "Math/RandomStream.h"
+
+class FJsonValue;
+
+// Counters owned by the session that are sampled into the report
+struct FSGSoakCounters
+{
+    int32 NumQueuedFiles = 0;
+    int32 NumDiscoveredFiles = 0;
+    int32 NumUtterances = 0;
+    int32 NumUnderruns = 0;
+    int64 AudioPoolBytes = 0;
+
+    // Animation cost since the start, reported per sample interval
+    bool bBakedAnimation = false;
+    int64 NumPlayerUpdates = 0;
+    double PlayerUpdateSec = 0.0;
+    int64 NumAvatarFrames = 0;
+    double AvatarApplySec = 0.0;
+
+    // Audio the voice activity gate kept from the engine since the start
+    double VadSkippedMs = 0.0;
+    double VadCpuSavedMs = 0.0;
+};
+
+class SGCOMUE4FILEEXAMPLE_API FSGSoakMonitor
+{
+public:
+    // Start recording, writing the report to ReportPath every IntervalSec
+    void Start(const FString& InReportPath, double InIntervalSec);
+
+    // Copy SourceFile into TargetDirectory every IntervalSec on average. The
+    // jitter is drawn from a seeded stream so runs are reproducible.
+    void SetArrivalScript(const FString& InSourceFile, const FString& InTargetDirectory, double InIntervalSec, int32 Seed);
+
+    bool IsRunning() const;
+
+    // Record the duration of a game tick, called on the game thread
+    void RecordGameTick(double Seconds);
+
+    // Record the duration of an engine tick, called on the processing thread
+    void RecordProcessTick(double Seconds);
+
+    // Drive the arrivals and sample the counters when due, called on the game thread
+    void Update(TFunctionRef<FSGSoakCounters()> GetCounters);
+
+    // Write the final report
+    void Stop(const FSGSoakCounters& Counters);
+
+    // Add the average animation cost per frame of an avatar, with the rig
+    // logic running and bypassed, to the report
+    void RecordAnimationBenchmark(bool bBakedAnimation, int32 NumFrames, double RigLogicUs, double BypassedUs);
+
+private:
+    // Duration statistics over one sample interval
+    struct FDurationStats
+    {
+        int64 Count = 0;
+        double TotalMs = 0.0;
+        double MaxMs = 0.0;
+
+        void Add(double Ms);
+    };
+
+    // Take a sample and rewrite the report
+    void Sample(const FSGSoakCounters& Counters);
+
+    // Number of threads created through the engine
+    static int32 CountThreads();
+
+    bool bRunning = false;
+    FString ReportPath;
+    double IntervalSec = 10.0;
+    double StartTime = 0.0;
+    double NextSampleTime = 0.0;
+    uint64 StartUsedPhysical = 0;
+
+    // Counters of the previous sample, to report the animation cost per interval
+    FSGSoakCounters LastCounters;
+
+    FCriticalSection Lock;
+    FDurationStats GameTicks;
+    FDurationStats ProcessTicks;
+
+    // The report is rewritten with all samples every interval
+    TArray<TSharedPtr<FJsonValue>> Samples;
+    TArray<TSharedPtr<FJsonValue>> AnimationBenchmarks;
+
+    // Scripted arrivals
+    FString SourceFile;
+    FString TargetDirectory;
+    double ArrivalIntervalSec = 0.0;
+    double NextArrivalTime = 0.0;
+    int32 NumArrivals = 0;
+    FRandomStream ArrivalStream;
+};
@@ -0,0 +1,75 @@
+#include "SGTickWatchdog.h"
+
+#include "SGBufferController.h"
+
+// ========================================================
+// Set the deadline and the number of misses tolerated
+// ========================================================
+void FSGTickWatchdog::Configure(double InDeadlineFactor, int32 InMaxMisses)
+{
+    DeadlineFactor = FMath::Max(1.0, InDeadlineFactor);
+    MaxMisses = FMath::Max(1, InMaxMisses);
+    Reset();
+}
+
+// ========================================================
+// Forget the ticks seen so far
+// ========================================================
+void FSGTickWatchdog::Reset()
+{
+    TickStartCycles = 0;
+    TickDeadlineCycles = 0;
+    ConsecutiveMisses.Reset();
+    ConsecutiveErrors.Reset();
+}
+
+// ========================================================
+// Start timing a tick
+// ========================================================
+void FSGTickWatchdog::BeginTick()
+{
+    const double DeadlineSec = FSGBufferController::FrameMs / 1000.0 * DeadlineFactor;
+    TickDeadlineCycles = (uint64)(DeadlineSec / FPlatformTime::GetSecondsPerCycle64());
+    TickStartCycles = FPlatformTime::Cycles64();
+}
+
+// ========================================================
+// Finish timing a tick
+// ========================================================
+void FSGTickWatchdog::EndTick(SG_COM_Error Error)
+{
+    const uint64 ElapsedCycles = FPlatformTime::Cycles64() - TickStartCycles;
+    TickStartCycles = 0;
+
+    if (ElapsedCycles > TickDeadlineCycles) {
+        ConsecutiveMisses.Increment();
+    }
+    else {
+        ConsecutiveMisses.Reset();
+    }
+
+    // Running out of input is expected between utterances
+    if (Error != SG_COM_Error::SG_COM_ERROR_OK && Error != SG_COM_Error::SG_COM_ERROR_INPUT_UNDERRUN) {
+        ConsecutiveErrors.Increment();
+    }
+    else {
+        ConsecutiveErrors.Reset();
+    }
+}
+
+// ========================================================
+// Check if the engine should be replaced
+// ========================================================
+bool FSGTickWatchdog::ShouldFailOver() const
+{
+    return ConsecutiveMisses.GetValue() >= MaxMisses || ConsecutiveErrors.GetValue() >= MaxMisses || IsStalled();
+}
+
+// ========================================================
+// Check if a tick has been running for too long
+// ========================================================
+bool FSGTickWatchdog::IsStalled() const
+{
+    const uint64 StartCycles = TickStartCycles;
+    return StartCycles != 0 && FPlatformTime::Cycles64() - StartCycles > TickDeadlineCycles * MaxMisses;
+}
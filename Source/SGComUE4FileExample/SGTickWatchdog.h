@@ -0,0 +1,42 @@
+// Watches the engine ticks for stalls, missed deadlines and repeated errors
+
+#pragma once
+
+#include "SG_Com.h"
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGTickWatchdog
+{
+public:
+    // A tick misses its deadline when it takes longer than DeadlineFactor
+    // times the one 10 ms frame a tick processes. The engine is failed
+    // after MaxMisses deadlines missed or errors in a row, or when a tick
+    // is still running after MaxMisses deadlines.
+    void Configure(double InDeadlineFactor, int32 InMaxMisses);
+
+    // Forget the ticks seen so far, for a new engine
+    void Reset();
+
+    // Called by the processing thread around every tick
+    void BeginTick();
+    void EndTick(SG_COM_Error Error);
+
+    // Check if the engine should be replaced, called on the game thread
+    bool ShouldFailOver() const;
+
+    // Check if a tick has been running for longer than MaxMisses deadlines
+    bool IsStalled() const;
+
+private:
+    double DeadlineFactor = 4.0;
+    int32 MaxMisses = 3;
+
+    // Start and deadline of the tick in progress, 0 when none
+    TAtomic<uint64> TickStartCycles{ 0 };
+    TAtomic<uint64> TickDeadlineCycles{ 0 };
+
+    FThreadSafeCounter ConsecutiveMisses;
+    FThreadSafeCounter ConsecutiveErrors;
+};
@@ -0,0 +1,109 @@
+#include "SGVoiceActivity.h"
+
+#include "SGBufferController.h"
+
+#include "Math/VectorRegister.h"
+
+// ========================================================
+// Set the engine input format and the speech threshold
+// ========================================================
+void FSGVoiceActivity::Configure(SG_AudioSampleType InSampleType, int32 InSampleRate, double ThresholdDb)
+{
+    SampleType = InSampleType;
+    FrameSamples = FMath::Max(4, (int32)(InSampleRate * FSGBufferController::FrameMs / 1000.0));
+
+    SpeechEnergy = (float)FMath::Pow(10.0, ThresholdDb / 10.0);
+    UnvoicedEnergy = (float)FMath::Pow(10.0, (ThresholdDb - UnvoicedRangeDb) / 10.0);
+    UnvoicedCrossings = (int32)(UnvoicedCrossingsPerSec * FrameSamples / InSampleRate);
+    Reset();
+}
+
+void FSGVoiceActivity::Reset()
+{
+    LastSample = 0.f;
+}
+
+// ========================================================
+// Check if every frame of a block is silent
+// ========================================================
+bool FSGVoiceActivity::IsSilent(TArrayView<const uint8> Data)
+{
+    // Convert to float, with the last sample of the previous block first
+    const int32 BytesPerSample = SampleType == SG_AUDIO_INT_16 ? 2 : 4;
+    const int32 NumSamples = Data.Num() / BytesPerSample;
+    if (NumSamples == 0) {
+        return true;
+    }
+
+    Samples.SetNumUninitialized(NumSamples + 1, false);
+    Samples[0] = LastSample;
+    float* Out = Samples.GetData() + 1;
+    switch (SampleType) {
+        case SG_AUDIO_INT_16: {
+            const int16* In = (const int16*)Data.GetData();
+            for (int32 i = 0; i < NumSamples; ++i) {
+                Out[i] = In[i] * (1.f / 32768.f);
+            }
+            break;
+        }
+        case SG_AUDIO_INT_32: {
+            const int32* In = (const int32*)Data.GetData();
+            for (int32 i = 0; i < NumSamples; ++i) {
+                Out[i] = In[i] * (1.f / 2147483648.f);
+            }
+            break;
+        }
+        default:
+            FMemory::Memcpy(Out, Data.GetData(), NumSamples * sizeof(float));
+            break;
+    }
+    LastSample = Out[NumSamples - 1];
+
+    for (int32 Start = 0; Start < NumSamples; Start += FrameSamples) {
+        const int32 Num = FMath::Min(FrameSamples, NumSamples - Start);
+
+        float Energy = 0.f;
+        int32 Crossings = 0;
+        MeasureFrame(Out + Start, Num, Energy, Crossings);
+
+        if (Energy >= SpeechEnergy || (Energy >= UnvoicedEnergy && Crossings * FrameSamples >= UnvoicedCrossings * Num)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ========================================================
+// Mean square and zero crossings of a frame
+// ========================================================
+void FSGVoiceActivity::MeasureFrame(const float* Samples, int32 NumSamples, float& OutEnergy, int32& OutCrossings)
+{
+    const VectorRegister Zero = VectorZero();
+    const VectorRegister One = VectorOne();
+    VectorRegister SumSquares = Zero;
+    VectorRegister SumCrossings = Zero;
+
+    // Four samples at a time, a sign change makes the product with the previous sample negative
+    const int32 NumVectorSamples = NumSamples & ~3;
+    for (int32 i = 0; i < NumVectorSamples; i += 4) {
+        const VectorRegister Current = VectorLoad(Samples + i);
+        const VectorRegister Previous = VectorLoad(Samples + i - 1);
+        SumSquares = VectorMultiplyAdd(Current, Current, SumSquares);
+        SumCrossings = VectorAdd(SumCrossings, VectorBitwiseAnd(VectorCompareGT(Zero, VectorMultiply(Current, Previous)), One));
+    }
+
+    MS_ALIGN(16) float Squares[4] GCC_ALIGN(16);
+    MS_ALIGN(16) float Crossings[4] GCC_ALIGN(16);
+    VectorStoreAligned(SumSquares, Squares);
+    VectorStoreAligned(SumCrossings, Crossings);
+    float Energy = Squares[0] + Squares[1] + Squares[2] + Squares[3];
+    int32 NumCrossings = (int32)(Crossings[0] + Crossings[1] + Crossings[2] + Crossings[3]);
+
+    for (int32 i = NumVectorSamples; i < NumSamples; ++i) {
+        Energy += Samples[i] * Samples[i];
+        NumCrossings += Samples[i] * Samples[i - 1] < 0.f ? 1 : 0;
+    }
+
+    OutEnergy = Energy / NumSamples;
+    OutCrossings = NumCrossings;
+}
@@ -0,0 +1,42 @@
+// Classifies blocks of engine input audio as speech or silence from the
+// energy and zero-crossing rate of their frames
+
+#pragma once
+
+#include "SG.h"
+
+#include "CoreMinimal.h"
+
+class SGCOMUE4FILEEXAMPLE_API FSGVoiceActivity
+{
+public:
+    // Set the engine input format and the speech energy threshold (dBFS)
+    void Configure(SG_AudioSampleType InSampleType, int32 InSampleRate, double ThresholdDb);
+
+    // Forget the previous block, at the start of an utterance
+    void Reset();
+
+    // Check if every frame of a block is silent. Frames below the threshold
+    // still count as speech when they are within UnvoicedRangeDb of it and
+    // cross zero often enough to be an unvoiced consonant.
+    bool IsSilent(TArrayView<const uint8> Data);
+
+private:
+    // Mean square and zero crossings of NumSamples samples, Samples[-1] must be valid
+    static void MeasureFrame(const float* Samples, int32 NumSamples, float& OutEnergy, int32& OutCrossings);
+
+    static constexpr double UnvoicedRangeDb = 20.0;
+    static constexpr double UnvoicedCrossingsPerSec = 5000.0;
+
+    SG_AudioSampleType SampleType = SG_AUDIO_INT_16;
+    int32 FrameSamples = 160;
+
+    // Mean square thresholds of speech and unvoiced speech
+    float SpeechEnergy = 0.f;
+    float UnvoicedEnergy = 0.f;
+    int32 UnvoicedCrossings = 0;
+
+    // Block converted to float, after the last sample of the previous block
+    TArray<float> Samples;
+    float LastSample = 0.f;
+};
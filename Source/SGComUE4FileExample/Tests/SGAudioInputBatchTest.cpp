@@ -0,0 +1,108 @@
+#include "SGComManager.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSGAudioInputBatchTest, "SGCom.AudioInput.Batch", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Engine handles the feeds are registered for, never passed to SG_Com
+static SG_COM_EngineHandle FakeEngine(UPTRINT Id)
+{
+    return reinterpret_cast<SG_COM_EngineHandle>(Id);
+}
+
+// Take the queued blocks of a feed back as one buffer, checking every block
+// but the last is full
+static TArray<uint8> TakeQueued(FSGEngineFeed& Feed, FSGAudioBufferPool& Pool, int32& OutNumBlocks, bool& bOutFull)
+{
+    TArray<uint8> Data;
+    OutNumBlocks = 0;
+    bOutFull = true;
+    bool bShort = false;
+    while (FSGAudioBlock* Block = Feed.Dequeue()) {
+        bOutFull &= !bShort;
+        bShort = Block->Data.Num() < Block->Capacity;
+        Data.Append(Block->Data);
+        OutNumBlocks++;
+        Pool.Release(Block);
+    }
+    return Data;
+}
+
+// ========================================================
+// Queue multi-span audio for several Engines in one call
+// ========================================================
+bool FSGAudioInputBatchTest::RunTest(const FString& Parameters)
+{
+    const int32 BlockBytes = 4;
+
+    FSGAudioBufferPool Pool;
+    Pool.Configure(BlockBytes, 64 * BlockBytes);
+
+    // Room for a single block, to run out part way
+    FSGAudioBufferPool SmallPool;
+    SmallPool.Configure(BlockBytes, BlockBytes);
+
+    FSGEngineFeed FeedA(FakeEngine(0x1000), Pool, 1024);
+    FSGEngineFeed FeedB(FakeEngine(0x2000), Pool, 1024);
+    FSGEngineFeed FeedC(FakeEngine(0x3000), SmallPool, 1024);
+    FSGComManager::RegisterEngineFeed(&FeedA);
+    FSGComManager::RegisterEngineFeed(&FeedB);
+    FSGComManager::RegisterEngineFeed(&FeedC);
+
+    const TArray<uint8> A0 = { 1, 2, 3 };
+    const TArray<uint8> A1 = { 4, 5, 6, 7, 8 };
+    const TArray<uint8> A2 = { 9 };
+    const TArray<uint8> B0 = { 20, 21, 22, 23, 24, 25, 26, 27, 28 };
+    const TArray<uint8> B1;
+    const TArray<uint8> B2 = { 29, 30 };
+    const TArray<uint8> C0 = { 40, 41, 42, 43, 44, 45 };
+
+    TArray<FSGAudioInputBatch> Batches;
+    Batches.AddDefaulted(4);
+    Batches[0].Engine = FeedA.GetEngine();
+    Batches[0].Spans = { A0, A1, A2 };
+    Batches[1].Engine = FeedB.GetEngine();
+    Batches[1].Spans = { B0, B1, B2 };
+    Batches[2].Engine = FakeEngine(0x4000);
+    Batches[2].Spans = { A0 };
+    Batches[3].Engine = FeedC.GetEngine();
+    Batches[3].Spans = { C0 };
+
+    TArray<SG_COM_Error> Results;
+    const bool bAllQueued = FSGComManager::InputAudioBatch(Batches, Results);
+
+    FSGComManager::UnregisterEngineFeed(&FeedA);
+    FSGComManager::UnregisterEngineFeed(&FeedB);
+    FSGComManager::UnregisterEngineFeed(&FeedC);
+
+    TestFalse(TEXT("A batch with failures returns false"), bAllQueued);
+    if (!TestEqual(TEXT("One result per batch"), Results.Num(), Batches.Num())) {
+        return false;
+    }
+    TestEqual(TEXT("Engine A queued"), (int32)Results[0], (int32)SG_COM_Error::SG_COM_ERROR_OK);
+    TestEqual(TEXT("Engine B queued"), (int32)Results[1], (int32)SG_COM_Error::SG_COM_ERROR_OK);
+    TestEqual(TEXT("Unregistered engine rejected"), (int32)Results[2], (int32)SG_COM_Error::SG_COM_ERROR_INVALID_HANDLE);
+    TestEqual(TEXT("Engine C out of pool budget"), (int32)Results[3], (int32)SG_COM_Error::SG_COM_ERROR_LOW_MEMORY);
+
+    // The spans of an Engine are packed into full blocks in order
+    int32 NumBlocks = 0;
+    bool bFull = false;
+    TestEqual(TEXT("Engine A pending bytes"), FeedA.GetPendingBytes(), (int64)9);
+    TestTrue(TEXT("Engine A audio"), TakeQueued(FeedA, Pool, NumBlocks, bFull) == TArray<uint8>({ 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+    TestEqual(TEXT("Engine A blocks"), NumBlocks, 3);
+    TestTrue(TEXT("Engine A blocks packed"), bFull);
+
+    TestTrue(TEXT("Engine B audio"), TakeQueued(FeedB, Pool, NumBlocks, bFull) == TArray<uint8>({ 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30 }));
+    TestEqual(TEXT("Engine B blocks"), NumBlocks, 3);
+    TestTrue(TEXT("Engine B blocks packed"), bFull);
+
+    TestTrue(TEXT("Engine C audio"), TakeQueued(FeedC, SmallPool, NumBlocks, bFull) == TArray<uint8>({ 40, 41, 42, 43 }));
+    TestEqual(TEXT("Engine C pending bytes"), FeedC.GetPendingBytes(), (int64)0);
+
+    TestEqual(TEXT("All blocks returned"), Pool.GetInUseBytes() + SmallPool.GetInUseBytes(), (int64)0);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
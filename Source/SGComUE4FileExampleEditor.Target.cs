@@ -9,6 +9,6 @@ public class SGComUE4FileExampleEditorTarget : TargetRules
     {
         Type = TargetType.Editor;
         DefaultBuildSettings = BuildSettingsVersion.V2;
-        ExtraModuleNames.AddRange( new string[] { "SGComUE4FileExample" } );
+        ExtraModuleNames.AddRange( new string[] { "SGComUE4FileExample", "SGComUE4FileExampleEditor" } );
     }
 }
@@ -0,0 +1,20 @@
+#include "AnimGraphNode_SGFace.h"
+
+#define LOCTEXT_NAMESPACE "SGComUE4FileExampleEditor"
+
+FText UAnimGraphNode_SGFace::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+    return LOCTEXT("SGFaceTitle", "SG Face");
+}
+
+FText UAnimGraphNode_SGFace::GetTooltipText() const
+{
+    return LOCTEXT("SGFaceTooltip", "Applies the SG animation data of a Player on top of the input pose");
+}
+
+FString UAnimGraphNode_SGFace::GetNodeCategory() const
+{
+    return TEXT("SG_Com");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,25 @@
+// Editor node of the SG Face AnimGraph node
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_SGFace.h"
+#include "AnimGraphNode_SGFace.generated.h"
+
+UCLASS()
+class SGCOMUE4FILEEXAMPLEEDITOR_API UAnimGraphNode_SGFace : public UAnimGraphNode_Base
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(EditAnywhere, Category = Settings)
+    FAnimNode_SGFace Node;
+
+    // UEdGraphNode interface
+    virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+    virtual FText GetTooltipText() const override;
+
+    // UAnimGraphNode_Base interface
+    virtual FString GetNodeCategory() const override;
+};
@@ -0,0 +1,16 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class SGComUE4FileExampleEditor : ModuleRules
+{
+    public SGComUE4FileExampleEditor(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        // The AnimGraph node header includes the anim node, which uses SG_Com types
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "AnimGraph", "BlueprintGraph", "SGComUE4FileExample", "SG_Com" });
+
+        PrivateDependencyModuleNames.AddRange(new string[] { "UnrealEd" });
+    }
+}